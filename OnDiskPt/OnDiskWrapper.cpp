@@ -25,6 +25,7 @@
 #include "OnDiskWrapper.h"
 #include "moses/Factor.h"
 #include "util/exception.hh"
+#include "util/file.hh"
 
 using namespace std;
 
@@ -34,6 +35,7 @@ namespace OnDiskPt
 int OnDiskWrapper::VERSION_NUM = 5;
 
 OnDiskWrapper::OnDiskWrapper()
+  :m_rootSourceNode(NULL)
 {
 }
 
@@ -51,26 +53,19 @@ void OnDiskWrapper::BeginLoad(const std::string &filePath)
   if (!m_vocab.Load(*this))
     UTIL_THROW(util::FileOpenException, "Couldn't load vocab");
 
+  // everything else is read from the mappings
+  m_fileVocab.close();
+  m_fileMisc.close();
+
   UINT64 rootFilePos = GetMisc("RootNodeOffset");
   m_rootSourceNode = new PhraseNode(rootFilePos, *this);
 }
 
 bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
 {
-  m_fileSource.open((filePath + "/Source.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileSource.is_open(),
-		  util::FileOpenException,
-		  "Couldn't open file " << filePath << "/Source.dat");
-
-  m_fileTargetInd.open((filePath + "/TargetInd.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetInd.is_open(),
-		  util::FileOpenException,
-		  "Couldn't open file " << filePath << "/TargetInd.dat");
-
-  m_fileTargetColl.open((filePath + "/TargetColl.dat").c_str(), ios::in | ios::binary);
-  UTIL_THROW_IF(!m_fileTargetColl.is_open(),
-		  util::FileOpenException,
-		  "Couldn't open file " << filePath << "/TargetColl.dat");
+  MapForLoad(filePath + "/Source.dat", m_mapSource);
+  MapForLoad(filePath + "/TargetInd.dat", m_mapTargetInd);
+  MapForLoad(filePath + "/TargetColl.dat", m_mapTargetColl);
 
   m_fileVocab.open((filePath + "/Vocab.dat").c_str(), ios::in);
   UTIL_THROW_IF(!m_fileVocab.is_open(),
@@ -91,6 +86,13 @@ bool OnDiskWrapper::OpenForLoad(const std::string &filePath)
   return true;
 }
 
+void OnDiskWrapper::MapForLoad(const std::string &path, util::scoped_memory &to)
+{
+  // the mapping stays valid after the file is closed
+  util::scoped_fd file(util::OpenReadOrThrow(path.c_str()));
+  util::MapRead(util::LAZY, file.get(), 0, util::SizeOrThrow(file.get()), to);
+}
+
 bool OnDiskWrapper::LoadMisc()
 {
   char line[100000];
@@ -20,6 +20,7 @@
  ***********************************************************************/
 #include <string>
 #include <fstream>
+#include "util/mmap.hh"
 #include "Vocab.h"
 #include "PhraseNode.h"
 #include "moses/Word.h"
@@ -31,6 +32,10 @@ const float DEFAULT_COUNT = 66666;
 /** Global class with misc information need to create and use the on-disk rule table.
  * 1 object of this class should be instantiated per rule table.
  * Currently only hierarchical/syntax models use this, but can & should be used with pb models too
+ *
+ * For loading, the source tree and target phrase files are memory mapped
+ * and nodes and phrases are decoded straight from the mapping, so one
+ * loaded object can be shared by all threads.
  */
 class OnDiskWrapper
 {
@@ -39,6 +44,7 @@ protected:
   std::string m_filePath;
   int m_numSourceFactors, m_numTargetFactors, m_numScores;
   std::fstream m_fileMisc, m_fileVocab, m_fileSource, m_fileTarget, m_fileTargetInd, m_fileTargetColl;
+  util::scoped_memory m_mapSource, m_mapTargetInd, m_mapTargetColl;
 
   size_t m_defaultNodeSize;
   PhraseNode *m_rootSourceNode;
@@ -48,6 +54,7 @@ protected:
   void SaveMisc();
   bool OpenForLoad(const std::string &filePath);
   bool LoadMisc();
+  static void MapForLoad(const std::string &path, util::scoped_memory &to);
 
 public:
   static int VERSION_NUM;
@@ -82,6 +89,17 @@ public:
     return m_fileVocab;
   }
 
+  //! start of the mapped files, only after BeginLoad()
+  const char *GetSourceData() const {
+    return static_cast<const char*>(m_mapSource.get());
+  }
+  const char *GetTargetIndData() const {
+    return static_cast<const char*>(m_mapTargetInd.get());
+  }
+  const char *GetTargetCollData() const {
+    return static_cast<const char*>(m_mapTargetColl.get());
+  }
+
   size_t GetNumSourceFactors() const {
     return m_numSourceFactors;
   }
@@ -47,20 +47,20 @@ protected:
 
   TargetPhraseCollection m_targetPhraseColl;
 
-  char *m_memLoad, *m_memLoadLast;
+  const char *m_memLoad, *m_memLoadLast; /**< loaded node, points into the mapped source file */
   UINT64 m_numChildrenLoad;
 
   void AddTargetPhrase(size_t pos, const SourcePhrase &sourcePhrase
                        , TargetPhrase *targetPhrase, OnDiskWrapper &onDiskWrapper
                        , size_t tableLimit, const std::vector<float> &counts, OnDiskPt::PhrasePtr spShort);
   size_t ReadChild(Word &wordFound, UINT64 &childFilePos, const char *mem) const;
-  void GetChild(Word &wordFound, UINT64 &childFilePos, size_t ind, OnDiskWrapper &onDiskWrapper) const;
+  void GetChild(Word &wordFound, UINT64 &childFilePos, size_t ind, const OnDiskWrapper &onDiskWrapper) const;
 
 public:
   static size_t GetNodeSize(size_t numChildren, size_t wordSize, size_t countSize);
 
   PhraseNode(); // unsaved node
-  PhraseNode(UINT64 filePos, OnDiskWrapper &onDiskWrapper); // load saved node
+  PhraseNode(UINT64 filePos, const OnDiskWrapper &onDiskWrapper); // load saved node
   ~PhraseNode();
 
   void Add(const Word &word, UINT64 nextFilePos, size_t wordSize);
@@ -91,8 +91,8 @@ public:
     m_pos = pos;
   }
 
-  const PhraseNode *GetChild(const Word &wordSought, OnDiskWrapper &onDiskWrapper) const;
-  const TargetPhraseCollection *GetTargetPhraseCollection(size_t tableLimit, OnDiskWrapper &onDiskWrapper) const;
+  const PhraseNode *GetChild(const Word &wordSought, const OnDiskWrapper &onDiskWrapper) const;
+  const TargetPhraseCollection *GetTargetPhraseCollection(size_t tableLimit, const OnDiskWrapper &onDiskWrapper) const;
 
   void AddCounts(const std::vector<float> &counts) {
     m_counts = counts;
@@ -57,8 +57,8 @@ protected:
   size_t WriteAlignToMemory(char *mem) const;
   size_t WriteScoresToMemory(char *mem) const;
 
-  UINT64 ReadAlignFromFile(std::fstream &fileTPColl);
-  UINT64 ReadScoresFromFile(std::fstream &fileTPColl);
+  UINT64 ReadAlignFromMemory(const char *mem);
+  UINT64 ReadScoresFromMemory(const char *mem);
 
 public:
   TargetPhrase() {
@@ -105,8 +105,8 @@ public:
                                       , const Moses::PhraseDictionary &phraseDict
                                       , const std::vector<float> &weightT
                                       , bool isSyntax) const;
-  UINT64 ReadOtherInfoFromFile(UINT64 filePos, std::fstream &fileTPColl);
-  UINT64 ReadFromFile(std::fstream &fileTP);
+  UINT64 ReadOtherInfoFromMemory(const char *mem);
+  UINT64 ReadFromMemory(const char *mem);
 
   virtual void DebugPrint(std::ostream &out, const Vocab &vocab) const;
 
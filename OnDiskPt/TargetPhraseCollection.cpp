@@ -19,6 +19,7 @@
  ***********************************************************************/
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "moses/Util.h"
 #include "moses/TargetPhraseCollection.h"
@@ -147,10 +148,10 @@ Moses::TargetPhraseCollection *TargetPhraseCollection::ConvertToMoses(const std:
 
 }
 
-void TargetPhraseCollection::ReadFromFile(size_t tableLimit, UINT64 filePos, OnDiskWrapper &onDiskWrapper)
+void TargetPhraseCollection::ReadFromFile(size_t tableLimit, UINT64 filePos, const OnDiskWrapper &onDiskWrapper)
 {
-  fstream &fileTPColl = onDiskWrapper.GetFileTargetColl();
-  fstream &fileTP = onDiskWrapper.GetFileTargetInd();
+  const char *memTPColl = onDiskWrapper.GetTargetCollData();
+  const char *memTP = onDiskWrapper.GetTargetIndData();
 
   size_t numScores = onDiskWrapper.GetNumScores();
 
@@ -158,8 +159,7 @@ void TargetPhraseCollection::ReadFromFile(size_t tableLimit, UINT64 filePos, OnD
   UINT64 numPhrases;
 
   UINT64 currFilePos = filePos;
-  fileTPColl.seekg(filePos);
-  fileTPColl.read((char*) &numPhrases, sizeof(UINT64));
+  memcpy(&numPhrases, memTPColl + filePos, sizeof(UINT64));
 
   // table limit
   if (tableLimit) {
@@ -171,8 +171,8 @@ void TargetPhraseCollection::ReadFromFile(size_t tableLimit, UINT64 filePos, OnD
   for (size_t ind = 0; ind < numPhrases; ++ind) {
     TargetPhrase *tp = new TargetPhrase(numScores);
 
-    UINT64 sizeOtherInfo = tp->ReadOtherInfoFromFile(currFilePos, fileTPColl);
-    tp->ReadFromFile(fileTP);
+    UINT64 sizeOtherInfo = tp->ReadOtherInfoFromMemory(memTPColl + currFilePos);
+    tp->ReadFromMemory(memTP + tp->GetFilePos());
 
     currFilePos += sizeOtherInfo;
 
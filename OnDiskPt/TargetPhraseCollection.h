@@ -75,7 +75,7 @@ public:
       , const std::vector<float> &weightT
       , Vocab &vocab
       , bool isSyntax) const;
-  void ReadFromFile(size_t tableLimit, UINT64 filePos, OnDiskWrapper &onDiskWrapper);
+  void ReadFromFile(size_t tableLimit, UINT64 filePos, const OnDiskWrapper &onDiskWrapper);
 
   const std::string GetDebugStr() const;
   void SetDebugStr(const std::string &str);
@@ -18,6 +18,7 @@
  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  ***********************************************************************/
 
+#include <cstring>
 #include "moses/FactorCollection.h"
 #include "moses/Util.h"
 #include "moses/Word.h"
@@ -70,8 +71,9 @@ size_t Word::WriteToMemory(char *mem) const
 
 size_t Word::ReadFromMemory(const char *mem)
 {
-  UINT64 *vocabMem = (UINT64*) mem;
-  m_vocabId = vocabMem[0];
+  UINT64 vocabId;
+  memcpy(&vocabId, mem, sizeof(UINT64));
+  m_vocabId = vocabId;
 
   size_t memUsed = sizeof(UINT64);
 
@@ -84,18 +86,6 @@ size_t Word::ReadFromMemory(const char *mem)
   return memUsed;
 }
 
-size_t Word::ReadFromFile(std::fstream &file)
-{
-  const size_t memAlloc = sizeof(UINT64) + sizeof(char);
-  char mem[sizeof(UINT64) + sizeof(char)];
-  file.read(mem, memAlloc);
-
-  size_t memUsed = ReadFromMemory(mem);
-  assert(memAlloc == memUsed);
-
-  return memAlloc;
-}
-
 void Word::ConvertToMoses(
   const std::vector<Moses::FactorType> &outputFactorsVec,
   const Vocab &vocab,
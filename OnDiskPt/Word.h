@@ -65,7 +65,6 @@ public:
 
   size_t WriteToMemory(char *mem) const;
   size_t ReadFromMemory(const char *mem);
-  size_t ReadFromFile(std::fstream &file);
 
   void SetVocabId(UINT32 vocabId) {
     m_vocabId = vocabId;
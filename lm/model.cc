@@ -166,6 +166,36 @@ template <class Search, class VocabularyT> FullScoreReturn GenericModel<Search,
   return ret;
 }
 
+template <class Search, class VocabularyT> float GenericModel<Search, VocabularyT>::ScoreSequence(const State &in_state, const WordIndex *words_begin, const WordIndex *words_end, State &out_state) const {
+  assert(words_begin != words_end);
+  State aux_state;
+  // Alternate so that the last word is written to out_state.
+  State *state0 = ((words_end - words_begin) % 2) ? &out_state : &aux_state;
+  State *state1 = (state0 == &out_state) ? &aux_state : &out_state;
+  float ret = FullScore(in_state, *words_begin, *state0).prob;
+  for (const WordIndex *i = words_begin + 1; i != words_end; ++i) {
+    ret += FullScore(*state0, *i, *state1).prob;
+    std::swap(state0, state1);
+  }
+  return ret;
+}
+
+template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::Prefetch(const State &in_state, const WordIndex *words_begin, const WordIndex *words_end) const {
+  WordIndex context[KENLM_MAX_ORDER - 1];
+  const std::size_t max_context = P::Order() - 1;
+  for (const WordIndex *word = words_begin; word != words_end; ++word) {
+    // Reversed context: the earlier words of the sequence, then in_state.
+    std::size_t length = 0;
+    for (const WordIndex *i = word; i != words_begin && length < max_context; ++length) {
+      context[length] = *--i;
+    }
+    for (unsigned char i = 0; i < in_state.length && length < max_context; ++i, ++length) {
+      context[length] = in_state.words[i];
+    }
+    search_.Prefetch(*word, context, context + length);
+  }
+}
+
 template <class Search, class VocabularyT> void GenericModel<Search, VocabularyT>::GetState(const WordIndex *context_rbegin, const WordIndex *context_rend, State &out_state) const {
   // Generate a state from context.
   context_rend = std::min(context_rend, context_rbegin + P::Order() - 1);
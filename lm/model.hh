@@ -66,6 +66,42 @@ template <class Search, class VocabularyT> class GenericModel : public base::Mod
      */
     FullScoreReturn FullScoreForgotState(const WordIndex *context_rbegin, const WordIndex *context_rend, const WordIndex new_word, State &out_state) const;
 
+    /* Score the word sequence [words_begin, words_end) following in_state.
+     * Returns the sum of log10 probabilities and puts the state after the last
+     * word in out_state, which must not be in_state.  The sequence must not be
+     * empty.
+     */
+    float ScoreSequence(const State &in_state, const WordIndex *words_begin, const WordIndex *words_end, State &out_state) const;
+
+    /* Prefetch the entries that ScoreSequence(in_state, words_begin,
+     * words_end, ...) will look up.  The probing model fetches every order;
+     * the trie only the unigrams.
+     */
+    void Prefetch(const State &in_state, const WordIndex *words_begin, const WordIndex *words_end) const;
+
+    /* One query of ScoreBatch. */
+    struct SequenceQuery {
+      const State *in_state;
+      const WordIndex *words_begin, *words_end;
+      // Filled in by ScoreBatch.
+      State out_state;
+      float prob;
+    };
+
+    /* Score many independent queries.  All their entries are prefetched
+     * before the first is resolved, so the cache misses overlap instead of
+     * being taken one after another.  This pays off when the model is much
+     * larger than the cache.
+     */
+    void ScoreBatch(SequenceQuery *begin, SequenceQuery *end) const {
+      for (SequenceQuery *i = begin; i != end; ++i) {
+        Prefetch(*i->in_state, i->words_begin, i->words_end);
+      }
+      for (SequenceQuery *i = begin; i != end; ++i) {
+        i->prob = ScoreSequence(*i->in_state, i->words_begin, i->words_end, i->out_state);
+      }
+    }
+
     /* Get the state for a context.  Don't use this if you can avoid it.  Use
      * BeginSentenceState or NullContextState and extend from those.  If
      * you're only going to use this state to call FullScore once, use
@@ -278,6 +278,38 @@ template <class M> void Stateless(const M &model) {
   BOOST_CHECK_EQUAL(static_cast<WordIndex>(0), state.words[0]);
 }
 
+template <class M> void Batch(const M &model) {
+  const char *const sentence[] = {"looking", "on", "a", "little", "more", "loin"};
+  WordIndex words[6];
+  for (std::size_t i = 0; i < 6; ++i) {
+    words[i] = model.GetVocabulary().Index(sentence[i]);
+  }
+  State begin(model.BeginSentenceState()), null(model.NullContextState());
+
+  typename M::SequenceQuery queries[3];
+  queries[0].in_state = &begin;
+  queries[0].words_begin = words;
+  queries[0].words_end = words + 6;
+  queries[1].in_state = &null;
+  queries[1].words_begin = words + 2;
+  queries[1].words_end = words + 5;
+  queries[2].in_state = &begin;
+  queries[2].words_begin = words;
+  queries[2].words_end = words + 1;
+  model.ScoreBatch(queries, queries + 3);
+
+  for (std::size_t q = 0; q < 3; ++q) {
+    State state(*queries[q].in_state), out;
+    float expected = 0.0;
+    for (const WordIndex *i = queries[q].words_begin; i != queries[q].words_end; ++i) {
+      expected += model.FullScore(state, *i, out).prob;
+      state = out;
+    }
+    SLOPPY_CHECK_CLOSE(expected, queries[q].prob, 0.001);
+    BOOST_CHECK_EQUAL(state, queries[q].out_state);
+  }
+}
+
 template <class M> void NoUnkCheck(const M &model) {
   WordIndex unk_index = 0;
   State state;
@@ -294,6 +326,7 @@ template <class M> void Everything(const M &m) {
   MinimalState(m);
   ExtendLeftTest(m);
   Stateless(m);
+  Batch(m);
 }
 
 class ExpectEnumerateVocab : public EnumerateVocab {
@@ -8,6 +8,7 @@
 #include "lm/weights.hh"
 
 #include "util/bit_packing.hh"
+#include "util/prefetch.hh"
 #include "util/probing_hash_table.hh"
 
 #include <algorithm>
@@ -125,6 +126,22 @@ template <class Value> class HashedSearch {
       return LongestPointer(found->value.prob);
     }
 
+    // Prefetch every entry that scoring word after the reversed context
+    // [context_rbegin, context_rend) can probe.  The hashes only depend on
+    // the words, so they are all known up front.
+    void Prefetch(WordIndex word, const WordIndex *context_rbegin, const WordIndex *context_rend) const {
+      util::PrefetchRead(&unigram_.Lookup(word));
+      Node node = static_cast<Node>(word);
+      for (std::size_t order_minus_2 = 0; context_rbegin != context_rend; ++context_rbegin, ++order_minus_2) {
+        node = CombineWordHash(node, *context_rbegin);
+        if (order_minus_2 == middle_.size()) {
+          longest_.Prefetch(node);
+          return;
+        }
+        middle_[order_minus_2].Prefetch(node);
+      }
+    }
+
     // Generate a node without necessarily checking that it actually exists.
     // Optionally return false if it's know to not exist.
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
@@ -9,6 +9,7 @@
 
 #include "util/file.hh"
 #include "util/file_piece.hh"
+#include "util/prefetch.hh"
 
 #include <vector>
 #include <cstdlib>
@@ -89,6 +90,12 @@ template <class Quant, class Bhiksha> class TrieSearch {
       return LongestPointer(quant_, longest_.Find(word, node));
     }
 
+    // Only the unigram can be fetched ahead: higher orders are found by
+    // searching within the range the previous order points to.
+    void Prefetch(WordIndex word, const WordIndex * /*context_rbegin*/, const WordIndex * /*context_rend*/) const {
+      util::PrefetchRead(&unigram_.Lookup(word));
+    }
+
     bool FastMakeNode(const WordIndex *begin, const WordIndex *end, Node &node) const {
       assert(begin != end);
       bool independent_left;
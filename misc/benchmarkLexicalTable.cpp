@@ -0,0 +1,122 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "moses/Phrase.h"
+#include "moses/Timer.h"
+#include "moses/Util.h"
+#include "moses/InputFileStream.h"
+#include "moses/FF/LexicalReordering/LexicalReorderingTable.h"
+
+#ifdef HAVE_CMPH
+#include "moses/TranslationModel/CompactPT/LexicalReorderingTableCompact.h"
+#endif
+
+#include "util/usage.hh"
+
+using namespace Moses;
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "options: \n"
+            "\t-table   string -- table file name (prefix of the binary files)\n"
+            "\t-queries string -- text reordering table whose keys are looked up\n"
+            "\t-format  string -- memory, tree, mapped"
+#ifdef HAVE_CMPH
+            " or compact"
+#endif
+            "\n"
+            "\t-repeat  int    -- number of passes over the queries (default 1)\n"
+            "\n";
+}
+
+struct Query {
+  Query() : f(0), e(0), c(0) {}
+  Phrase f, e, c;
+};
+
+int main(int argc, char** argv)
+{
+  std::string tablePath, queryPath, format;
+  size_t repeat = 1;
+  for(int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if("-table" == arg && i+1 < argc) {
+      tablePath = argv[++i];
+    } else if("-queries" == arg && i+1 < argc) {
+      queryPath = argv[++i];
+    } else if("-format" == arg && i+1 < argc) {
+      format = argv[++i];
+    } else if("-repeat" == arg && i+1 < argc) {
+      repeat = Scan<size_t>(argv[++i]);
+    } else {
+      printHelp();
+      return 1;
+    }
+  }
+  if(tablePath.empty() || queryPath.empty() || format.empty()) {
+    printHelp();
+    return 1;
+  }
+
+  //read the keys of the text table, the number of fields gives the masks
+  std::vector<Query> queries;
+  FactorList masks[3];
+  InputFileStream in(queryPath);
+  std::string line;
+  while(getline(in, line)) {
+    std::vector<std::string> tokens = TokenizeMultiCharSeparator(line, "|||");
+    if(queries.empty()) {
+      for(size_t t = 0; t + 1 < tokens.size() && t < 3; ++t) {
+        masks[t].push_back(0);
+      }
+    }
+    queries.push_back(Query());
+    Phrase* fields[3] = {&queries.back().f, &queries.back().e, &queries.back().c};
+    for(size_t t = 0; t + 1 < tokens.size() && t < 3; ++t) {
+      fields[t]->CreateFromString(t == 0 ? Input : Output, masks[t], tokens[t], "|", NULL);
+    }
+  }
+  std::cerr << queries.size() << " queries\n";
+
+  Timer timer;
+  timer.start();
+  LexicalReorderingTable* table = NULL;
+  if("memory" == format) {
+    table = new LexicalReorderingTableMemory(tablePath, masks[0], masks[1], masks[2]);
+  } else if("tree" == format) {
+    table = new LexicalReorderingTableTree(tablePath, masks[0], masks[1], masks[2]);
+  } else if("mapped" == format) {
+    table = new LexicalReorderingTableMapped(tablePath, masks[0], masks[1], masks[2]);
+#ifdef HAVE_CMPH
+  } else if("compact" == format) {
+    table = LexicalReorderingTableCompact::CheckAndLoad(tablePath + ".minlexr", masks[0], masks[1], masks[2]);
+#endif
+  }
+  if(!table) {
+    std::cerr << "cannot load " << format << " table " << tablePath << "\n";
+    return 1;
+  }
+  const double loadTime = timer.get_elapsed_time();
+
+  size_t found = 0;
+  timer.start();
+  for(size_t r = 0; r < repeat; ++r) {
+    for(size_t i = 0; i < queries.size(); ++i) {
+      if(!table->GetScore(queries[i].f, queries[i].e, queries[i].c).empty()) {
+        ++found;
+      }
+    }
+  }
+  const double queryTime = timer.get_elapsed_time();
+
+  std::cout << "format\t" << format << "\n"
+            << "load seconds\t" << loadTime << "\n"
+            << "query seconds\t" << queryTime << "\n"
+            << "lookups per second\t" << (queryTime > 0 ? queries.size() * repeat / queryTime : 0) << "\n"
+            << "found\t" << found << " of " << queries.size() * repeat << "\n";
+  util::PrintUsage(std::cout);
+  delete table;
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <string>
+
+#include "moses/InputFileStream.h"
+#include "moses/GenerationDictionary.h"
+
+using namespace Moses;
+
+void printHelp()
+{
+  std::cerr << "Usage:\n"
+            "options: \n"
+            "\t-in  string -- input table file name\n"
+            "\t-out string -- prefix of the binary table, written to prefix.mgen\n"
+            "If -in is not specified reads from stdin\n"
+            "Load the table with a GenerationMapped feature whose path is the prefix\n"
+            "\n";
+}
+
+int main(int argc, char** argv)
+{
+  std::string inFilePath;
+  std::string outFilePath("out");
+  if(1 >= argc) {
+    printHelp();
+    return 1;
+  }
+  for(int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if("-in" == arg && i+1 < argc) {
+      ++i;
+      inFilePath = argv[i];
+    } else if("-out" == arg && i+1 < argc) {
+      ++i;
+      outFilePath = argv[i];
+    } else {
+      printHelp();
+      return 1;
+    }
+  }
+
+  bool success = false;
+  if(inFilePath.empty()) {
+    std::cerr << "processing stdin to " << outFilePath << ".mgen\n";
+    success = GenerationDictionaryMapped::Create(std::cin, outFilePath);
+  } else {
+    std::cerr << "processing " << inFilePath << " to " << outFilePath << ".mgen\n";
+    InputFileStream file(inFilePath);
+    success = GenerationDictionaryMapped::Create(file, outFilePath);
+  }
+
+  return (success ? 0 : 1);
+}
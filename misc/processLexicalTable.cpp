@@ -15,6 +15,7 @@ void printHelp()
             "options: \n"
             "\t-in  string -- input table file name\n"
             "\t-out string -- prefix of binary table files\n"
+            "\t-mapped     -- write a hashed, memory-mapped table (prefix.mlexr)\n"
             "If -in is not specified reads from stdin\n"
             "\n";
 }
@@ -24,6 +25,7 @@ int main(int argc, char** argv)
   std::cerr << "processLexicalTable v0.1 by Konrad Rawlik\n";
   std::string inFilePath;
   std::string outFilePath("out");
+  bool mapped = false;
   if(1 >= argc) {
     printHelp();
     return 1;
@@ -36,6 +38,8 @@ int main(int argc, char** argv)
     } else if("-out" == arg && i+1 < argc) {
       ++i;
       outFilePath = argv[i];
+    } else if("-mapped" == arg) {
+      mapped = true;
     } else {
       //somethings wrong... print help
       printHelp();
@@ -47,11 +51,13 @@ int main(int argc, char** argv)
 
   if(inFilePath.empty()) {
     std::cerr << "processing stdin to " << outFilePath << ".*\n";
-    success = LexicalReorderingTableTree::Create(std::cin, outFilePath);
+    success = mapped ? LexicalReorderingTableMapped::Create(std::cin, outFilePath)
+              : LexicalReorderingTableTree::Create(std::cin, outFilePath);
   } else {
     std::cerr << "processing " << inFilePath<< " to " << outFilePath << ".*\n";
     InputFileStream file(inFilePath);
-    success = LexicalReorderingTableTree::Create(file, outFilePath);
+    success = mapped ? LexicalReorderingTableMapped::Create(file, outFilePath)
+              : LexicalReorderingTableTree::Create(file, outFilePath);
   }
 
   return (success ? 0 : 1);
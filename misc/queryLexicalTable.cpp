@@ -91,7 +91,10 @@ int main(int argc, char** argv)
   f.CreateFromString(Input, f_mask, query_f, "|", NULL);
   c.CreateFromString(Input, c_mask,  query_c,"|", NULL);
   LexicalReorderingTable* table;
-  if(FileExists(inFilePath+".binlexr.idx")) {
+  if(FileExists(inFilePath+".mlexr")) {
+    std::cerr << "Loading mapped table...\n";
+    table = new LexicalReorderingTableMapped(inFilePath, f_mask, e_mask, c_mask);
+  } else if(FileExists(inFilePath+".binlexr.idx")) {
     std::cerr << "Loading binary table...\n";
     table = new LexicalReorderingTableTree(inFilePath, f_mask, e_mask, c_mask);
   } else {
@@ -73,14 +73,17 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
   ,m_detailedTreeFragmentsTranslationReportingStream(NULL)
   ,m_alignmentInfoStream(NULL)
   ,m_unknownsStream(NULL)
+  ,m_metricsStream(NULL)
   ,m_inputFilePath(inputFilePath)
   ,m_detailOutputCollector(NULL)
   ,m_detailTreeFragmentsOutputCollector(NULL)
+  ,m_detailAllOutputCollector(NULL)
   ,m_nBestOutputCollector(NULL)
   ,m_searchGraphOutputCollector(NULL)
   ,m_singleBestOutputCollector(NULL)
   ,m_alignmentInfoCollector(NULL)
   ,m_unknownsCollector(NULL)
+  ,m_metricsCollector(NULL)
 {
   const StaticData &staticData = StaticData::Instance();
 
@@ -142,6 +145,14 @@ IOWrapper::IOWrapper(const std::vector<FactorType>	&inputFactorOrder
                    "File for unknowns words could not be opened: " <<
                      staticData.GetOutputUnknownsFile());
   }
+
+  if (!staticData.GetSentenceMetricsFile().empty()) {
+    m_metricsStream = new std::ofstream(staticData.GetSentenceMetricsFile().c_str());
+    m_metricsCollector = new Moses::OutputCollector(m_metricsStream);
+    UTIL_THROW_IF2(!m_metricsStream->good(),
+                   "File for sentence metrics could not be opened: " <<
+                     staticData.GetSentenceMetricsFile());
+  }
 }
 
 IOWrapper::~IOWrapper()
@@ -154,12 +165,28 @@ IOWrapper::~IOWrapper()
   delete m_detailedTreeFragmentsTranslationReportingStream;
   delete m_alignmentInfoStream;
   delete m_unknownsStream;
+  delete m_metricsStream;
   delete m_detailOutputCollector;
   delete m_nBestOutputCollector;
   delete m_searchGraphOutputCollector;
   delete m_singleBestOutputCollector;
   delete m_alignmentInfoCollector;
   delete m_unknownsCollector;
+  delete m_metricsCollector;
+}
+
+void IOWrapper::GetOutputCollectors(std::vector<Moses::OutputCollector*> &collectors) const
+{
+  Moses::OutputCollector *all[] = {
+    m_singleBestOutputCollector, m_nBestOutputCollector, m_searchGraphOutputCollector,
+    m_detailOutputCollector, m_detailTreeFragmentsOutputCollector, m_detailAllOutputCollector,
+    m_alignmentInfoCollector, m_unknownsCollector, m_metricsCollector
+  };
+  for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); ++i) {
+    if (all[i]) {
+      collectors.push_back(all[i]);
+    }
+  }
 }
 
 void IOWrapper::ResetTranslationId()
@@ -1089,6 +1116,14 @@ void IOWrapper::OutputUnknowns(const std::vector<Moses::Phrase*> &unknowns,
   m_unknownsCollector->Write(translationId, out.str());
 }
 
+void IOWrapper::OutputSentenceMetrics(const SentenceStats &stats,
+                                      long translationId)
+{
+  std::ostringstream out;
+  stats.OutputMetrics(out, translationId);
+  m_metricsCollector->Write(translationId, out.str());
+}
+
 size_t IOWrapper::OutputAlignment(Alignments &retAlign, const Moses::ChartHypothesis *hypo, size_t startTarget)
 {
   size_t totalTargetSize = 0;
@@ -77,6 +77,7 @@ protected:
   std::ostream                          *m_detailedAllTranslationReportingStream;
   std::ostream                          *m_alignmentInfoStream;
   std::ostream                          *m_unknownsStream;
+  std::ostream                          *m_metricsStream;
   std::string		        								m_inputFilePath;
   std::istream					        				*m_inputStream;
   Moses::OutputCollector                *m_detailOutputCollector;
@@ -88,6 +89,7 @@ protected:
   Moses::OutputCollector                *m_singleBestOutputCollector;
   Moses::OutputCollector                *m_alignmentInfoCollector;
   Moses::OutputCollector                *m_unknownsCollector;
+  Moses::OutputCollector                *m_metricsCollector;
 
   typedef std::set< std::pair<size_t, size_t>  > Alignments;
   size_t OutputAlignmentNBest(Alignments &retAlign, const Moses::ChartTrellisNode &node, size_t startTarget);
@@ -146,8 +148,17 @@ public:
     return m_searchGraphOutputCollector;
   }
 
+  //! the collectors of all enabled output streams
+  void GetOutputCollectors(std::vector<Moses::OutputCollector*> &collectors) const;
+
+  //! the 1-best translations, or the n-best lists if they replace them on stdout
+  Moses::OutputCollector *GetTranslationOutputCollector() const {
+    return m_singleBestOutputCollector ? m_singleBestOutputCollector : m_nBestOutputCollector;
+  }
+
   void OutputAlignment(size_t translationId , const Moses::ChartHypothesis *hypo);
   void OutputUnknowns(const std::vector<Moses::Phrase*> &, long);
+  void OutputSentenceMetrics(const Moses::SentenceStats &, long);
 
   static void FixPrecision(std::ostream &, size_t size=3);
 };
@@ -61,6 +61,7 @@ POSSIBILITY OF SUCH DAMAGE.
 #include "moses/Incremental.h"
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/FF/StatelessFeatureFunction.h"
+#include "moses/TranslationModel/PhraseDictionary.h"
 
 #include "util/usage.hh"
 #include "util/exception.hh"
@@ -161,7 +162,9 @@ public:
     if (nBestSize > 0) {
       VERBOSE(2,"WRITING " << nBestSize << " TRANSLATION ALTERNATIVES TO " << staticData.GetNBestFilePath() << endl);
       std::vector<boost::shared_ptr<ChartKBestExtractor::Derivation> > nBestList;
+      manager.GetSentenceStats().StartTimeNBest();
       manager.CalcNBest(nBestSize, nBestList,staticData.GetDistinctNBest());
+      manager.GetSentenceStats().StopTimeNBest();
       m_ioWrapper.OutputNBestList(nBestList, translationId);
       IFVERBOSE(2) {
         PrintUserTime("N-Best Hypotheses Generation Time:");
@@ -176,6 +179,10 @@ public:
       oc->Write(translationId, out.str());
     }
 
+    if (!staticData.GetSentenceMetricsFile().empty()) {
+      m_ioWrapper.OutputSentenceMetrics(manager.GetSentenceStats(), translationId);
+    }
+
     IFVERBOSE(2) {
       PrintUserTime("Sentence Decoding Time:");
     }
@@ -294,19 +301,57 @@ int main(int argc, char* argv[])
     if (ioWrapper == NULL)
       return EXIT_FAILURE;
 
+    vector<OutputCollector*> collectors;
+    ioWrapper->GetOutputCollectors(collectors);
+    for (size_t i = 0; i < collectors.size(); ++i) {
+      collectors[i]->SetFirstSourceId(staticData.GetStartTranslationId());
+    }
+
 #ifdef WITH_THREADS
     ThreadPool pool(staticData.ThreadCount());
+    // the other streams can skip a sentence (incremental search writes no
+    // alignments, for instance), so only the translations are held to the
+    // reorder window
+    OutputCollector *windowCollector = ioWrapper->GetTranslationOutputCollector();
+    if (staticData.ThreadCount() > 1) {
+      // decoding threads only hand over their output, one thread per stream writes it
+      windowCollector->SetReorderWindow(staticData.GetOutputReorderWindow());
+      for (size_t i = 0; i < collectors.size(); ++i) {
+        collectors[i]->StartWriterThread();
+      }
+    }
+    // read ahead and translate the longest sentences first, so that they
+    // don't hold up the end of the run
+    const size_t lookahead = staticData.ThreadCount() > 1 ? staticData.GetScheduleLookahead() : 0;
+    vector<pair<size_t, Task*> > batch;
 #endif
 
     // read each sentence & decode
     InputType *source=0;
+    long nextTranslationId = staticData.GetStartTranslationId();
     while(ReadInput(*ioWrapper,staticData.GetInputType(),source)) {
       IFVERBOSE(1)
       ResetUserTime();
+      const size_t sourceSize = source->GetSize();
+      const long translationId = source->GetTranslationId();
+      // ids given in the input can leave gaps, which would hold up all later output
+      for (; nextTranslationId < translationId; ++nextTranslationId) {
+        for (size_t i = 0; i < collectors.size(); ++i) {
+          collectors[i]->Write(nextTranslationId, "");
+        }
+      }
+      nextTranslationId = max(nextTranslationId, translationId + 1);
+#ifdef WITH_THREADS
+      // don't run ahead of a slow sentence by more than the reorder window
+      windowCollector->WaitForWindow(translationId);
+#endif
       TranslationTask *task = new TranslationTask(source, *ioWrapper);
       source = NULL;  // task will delete source
 #ifdef WITH_THREADS
-      pool.Submit(task);  // pool will delete task
+      batch.push_back(make_pair(sourceSize, static_cast<Task*>(task)));
+      if (batch.size() >= lookahead) {
+        pool.SubmitBatch(batch);  // pool will delete task
+      }
 #else
       task->Run();
       delete task;
@@ -314,9 +359,15 @@ int main(int argc, char* argv[])
     }
 
 #ifdef WITH_THREADS
+    pool.SubmitBatch(batch);
     pool.Stop(true);  // flush remaining jobs
+    for (size_t i = 0; i < collectors.size(); ++i) {
+      collectors[i]->StopWriterThread();
+    }
 #endif
 
+    IFVERBOSE(1) PhraseDictionary::PrintCacheStats(std::cerr);
+
     delete ioWrapper;
     FeatureFunction::Destroy();
 
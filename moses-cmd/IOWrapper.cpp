@@ -286,9 +286,7 @@ void OutputSurface(std::ostream &out, const Hypothesis &edge, const std::vector<
       out << ",total=";
       out << edge.GetScore() - edge.GetPrevHypo()->GetScore();
       out << ",";
-      ScoreComponentCollection scoreBreakdown(edge.GetScoreBreakdown());
-      scoreBreakdown.MinusEquals(edge.GetPrevHypo()->GetScoreBreakdown());
-      OutputAllFeatureScores(scoreBreakdown, out);
+      OutputAllFeatureScores(edge.GetCurrScoreBreakdown(), out);
     }
     out << "| ";
   }
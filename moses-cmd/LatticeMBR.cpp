@@ -10,7 +10,10 @@
 #include "LatticeMBR.h"
 #include "moses/StaticData.h"
 #include <algorithm>
+#include <functional>
+#include <limits>
 #include <set>
+#include "util/murmur_hash.hh"
 
 using namespace std;
 using namespace Moses;
@@ -51,30 +54,157 @@ void extract_ngrams(const vector<Word >& sentence, map < Phrase, int >  & allngr
 
 
 
-void NgramScores::addScore(const Hypothesis* node, const Phrase& ngram, float score)
+NgramPosteriors::NgramPosteriors()
+  : m_numWords(0)
 {
-  set<Phrase>::const_iterator ngramIter = m_ngrams.find(ngram);
-  if (ngramIter == m_ngrams.end()) {
-    ngramIter = m_ngrams.insert(ngram).first;
-  }
-  map<const Phrase*,float>& ngramScores = m_scores[node];
-  map<const Phrase*,float>::iterator scoreIter = ngramScores.find(&(*ngramIter));
-  if (scoreIter == ngramScores.end()) {
-    ngramScores[&(*ngramIter)] = score;
-  } else {
-    ngramScores[&(*ngramIter)] = log_sum(score,scoreIter->second);
+  // AutoProbing does not initialise its buckets to the empty key
+  m_wordIds.Clear();
+  m_ngramIds.Clear();
+}
+
+uint64_t NgramPosteriors::KeyHash::operator()(uint64_t key) const
+{
+  return util::MurmurHash64A(&key, sizeof(key));
+}
+
+uint64_t NgramPosteriors::WordKey(const Word &word)
+{
+  // 0 is the empty key of the table
+  uint64_t key = word.hash();
+  return key ? key : 1;
+}
+
+uint64_t NgramPosteriors::NgramKey(size_t prefix, size_t word)
+{
+  uint64_t prefixKey = (prefix == NOT_FOUND) ? 0 : prefix + 1;
+  return (prefixKey << 32) | (word + 1);
+}
+
+size_t NgramPosteriors::AddWord(const Word &word)
+{
+  Entry entry;
+  entry.key = WordKey(word);
+  entry.id = m_numWords;
+  Table::MutableIterator it;
+  if (!m_wordIds.FindOrInsert(entry, it)) {
+    ++m_numWords;
+  }
+  return it->id;
+}
+
+size_t NgramPosteriors::FindWord(const Word &word) const
+{
+  Table::ConstIterator it;
+  return m_wordIds.Find(WordKey(word), it) ? it->id : NOT_FOUND;
+}
+
+size_t NgramPosteriors::AddNgram(size_t prefix, size_t word)
+{
+  Entry entry;
+  entry.key = NgramKey(prefix, word);
+  entry.id = m_ngrams.size();
+  Table::MutableIterator it;
+  if (!m_ngramIds.FindOrInsert(entry, it)) {
+    Ngram ngram;
+    ngram.prefix = prefix;
+    ngram.word = word;
+    ngram.order = (prefix == NOT_FOUND) ? 1 : m_ngrams[prefix].order + 1;
+    m_ngrams.push_back(ngram);
   }
+  return it->id;
 }
 
-NgramScores::NodeScoreIterator NgramScores::nodeBegin(const Hypothesis* node)
+size_t NgramPosteriors::FindNgram(size_t prefix, size_t word) const
 {
-  return m_scores[node].begin();
+  Table::ConstIterator it;
+  return m_ngramIds.Find(NgramKey(prefix, word), it) ? it->id : NOT_FOUND;
 }
 
+bool NgramPosteriors::IsScored(size_t ngram) const
+{
+  return ngram < m_logProbs.size() && m_logProbs[ngram] != -numeric_limits<float>::infinity();
+}
+
+namespace
+{
+
+/** Log scores keyed by n-gram id, in a dense array that is reset by bumping a stamp */
+class NgramAccumulator
+{
+public:
+  NgramAccumulator() : m_stamp(0) {}
+
+  void Clear() {
+    ++m_stamp;
+    m_touched.clear();
+  }
+  bool Contains(size_t ngram) const {
+    return ngram < m_marks.size() && m_marks[ngram] == m_stamp;
+  }
+  /** logsum this score to the existing score */
+  void Add(size_t ngram, float score) {
+    if (ngram >= m_marks.size()) {
+      m_marks.resize(ngram + 1, 0);
+      m_scores.resize(ngram + 1);
+    }
+    if (m_marks[ngram] != m_stamp) {
+      m_marks[ngram] = m_stamp;
+      m_scores[ngram] = score;
+      m_touched.push_back(ngram);
+    } else {
+      m_scores[ngram] = log_sum(m_scores[ngram], score);
+    }
+  }
+  const vector<size_t> &GetNgrams() const {
+    return m_touched;
+  }
+  float GetScore(size_t ngram) const {
+    return m_scores[ngram];
+  }
+
+private:
+  size_t m_stamp;
+  vector<size_t> m_marks;
+  vector<float> m_scores;
+  vector<size_t> m_touched;
+};
+
+/** The scores of a set of n-grams, for all edges or nodes of the lattice in one array */
+struct NgramScore {
+  NgramScore(size_t ngram, float score) : ngram(ngram), score(score) {}
+  size_t ngram;
+  float score;
+};
+
+void AppendScores(const NgramAccumulator &acc, vector<NgramScore> &scores, vector<size_t> &begins)
+{
+  const vector<size_t> &ngrams = acc.GetNgrams();
+  for (size_t i = 0; i < ngrams.size(); ++i) {
+    scores.push_back(NgramScore(ngrams[i], acc.GetScore(ngrams[i])));
+  }
+  begins.push_back(scores.size());
+}
 
-NgramScores::NodeScoreIterator NgramScores::nodeEnd(const Hypothesis* node)
+/**
+* For posteriors: the window holds words of a path, with the edge being processed
+* starting at edgeBegin. Does the ngram of the given length at start, which crosses
+* into the edge, occur elsewhere in the window, either before the edge or crossing
+* into it from a later start? Then the path gets it from the history, or from the
+* shorter suffix, as well.
+*/
+bool OccursElsewhere(const vector<size_t> &window, size_t start, size_t edgeBegin, size_t length)
 {
-  return m_scores[node].end();
+  for (size_t other = 0; other < edgeBegin && other + length <= window.size(); ++other) {
+    if (other == start || (other < start && other + length > edgeBegin)) {
+      continue;
+    }
+    if (equal(window.begin() + start, window.begin() + start + length, window.begin() + other)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }
 
 LatticeMBRSolution::LatticeMBRSolution(const TrellisPath& path, bool isMap) :
@@ -98,25 +228,35 @@ LatticeMBRSolution::LatticeMBRSolution(const TrellisPath& path, bool isMap) :
 }
 
 
-void LatticeMBRSolution::CalcScore(map<Phrase, float>& finalNgramScores, const vector<float>& thetas, float mapWeight)
+void LatticeMBRSolution::CalcScore(const NgramPosteriors& ngramPosteriors, const vector<float>& thetas, float mapWeight)
 {
   m_ngramScores.assign(thetas.size()-1, -10000);
 
-  map < Phrase, int > counts;
-  extract_ngrams(m_words,counts);
-
   //Now score this translation
   m_score = thetas[0] * m_words.size();
 
-  //Calculate the ngramScores, working in log space at first
-  for (map < Phrase, int >::iterator ngrams = counts.begin(); ngrams != counts.end(); ++ngrams) {
-    float ngramPosterior = UNKNGRAMLOGPROB;
-    map<Phrase,float>::const_iterator ngramPosteriorIt = finalNgramScores.find(ngrams->first);
-    if (ngramPosteriorIt != finalNgramScores.end()) {
-      ngramPosterior = ngramPosteriorIt->second;
+  vector<size_t> wordIds(m_words.size());
+  for (size_t i = 0; i < m_words.size(); ++i) {
+    wordIds[i] = ngramPosteriors.FindWord(m_words[i]);
+  }
+
+  //Calculate the ngramScores, working in log space at first. Every occurrence of
+  //an ngram adds its posterior, the same as adding log(count) + posterior once
+  for (size_t start = 0; start < m_words.size(); ++start) {
+    size_t ngram = NOT_FOUND;
+    for (size_t end = start; end < start + bleu_order && end < m_words.size(); ++end) {
+      //once an ngram is not in the lattice, neither are its extensions
+      if (wordIds[end] == NOT_FOUND || (end > start && ngram == NOT_FOUND)) {
+        ngram = NOT_FOUND;
+      } else {
+        ngram = ngramPosteriors.FindNgram(ngram, wordIds[end]);
+      }
+      float ngramPosterior = UNKNGRAMLOGPROB;
+      if (ngram != NOT_FOUND && ngramPosteriors.IsScored(ngram)) {
+        ngramPosterior = ngramPosteriors.GetLogProb(ngram);
+      }
+      m_ngramScores[end-start] = log_sum(ngramPosterior, m_ngramScores[end-start]);
     }
-    size_t ngramSize = ngrams->first.GetSize();
-    m_ngramScores[ngramSize-1] = log_sum(log((float)ngrams->second) + ngramPosterior,m_ngramScores[ngramSize-1]);
   }
 
   //convert from log to probability and create weighted sum
@@ -131,7 +271,55 @@ void LatticeMBRSolution::CalcScore(map<Phrase, float>& finalNgramScores, const v
 }
 
 
-void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const Hypothesis* > > & outgoingHyps, map<const Hypothesis*, vector<Edge> >& incomingEdges,
+namespace
+{
+
+struct HypothesisEdge {
+  HypothesisEdge(const Hypothesis* tail, const Hypothesis* head, float score, const Phrase& words)
+    : tail(tail), head(head), score(score), words(&words) {}
+  const Hypothesis* tail;
+  const Hypothesis* head;
+  float score;
+  const Phrase* words;
+};
+
+/** Set of hypotheses, indexed by hypothesis id */
+class HypothesisSet
+{
+public:
+  bool Contains(const Hypothesis* hyp) const {
+    if (!hyp) {
+      return false;
+    }
+    size_t id = hyp->GetId();
+    return id < m_members.size() && m_members[id];
+  }
+  void Insert(const Hypothesis* hyp) {
+    size_t id = hyp->GetId();
+    if (id >= m_members.size()) {
+      m_members.resize(id + 1, false);
+    }
+    if (!m_members[id]) {
+      m_members[id] = true;
+      m_hyps.push_back(hyp);
+    }
+  }
+  size_t GetMaxSize() const {
+    return m_members.size();
+  }
+  //! in order of insertion
+  const vector<const Hypothesis*>& GetHypotheses() const {
+    return m_hyps;
+  }
+
+private:
+  vector<bool> m_members;
+  vector<const Hypothesis*> m_hyps;
+};
+
+}
+
+void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const Hypothesis* > > & outgoingHyps, PrunedLattice& lattice,
                     const vector< float> & estimatedScores, const Hypothesis* bestHypo, size_t edgeDensity, float scale)
 {
 
@@ -149,27 +337,30 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
       outgoingHyps[emptyHyp].insert(connectedHyp[i]);
   }
 
-  //sort hyps based on estimated scores - do so by copying to multimap
-  multimap<float, const Hypothesis*> sortHypsByVal;
+  //sort hyps based on estimated scores, best first. Hyps with equal scores are
+  //visited last one first, hyp 0 gets the best score and comes first
+  vector<pair<float, size_t> > sortHypsByVal;
+  sortHypsByVal.reserve(estimatedScores.size() + 1);
+  float bestScore = -numeric_limits<float>::infinity();
   for (size_t i =0; i < estimatedScores.size(); ++i) {
-    sortHypsByVal.insert(make_pair(estimatedScores[i], connectedHyp[i]));
+    sortHypsByVal.push_back(make_pair(estimatedScores[i], i));
+    bestScore = max(bestScore, estimatedScores[i]);
   }
-
-  multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end();
-  float bestScore = it->first;
   //store best score as score of hyp 0
-  sortHypsByVal.insert(make_pair(bestScore, emptyHyp));
+  sortHypsByVal.push_back(make_pair(bestScore, connectedHyp.size() - 1));
+  sort(sortHypsByVal.begin(), sortHypsByVal.end(), greater<pair<float, size_t> >());
 
 
   IFVERBOSE(3) {
-    for (multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end(); it != --sortHypsByVal.begin(); --it) {
-      const Hypothesis* currHyp =  it->second;
-      cerr << "Hyp " << currHyp->GetId() << ", estimated score: " << it->first << endl;
+    for (size_t i = 0; i < sortHypsByVal.size(); ++i) {
+      const Hypothesis* currHyp = connectedHyp[sortHypsByVal[i].second];
+      cerr << "Hyp " << currHyp->GetId() << ", estimated score: " << sortHypsByVal[i].first << endl;
     }
   }
 
 
-  set <const Hypothesis*> survivingHyps; //store hyps that make the cut in this
+  HypothesisSet survivingHyps; //store hyps that make the cut in this
+  vector<HypothesisEdge> edges;
 
   VERBOSE(2, "BEST HYPO TARGET LENGTH : " << bestHypo->GetSize() << endl)
   size_t numEdgesTotal = edgeDensity * bestHypo->GetSize(); //as per Shankar, aim for (density * target length of MAP solution) arcs
@@ -178,25 +369,23 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
 
   float prevScore = -999999;
 
-  //now iterate over multimap
-  for (multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end(); it != --sortHypsByVal.begin(); --it) {
-    float currEstimatedScore = it->first;
-    const Hypothesis* currHyp =  it->second;
+  //now iterate over the sorted hyps
+  for (size_t i = 0; i < sortHypsByVal.size(); ++i) {
+    float currEstimatedScore = sortHypsByVal[i].first;
+    const Hypothesis* currHyp = connectedHyp[sortHypsByVal[i].second];
 
     if (numEdgesCreated >= numEdgesTotal && prevScore > currEstimatedScore) //if this hyp has equal estimated score to previous, include its edges too
       break;
 
     prevScore = currEstimatedScore;
     VERBOSE(3, "Num edges created : "<< numEdgesCreated << ", numEdges wanted " << numEdgesTotal << endl)
-    VERBOSE(3, "Considering hyp " << currHyp->GetId() << ", estimated score: " << it->first << endl)
+    VERBOSE(3, "Considering hyp " << currHyp->GetId() << ", estimated score: " << currEstimatedScore << endl)
 
-    survivingHyps.insert(currHyp); //CurrHyp made the cut
+    survivingHyps.Insert(currHyp); //CurrHyp made the cut
 
     // is its best predecessor already included ?
-    if (survivingHyps.find(currHyp->GetPrevHypo()) != survivingHyps.end()) { //yes, then add an edge
-      vector <Edge>& edges = incomingEdges[currHyp];
-      Edge winningEdge(currHyp->GetPrevHypo(),currHyp,scale*(currHyp->GetScore() - currHyp->GetPrevHypo()->GetScore()),currHyp->GetCurrTargetPhrase());
-      edges.push_back(winningEdge);
+    if (survivingHyps.Contains(currHyp->GetPrevHypo())) { //yes, then add an edge
+      edges.push_back(HypothesisEdge(currHyp->GetPrevHypo(),currHyp,scale*(currHyp->GetScore() - currHyp->GetPrevHypo()->GetScore()),currHyp->GetCurrTargetPhrase()));
       ++numEdgesCreated;
     }
 
@@ -207,11 +396,9 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
       for (iterArcList = arcList->begin() ; iterArcList != arcList->end() ; ++iterArcList) {
         const Hypothesis *loserHypo = *iterArcList;
         const Hypothesis* loserPrevHypo = loserHypo->GetPrevHypo();
-        if (survivingHyps.find(loserPrevHypo) != survivingHyps.end()) { //found it, add edge
+        if (survivingHyps.Contains(loserPrevHypo)) { //found it, add edge
           double arcScore = loserHypo->GetScore() - loserPrevHypo->GetScore();
-          Edge losingEdge(loserPrevHypo, currHyp, arcScore*scale, loserHypo->GetCurrTargetPhrase());
-          vector <Edge>& edges = incomingEdges[currHyp];
-          edges.push_back(losingEdge);
+          edges.push_back(HypothesisEdge(loserPrevHypo, currHyp, arcScore*scale, loserHypo->GetCurrTargetPhrase()));
           ++numEdgesCreated;
         }
       }
@@ -225,15 +412,12 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
       for (set<const Hypothesis*>::const_iterator outHypIts = outHyps.begin(); outHypIts != outHyps.end(); ++outHypIts) {
         const Hypothesis* succHyp = *outHypIts;
 
-        if (survivingHyps.find(succHyp) == survivingHyps.end()) //Have we encountered the successor yet?
+        if (!survivingHyps.Contains(succHyp)) //Have we encountered the successor yet?
           continue; //No, move on to next
 
         //Curr Hyp can be : a) the best predecessor  of succ b) or an arc attached to succ
         if (succHyp->GetPrevHypo() == currHyp) { //best predecessor
-          vector <Edge>& succEdges = incomingEdges[succHyp];
-          Edge succWinningEdge(currHyp, succHyp, scale*(succHyp->GetScore() - currHyp->GetScore()), succHyp->GetCurrTargetPhrase());
-          succEdges.push_back(succWinningEdge);
-          survivingHyps.insert(succHyp);
+          edges.push_back(HypothesisEdge(currHyp, succHyp, scale*(succHyp->GetScore() - currHyp->GetScore()), succHyp->GetCurrTargetPhrase()));
           ++numEdgesCreated;
         }
 
@@ -246,10 +430,8 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
             const Hypothesis *loserHypo = *iterArcList;
             const Hypothesis* loserPrevHypo = loserHypo->GetPrevHypo();
             if (loserPrevHypo == currHyp) { //found it
-              vector <Edge>& succEdges = incomingEdges[succHyp];
               double arcScore = loserHypo->GetScore() - currHyp->GetScore();
-              Edge losingEdge(currHyp, succHyp,scale* arcScore, loserHypo->GetCurrTargetPhrase());
-              succEdges.push_back(losingEdge);
+              edges.push_back(HypothesisEdge(currHyp, succHyp,scale* arcScore, loserHypo->GetCurrTargetPhrase()));
               ++numEdgesCreated;
             }
           }
@@ -258,17 +440,41 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
     }
   }
 
-  connectedHyp.clear();
-  for (set <const Hypothesis*>::iterator it =  survivingHyps.begin(); it != survivingHyps.end(); ++it) {
-    connectedHyp.push_back(*it);
+  //the surviving hyps are the nodes, sorted by increasing source word coverage
+  connectedHyp = survivingHyps.GetHypotheses();
+  lattice.nodes = connectedHyp;
+  stable_sort(lattice.nodes.begin(), lattice.nodes.end(), ascendingCoverageCmp);
+
+  vector<size_t> nodeIndex(survivingHyps.GetMaxSize(), NOT_FOUND);
+  lattice.complete.resize(lattice.nodes.size());
+  for (size_t i = 0; i < lattice.nodes.size(); ++i) {
+    nodeIndex[lattice.nodes[i]->GetId()] = i;
+    lattice.complete[i] = lattice.nodes[i]->GetWordsBitmap().IsComplete();
+  }
+
+  //group the edges by head node, keeping the order in which they were created
+  lattice.firstEdge.assign(lattice.nodes.size() + 1, 0);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    ++lattice.firstEdge[nodeIndex[edges[i].head->GetId()] + 1];
+  }
+  for (size_t i = 0; i < lattice.nodes.size(); ++i) {
+    lattice.firstEdge[i+1] += lattice.firstEdge[i];
+  }
+  vector<size_t> nextEdge(lattice.firstEdge.begin(), lattice.firstEdge.end() - 1);
+  lattice.edges.resize(edges.size());
+  for (size_t i = 0; i < edges.size(); ++i) {
+    LatticeEdge& edge = lattice.edges[nextEdge[nodeIndex[edges[i].head->GetId()]]++];
+    edge.tail = nodeIndex[edges[i].tail->GetId()];
+    edge.score = edges[i].score;
+    edge.words = edges[i].words;
   }
 
   VERBOSE(2, "Done! Num edges created : "<< numEdgesCreated << ", numEdges wanted " << numEdgesTotal << endl)
 
   IFVERBOSE(3) {
     cerr << "Surviving hyps: " ;
-    for (set <const Hypothesis*>::iterator it =  survivingHyps.begin(); it != survivingHyps.end(); ++it) {
-      cerr << (*it)->GetId() << " ";
+    for (size_t i = 0; i < connectedHyp.size(); ++i) {
+      cerr << connectedHyp[i]->GetId() << " ";
     }
     cerr << endl;
   }
@@ -276,223 +482,175 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
 
 }
 
-void calcNgramExpectations(Lattice & connectedHyp, map<const Hypothesis*, vector<Edge> >& incomingEdges,
-                           map<Phrase, float>& finalNgramScores, bool posteriors)
+/**
+* Forward pass over the pruned lattice in the log semiring. For every edge, the
+* ngrams it introduces are scored with the forward score of the node where they
+* start plus the edge scores up to the end of the ngram: those within the edge,
+* and those that extend a suffix of an incoming edge of its tail. The suffixes
+* of an edge are the ngrams shorter than bleu_order that end at its last word,
+* scored the same way, so an ngram can be extended over any number of edges. A
+* node collects the ngrams introduced by its incoming edges and the ngrams of
+* their tails, propagated along the edges.
+*
+* Expected counts are exact. With posteriors, an ngram within an edge is counted
+* once and is not propagated from its tail as well, since every path through the
+* edge has it. An ngram that extends a suffix is skipped when the path has it
+* again in the incoming edge or the suffix. This is exact unless a path has an
+* ngram that extends a suffix further back than that as well.
+*/
+void calcNgramExpectations(const PrunedLattice & lattice, NgramPosteriors& ngramScores, bool posteriors)
 {
+  const vector<LatticeEdge>& edges = lattice.edges;
+  const vector<size_t>& firstEdge = lattice.firstEdge;
+  const size_t numNodes = lattice.nodes.size();
+
+  //the words of each edge as ids
+  vector<size_t> edgeWords;
+  vector<size_t> firstWord(1, 0);
+  for (size_t e = 0; e < edges.size(); ++e) {
+    const Phrase& words = *edges[e].words;
+    for (size_t pos = 0; pos < words.GetSize(); ++pos) {
+      edgeWords.push_back(ngramScores.AddWord(words.GetWord(pos)));
+    }
+    firstWord.push_back(edgeWords.size());
+  }
 
-  sort(connectedHyp.begin(),connectedHyp.end(),ascendingCoverageCmp); //sort by increasing source word cov
+  //a node without incoming edges has forward score 0, as hyp 0 (probability 1)
+  vector<float> forwardScore(numNodes, 0.0f);
 
-  /*cerr << "Lattice:" << endl;
-  for (Lattice::const_iterator i = connectedHyp.begin(); i != connectedHyp.end(); ++i) {
-      const Hypothesis* h = *i;
-      cerr << *h << endl;
-      const vector<Edge>& edges = incomingEdges[h];
-      for (size_t e = 0; e < edges.size(); ++e) {
-          cerr << edges[e];
-      }
-  }*/
+  //suffix scores of each edge and ngram scores of each node, in the order they are visited
+  vector<NgramScore> suffixNgrams, nodeNgrams;
+  vector<size_t> suffixNgramBegin(1, 0), nodeNgramBegin(1, 0);
+  nodeNgramBegin.push_back(0); //hyp 0
 
-  map<const Hypothesis*, float> forwardScore;
-  forwardScore[connectedHyp[0]] = 0.0f; //forward score of hyp 0 is 1 (or 0 in logprob space)
-  set< const Hypothesis *> finalHyps; //store completed hyps
+  NgramAccumulator localScores, crossingScores, suffixScores, nodeScores, finalScores;
+  finalScores.Clear();
+  vector<size_t> window; //a suffix followed by the words of the edge
+  float Z = 9999999; //the total score of the lattice
 
-  NgramScores ngramScores;//ngram scores for each hyp
+  for (size_t node = 1; node < numNodes; ++node) {
+    VERBOSE(3, "Processing lattice node: " << node << endl)
 
-  for (size_t i = 1; i < connectedHyp.size(); ++i) {
-    const Hypothesis* currHyp = connectedHyp[i];
-    if (currHyp->GetWordsBitmap().IsComplete()) {
-      finalHyps.insert(currHyp);
+    for (size_t e = firstEdge[node]; e < firstEdge[node+1]; ++e) {
+      float score = forwardScore[edges[e].tail] + edges[e].score;
+      forwardScore[node] = (e == firstEdge[node]) ? score : log_sum(forwardScore[node], score);
     }
 
-    VERBOSE(3, "Processing hyp: " << currHyp->GetId() << ", num words cov= " << currHyp->GetWordsBitmap().GetNumWordsCovered() <<  endl)
-
-    vector <Edge> & edges = incomingEdges[currHyp];
-    for (size_t e = 0; e < edges.size(); ++e) {
-      const Edge& edge = edges[e];
-      if (forwardScore.find(currHyp) == forwardScore.end()) {
-        forwardScore[currHyp] = forwardScore[edge.GetTailNode()] + edge.GetScore();
-        VERBOSE(3, "Fwd score["<<currHyp->GetId()<<"] = fwdScore["<<edge.GetTailNode()->GetId() << "] + edge Score: " << edge.GetScore() << endl)
-      } else {
-        forwardScore[currHyp] = log_sum(forwardScore[currHyp], forwardScore[edge.GetTailNode()] + edge.GetScore());
-        VERBOSE(3, "Fwd score["<<currHyp->GetId()<<"] += fwdScore["<<edge.GetTailNode()->GetId() << "] + edge Score: " << edge.GetScore() << endl)
-      }
-    }
-
-    //Process ngrams now
-    for (size_t j =0 ; j < edges.size(); ++j) {
-      Edge& edge = edges[j];
-      const NgramHistory & incomingPhrases = edge.GetNgrams(incomingEdges);
-
-      //let's first score ngrams introduced by this edge
-      for (NgramHistory::const_iterator it = incomingPhrases.begin(); it != incomingPhrases.end(); ++it) {
-        const Phrase& ngram = it->first;
-        const PathCounts& pathCounts = it->second;
-        VERBOSE(4, "Calculating score for: " << it->first << endl)
-
-        for (PathCounts::const_iterator pathCountIt = pathCounts.begin(); pathCountIt != pathCounts.end(); ++pathCountIt) {
-          //Score of an n-gram is forward score of head node of leftmost edge + all edge scores
-          const Path&  path = pathCountIt->first;
-          //cerr << "path count for " << ngram << " is " << pathCountIt->second << endl;
-          float score = forwardScore[path[0]->GetTailNode()];
-          for (size_t i = 0; i < path.size(); ++i) {
-            score += path[i]->GetScore();
+    nodeScores.Clear();
+    for (size_t e = firstEdge[node]; e < firstEdge[node+1]; ++e) {
+      const LatticeEdge& edge = edges[e];
+      const size_t tail = edge.tail;
+      const size_t wordBegin = firstWord[e], numWords = firstWord[e+1] - firstWord[e];
+
+      localScores.Clear();
+      crossingScores.Clear();
+      suffixScores.Clear();
+
+      //ngrams within the edge
+      const float localScore = forwardScore[tail] + edge.score;
+      for (size_t start = 0; start < numWords; ++start) {
+        size_t ngram = NOT_FOUND;
+        for (size_t end = start; end < numWords && end < start + bleu_order; ++end) {
+          ngram = ngramScores.AddNgram(ngram, edgeWords[wordBegin + end]);
+          //for posteriors, repeats within the edge are on the same path
+          if (!posteriors || !localScores.Contains(ngram)) {
+            localScores.Add(ngram, localScore);
           }
-          //if we're doing expectations, then the number of times the ngram
-          //appears on the path is relevant.
-          size_t count = posteriors ? 1 : pathCountIt->second;
-          for (size_t k = 0; k < count; ++k) {
-            ngramScores.addScore(currHyp,ngram,score);
+          if (end + 1 == numWords && end + 1 - start < bleu_order) {
+            suffixScores.Add(ngram, localScore);
           }
         }
       }
 
-      //Now score ngrams that are just being propagated from the history
-      for (NgramScores::NodeScoreIterator it = ngramScores.nodeBegin(edge.GetTailNode());
-           it != ngramScores.nodeEnd(edge.GetTailNode()); ++it) {
-        const Phrase & currNgram = *(it->first);
-        float currNgramScore = it->second;
-        VERBOSE(4, "Calculating score for: " << currNgram << endl)
-
-        // For posteriors, don't double count ngrams
-        if (!posteriors || incomingPhrases.find(currNgram) == incomingPhrases.end()) {
-          float score = edge.GetScore() + currNgramScore;
-          ngramScores.addScore(currHyp,currNgram,score);
+      //ngrams that extend a suffix of an incoming edge of the tail
+      for (size_t prevEdge = firstEdge[tail]; prevEdge < firstEdge[tail+1]; ++prevEdge) {
+        for (size_t i = suffixNgramBegin[prevEdge]; i < suffixNgramBegin[prevEdge+1]; ++i) {
+          size_t ngram = suffixNgrams[i].ngram;
+          const size_t order = ngramScores.GetOrder(ngram);
+          const float score = suffixNgrams[i].score + edge.score;
+          if (numWords == 0) {
+            suffixScores.Add(ngram, score);
+            continue;
+          }
+          //the longer of the suffix and the words of the incoming edge, then the start of the edge
+          size_t edgeBegin = 0;
+          if (posteriors) {
+            const size_t prevBegin = firstWord[prevEdge], prevNumWords = firstWord[prevEdge+1] - prevBegin;
+            if (prevNumWords >= order) {
+              window.assign(edgeWords.begin() + prevBegin, edgeWords.begin() + prevBegin + prevNumWords);
+            } else {
+              window.resize(order);
+              for (size_t pos = order, prefix = ngram; pos > 0; --pos, prefix = ngramScores.GetPrefix(prefix)) {
+                window[pos-1] = ngramScores.GetWord(prefix);
+              }
+            }
+            edgeBegin = window.size();
+            window.insert(window.end(), edgeWords.begin() + wordBegin, edgeWords.begin() + wordBegin + min(numWords, bleu_order));
+          }
+          for (size_t end = 0; end < numWords && order + end < bleu_order; ++end) {
+            ngram = ngramScores.AddNgram(ngram, edgeWords[wordBegin + end]);
+            //for posteriors, skip ngrams that every path through the edge has, or
+            //that this path has elsewhere around the tail
+            if (!posteriors || (!localScores.Contains(ngram) && !OccursElsewhere(window, edgeBegin - order, edgeBegin, order + end + 1))) {
+              crossingScores.Add(ngram, score);
+            }
+            if (end + 1 == numWords && order + end + 1 < bleu_order) {
+              suffixScores.Add(ngram, score);
+            }
+          }
         }
       }
+      AppendScores(suffixScores, suffixNgrams, suffixNgramBegin);
 
-    }
-  }
-
-  float Z = 9999999; //the total score of the lattice
-
-  //Done - Print out ngram posteriors for final hyps
-  for (set< const Hypothesis *>::iterator finalHyp = finalHyps.begin(); finalHyp != finalHyps.end(); ++finalHyp) {
-    const Hypothesis* hyp = *finalHyp;
-
-    for (NgramScores::NodeScoreIterator it = ngramScores.nodeBegin(hyp); it != ngramScores.nodeEnd(hyp); ++it) {
-      const Phrase& ngram = *(it->first);
-      if (finalNgramScores.find(ngram) == finalNgramScores.end()) {
-        finalNgramScores[ngram] = it->second;
-      } else {
-        finalNgramScores[ngram] = log_sum(it->second,  finalNgramScores[ngram]);
+      //the node gets the ngrams introduced by the edge ...
+      const vector<size_t>& local = localScores.GetNgrams();
+      for (size_t i = 0; i < local.size(); ++i) {
+        nodeScores.Add(local[i], localScores.GetScore(local[i]));
       }
-    }
-
-    if (Z == 9999999) {
-      Z = forwardScore[hyp];
-    } else {
-      Z = log_sum(Z, forwardScore[hyp]);
-    }
-  }
-
-  //Z *= scale;  //scale the score
-
-  for (map<Phrase, float>::iterator finalScoresIt = finalNgramScores.begin();  finalScoresIt != finalNgramScores.end(); ++finalScoresIt) {
-    finalScoresIt->second =  finalScoresIt->second - Z;
-    IFVERBOSE(2) {
-      VERBOSE(2,finalScoresIt->first << " [" << finalScoresIt->second << "]" << endl);
-    }
-  }
-
-}
-
-const NgramHistory& Edge::GetNgrams(map<const Hypothesis*, vector<Edge> > & incomingEdges)
-{
-
-  if (m_ngrams.size() > 0)
-    return m_ngrams;
-
-  const Phrase& currPhrase = GetWords();
-  //Extract the n-grams local to this edge
-  for (size_t start = 0; start < currPhrase.GetSize(); ++start) {
-    for (size_t end = start; end < start + bleu_order; ++end) {
-      if (end < currPhrase.GetSize()) {
-        Phrase edgeNgram(end-start+1);
-        for (size_t index = start; index <= end; ++index) {
-          edgeNgram.AddWord(currPhrase.GetWord(index));
+      const vector<size_t>& crossing = crossingScores.GetNgrams();
+      for (size_t i = 0; i < crossing.size(); ++i) {
+        nodeScores.Add(crossing[i], crossingScores.GetScore(crossing[i]));
+      }
+      // ... and those propagated from the history
+      for (size_t i = nodeNgramBegin[tail]; i < nodeNgramBegin[tail+1]; ++i) {
+        const size_t ngram = nodeNgrams[i].ngram;
+        if (!posteriors || !localScores.Contains(ngram)) {
+          nodeScores.Add(ngram, nodeNgrams[i].score + edge.score);
         }
-        //cout << "Inserting Phrase : " << edgeNgram << endl;
-        vector<const Edge*> edgeHistory;
-        edgeHistory.push_back(this);
-        storeNgramHistory(edgeNgram, edgeHistory);
-      } else {
-        break;
       }
     }
-  }
-
-  map<const Hypothesis*, vector<Edge> >::iterator it = incomingEdges.find(m_tailNode);
-  if (it != incomingEdges.end()) { //node has incoming edges
-    vector<Edge> & inEdges = it->second;
-
-    for (vector<Edge>::iterator edge = inEdges.begin(); edge != inEdges.end(); ++edge) {//add the ngrams straddling prev and curr edge
-      const NgramHistory & edgeIncomingNgrams = edge->GetNgrams(incomingEdges);
-      for (NgramHistory::const_iterator edgeInNgramHist = edgeIncomingNgrams.begin(); edgeInNgramHist != edgeIncomingNgrams.end(); ++edgeInNgramHist) {
-        const Phrase& edgeIncomingNgram = edgeInNgramHist->first;
-        const PathCounts &  edgeIncomingNgramPaths = edgeInNgramHist->second;
-        size_t back = min(edgeIncomingNgram.GetSize(), edge->GetWordsSize());
-        const Phrase&  edgeWords = edge->GetWords();
-        IFVERBOSE(3) {
-          cerr << "Edge: "<< *edge <<endl;
-          cerr << "edgeWords: " << edgeWords << endl;
-          cerr << "edgeInNgram: " << edgeIncomingNgram << endl;
-        }
-
-        Phrase edgeSuffix(ARRAY_SIZE_INCR);
-        Phrase ngramSuffix(ARRAY_SIZE_INCR);
-        GetPhraseSuffix(edgeWords,back,edgeSuffix);
-        GetPhraseSuffix(edgeIncomingNgram,back,ngramSuffix);
-
-        if (ngramSuffix == edgeSuffix) { //we've got the suffix of previous edge
-          size_t  edgeInNgramSize =  edgeIncomingNgram.GetSize();
+    AppendScores(nodeScores, nodeNgrams, nodeNgramBegin);
 
-          for (size_t i = 0; i < GetWordsSize() && i + edgeInNgramSize < bleu_order ; ++i) {
-            Phrase newNgram(edgeIncomingNgram);
-            for (size_t j = 0; j <= i ; ++j) {
-              newNgram.AddWord(GetWords().GetWord(j));
-            }
-            VERBOSE(3, "Inserting New Phrase : " << newNgram << endl)
-
-            for (PathCounts::const_iterator pathIt = edgeIncomingNgramPaths.begin(); pathIt !=  edgeIncomingNgramPaths.end(); ++pathIt) {
-              Path newNgramPath = pathIt->first;
-              newNgramPath.push_back(this);
-              storeNgramHistory(newNgram, newNgramPath, pathIt->second);
-            }
-          }
-        }
+    //ngram scores of the completed hyps make up the total
+    if (lattice.complete[node]) {
+      const vector<size_t>& ngrams = nodeScores.GetNgrams();
+      for (size_t i = 0; i < ngrams.size(); ++i) {
+        finalScores.Add(ngrams[i], nodeScores.GetScore(ngrams[i]));
       }
+      Z = (Z == 9999999) ? forwardScore[node] : log_sum(Z, forwardScore[node]);
     }
   }
-  return m_ngrams;
-}
 
-//Add the last lastN words of origPhrase to targetPhrase
-void Edge::GetPhraseSuffix(const Phrase&  origPhrase, size_t lastN, Phrase& targetPhrase) const
-{
-  size_t origSize = origPhrase.GetSize();
-  size_t startIndex = origSize - lastN;
-  for (size_t index = startIndex; index < origPhrase.GetSize(); ++index) {
-    targetPhrase.AddWord(origPhrase.GetWord(index));
+  vector<float> logProbs(ngramScores.GetSize(), -numeric_limits<float>::infinity());
+  const vector<size_t>& ngrams = finalScores.GetNgrams();
+  for (size_t i = 0; i < ngrams.size(); ++i) {
+    logProbs[ngrams[i]] = finalScores.GetScore(ngrams[i]) - Z;
   }
-}
+  ngramScores.SetLogProbs(logProbs);
 
-bool Edge::operator< (const Edge& compare ) const
-{
-  if (m_headNode->GetId() < compare.m_headNode->GetId())
-    return true;
-  if (compare.m_headNode->GetId() < m_headNode->GetId())
-    return false;
-  if (m_tailNode->GetId() < compare.m_tailNode->GetId())
-    return true;
-  if (compare.m_tailNode->GetId() < m_tailNode->GetId())
-    return false;
-  return GetScore() <  compare.GetScore();
+  VERBOSE(2, "Lattice ngrams: " << ngramScores.GetSize() << ", with posteriors: " << ngrams.size() << ", Z: " << Z << endl);
 }
 
-ostream& operator<< (ostream& out, const Edge& edge)
+void calcNgramExpectations(Manager& manager, size_t edgeDensity, float scale, NgramPosteriors& ngramScores, bool posteriors)
 {
-  out << "Head: " << edge.m_headNode->GetId() << ", Tail: " << edge.m_tailNode->GetId() << ", Score: " << edge.m_score << ", Phrase: " << edge.m_targetPhrase << endl;
-  return out;
+  std::map < int, bool > connected;
+  std::vector< const Hypothesis *> connectedList;
+  std::map < const Hypothesis*, set <const Hypothesis*> > outgoingHyps;
+  vector< float> estimatedScores;
+  manager.GetForwardBackwardSearchGraph(&connected, &connectedList, &outgoingHyps, &estimatedScores);
+  PrunedLattice lattice;
+  pruneLatticeFB(connectedList, outgoingHyps, lattice, estimatedScores, manager.GetBestHypothesis(), edgeDensity, scale);
+  calcNgramExpectations(lattice, ngramScores, posteriors);
 }
 
 bool ascendingCoverageCmp(const Hypothesis* a, const Hypothesis* b)
@@ -504,16 +662,15 @@ void getLatticeMBRNBest(Manager& manager, TrellisPathList& nBestList,
                         vector<LatticeMBRSolution>& solutions, size_t n)
 {
   const StaticData& staticData = StaticData::Instance();
-  std::map < int, bool > connected;
-  std::vector< const Hypothesis *> connectedList;
-  map<Phrase, float> ngramPosteriors;
-  std::map < const Hypothesis*, set <const Hypothesis*> > outgoingHyps;
-  map<const Hypothesis*, vector<Edge> > incomingEdges;
-  vector< float> estimatedScores;
-  manager.GetForwardBackwardSearchGraph(&connected, &connectedList, &outgoingHyps, &estimatedScores);
-  pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores, manager.GetBestHypothesis(), staticData.GetLatticeMBRPruningFactor(),staticData.GetMBRScale());
-  calcNgramExpectations(connectedList, incomingEdges, ngramPosteriors,true);
+  NgramPosteriors ngramPosteriors;
+  calcNgramExpectations(manager, staticData.GetLatticeMBRPruningFactor(), staticData.GetMBRScale(), ngramPosteriors, true);
+  getLatticeMBRNBest(ngramPosteriors, nBestList, solutions, n);
+}
 
+void getLatticeMBRNBest(const NgramPosteriors& ngramPosteriors, TrellisPathList& nBestList,
+                        vector<LatticeMBRSolution>& solutions, size_t n)
+{
+  const StaticData& staticData = StaticData::Instance();
   vector<float> mbrThetas = staticData.GetLatticeMBRThetas();
   float p = staticData.GetLatticeMBRPrecision();
   float r = staticData.GetLatticeMBRPRatio();
@@ -555,6 +712,14 @@ vector<Word> doLatticeMBR(Manager& manager, TrellisPathList& nBestList)
   return solutions.at(0).GetWords();
 }
 
+vector<Word> doLatticeMBR(const NgramPosteriors& ngramPosteriors, TrellisPathList& nBestList)
+{
+
+  vector<LatticeMBRSolution> solutions;
+  getLatticeMBRNBest(ngramPosteriors, nBestList, solutions,1);
+  return solutions.at(0).GetWords();
+}
+
 const TrellisPath doConsensusDecoding(Manager& manager, TrellisPathList& nBestList)
 {
   static const int BLEU_ORDER = 4;
@@ -562,26 +727,14 @@ const TrellisPath doConsensusDecoding(Manager& manager, TrellisPathList& nBestLi
 
   //calculate the ngram expectations
   const StaticData& staticData = StaticData::Instance();
-  std::map < int, bool > connected;
-  std::vector< const Hypothesis *> connectedList;
-  map<Phrase, float> ngramExpectations;
-  std::map < const Hypothesis*, set <const Hypothesis*> > outgoingHyps;
-  map<const Hypothesis*, vector<Edge> > incomingEdges;
-  vector< float> estimatedScores;
-  manager.GetForwardBackwardSearchGraph(&connected, &connectedList, &outgoingHyps, &estimatedScores);
-  pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores, manager.GetBestHypothesis(), staticData.GetLatticeMBRPruningFactor(),staticData.GetMBRScale());
-  calcNgramExpectations(connectedList, incomingEdges, ngramExpectations,false);
+  NgramPosteriors ngramExpectations;
+  calcNgramExpectations(manager, staticData.GetLatticeMBRPruningFactor(), staticData.GetMBRScale(), ngramExpectations, false);
 
   //expected length is sum of expected unigram counts
-  //cerr << "Thread " << pthread_self() <<  " Ngram expectations size: " << ngramExpectations.size() << endl;
   float ref_length = 0.0f;
-  for (map<Phrase,float>::const_iterator ref_iter = ngramExpectations.begin();
-       ref_iter != ngramExpectations.end(); ++ref_iter) {
-    //cerr << "Ngram: " << ref_iter->first << " score: " <<
-    //    ref_iter->second << endl;
-    if (ref_iter->first.GetSize() == 1) {
-      ref_length += exp(ref_iter->second);
-      //    cerr << "Expected for " << ref_iter->first << " is " << exp(ref_iter->second) << endl;
+  for (size_t ngram = 0; ngram < ngramExpectations.GetSize(); ++ngram) {
+    if (ngramExpectations.GetOrder(ngram) == 1 && ngramExpectations.IsScored(ngram)) {
+      ref_length += exp(ngramExpectations.GetLogProb(ngram));
     }
   }
 
@@ -595,14 +748,27 @@ const TrellisPath doConsensusDecoding(Manager& manager, TrellisPathList& nBestLi
   for (iter = nBestList.begin() ; iter != nBestList.end() ; ++iter) {
     const TrellisPath &path = **iter;
     vector<Word> words;
-    map<Phrase,int> ngrams;
     GetOutputWords(path,words);
-    /*for (size_t i = 0; i < words.size(); ++i) {
-        cerr << words[i].GetFactor(0)->GetString() << " ";
+
+    //the ngrams of the hypothesis that have an expectation, sorted so that repeats are adjacent
+    vector<size_t> ngrams;
+    for (size_t start = 0; start < words.size(); ++start) {
+      size_t ngram = NOT_FOUND;
+      for (size_t end = start; end < start + BLEU_ORDER && end < words.size(); ++end) {
+        size_t word = ngramExpectations.FindWord(words[end]);
+        if (word == NOT_FOUND) {
+          break;
+        }
+        ngram = ngramExpectations.FindNgram(ngram, word);
+        if (ngram == NOT_FOUND) {
+          break;
+        }
+        if (ngramExpectations.IsScored(ngram)) {
+          ngrams.push_back(ngram);
+        }
+      }
     }
-    cerr << endl;
-    */
-    extract_ngrams(words,ngrams);
+    sort(ngrams.begin(), ngrams.end());
 
     vector<float> comps(2*BLEU_ORDER+1);
     float logbleu = 0.0;
@@ -613,13 +779,13 @@ const TrellisPath doConsensusDecoding(Manager& manager, TrellisPathList& nBestLi
       comps[2*i+1] = max(hyp_length-i,0);
     }
 
-    for (map<Phrase,int>::const_iterator hyp_iter = ngrams.begin();
-         hyp_iter != ngrams.end(); ++hyp_iter) {
-      map<Phrase,float>::const_iterator ref_iter = ngramExpectations.find(hyp_iter->first);
-      if (ref_iter != ngramExpectations.end()) {
-        comps[2*(hyp_iter->first.GetSize()-1)] += min(exp(ref_iter->second), (float)(hyp_iter->second));
+    for (size_t i = 0; i < ngrams.size(); ) {
+      size_t count = 1;
+      while (i + count < ngrams.size() && ngrams[i + count] == ngrams[i]) {
+        ++count;
       }
-
+      comps[2*(ngramExpectations.GetOrder(ngrams[i])-1)] += min(exp(ngramExpectations.GetLogProb(ngrams[i])), (float)count);
+      i += count;
     }
     comps[comps.size()-1] = ref_length;
     /*for (size_t i = 0; i < comps.size(); ++i) {
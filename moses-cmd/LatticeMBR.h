@@ -16,88 +16,104 @@
 #include "moses/Hypothesis.h"
 #include "moses/Manager.h"
 #include "moses/TrellisPathList.h"
+#include "util/probing_hash_table.hh"
 
 
 
 namespace MosesCmd
 {
 
-class Edge;
-
 typedef std::vector< const Moses::Hypothesis *> Lattice;
-typedef std::vector<const Edge*> Path;
-typedef std::map<Path, size_t> PathCounts;
-typedef std::map<Moses::Phrase, PathCounts > NgramHistory;
 
-class Edge
-{
-  const Moses::Hypothesis* m_tailNode;
-  const Moses::Hypothesis* m_headNode;
-  float m_score;
-  Moses::TargetPhrase m_targetPhrase;
-  NgramHistory m_ngrams;
+/** An edge of the pruned lattice. The head node is implied by its position in PrunedLattice::edges */
+struct LatticeEdge {
+  size_t tail;
+  float score;
+  const Moses::Phrase *words;
+};
 
+/**
+* The lattice that survives pruneLatticeFB, in flat arrays. Nodes are sorted by
+* increasing source coverage, node 0 is the empty hypothesis, and the incoming
+* edges of node i are edges[firstEdge[i]] to edges[firstEdge[i+1]-1].
+*/
+struct PrunedLattice {
+  std::vector<const Moses::Hypothesis*> nodes;
+  std::vector<bool> complete; //!< does the node cover the whole input
+  std::vector<LatticeEdge> edges;
+  std::vector<size_t> firstEdge;
+};
+
+/**
+* Words and n-grams of one pruned lattice, numbered densely, with the log posterior
+* (or log expected count) of each n-gram. An n-gram is interned from the id of its
+* prefix and its last word, so extending an n-gram by one word is a single probe.
+*/
+class NgramPosteriors
+{
 public:
-  Edge(const Moses::Hypothesis* from, const Moses::Hypothesis* to, float score, const Moses::TargetPhrase& targetPhrase) : m_tailNode(from), m_headNode(to), m_score(score), m_targetPhrase(targetPhrase) {
-    //cout << "Creating new edge from Node " << from->GetId() << ", to Node : " << to->GetId() << ", score: " << score << " phrase: " << targetPhrase << endl;
-  }
+  NgramPosteriors();
 
-  const Moses::Hypothesis* GetHeadNode() const {
-    return m_headNode;
-  }
+  size_t AddWord(const Moses::Word &word);
+  //! NOT_FOUND if the word is not in the lattice
+  size_t FindWord(const Moses::Word &word) const;
 
-  const Moses::Hypothesis* GetTailNode() const {
-    return m_tailNode;
-  }
+  //! prefix is NOT_FOUND for unigrams
+  size_t AddNgram(size_t prefix, size_t word);
+  size_t FindNgram(size_t prefix, size_t word) const;
 
-  float GetScore() const {
-    return m_score;
+  size_t GetSize() const {
+    return m_ngrams.size();
   }
-
-  size_t GetWordsSize() const {
-    return m_targetPhrase.GetSize();
+  size_t GetPrefix(size_t ngram) const {
+    return m_ngrams[ngram].prefix;
   }
-
-  const Moses::Phrase& GetWords() const {
-    return m_targetPhrase;
+  size_t GetWord(size_t ngram) const {
+    return m_ngrams[ngram].word;
   }
-
-  friend std::ostream& operator<< (std::ostream& out, const Edge& edge);
-
-  const NgramHistory&  GetNgrams(  std::map<const Moses::Hypothesis*, std::vector<Edge> > & incomingEdges) ;
-
-  bool operator < (const Edge & compare) const;
-
-  void GetPhraseSuffix(const Moses::Phrase& origPhrase, size_t lastN, Moses::Phrase& targetPhrase) const;
-
-  void storeNgramHistory(const Moses::Phrase& phrase, Path & path, size_t count = 1) {
-    m_ngrams[phrase][path]+= count;
+  size_t GetOrder(size_t ngram) const {
+    return m_ngrams[ngram].order;
   }
 
-};
-
-/**
-* Data structure to hold the ngram scores as we traverse the lattice. Maps (hypo,ngram) to score
-*/
-class NgramScores
-{
-public:
-  NgramScores() {}
-
-  /** logsum this score to the existing score */
-  void addScore(const Moses::Hypothesis* node, const Moses::Phrase& ngram, float score);
-
-  /** Iterate through ngrams for selected node */
-  typedef std::map<const Moses::Phrase*, float>::const_iterator NodeScoreIterator;
-  NodeScoreIterator nodeBegin(const Moses::Hypothesis* node);
-  NodeScoreIterator nodeEnd(const Moses::Hypothesis* node);
+  //! false for n-grams that are not on any complete path of the lattice
+  bool IsScored(size_t ngram) const;
+  float GetLogProb(size_t ngram) const {
+    return m_logProbs[ngram];
+  }
+  void SetLogProbs(std::vector<float> &logProbs) {
+    m_logProbs.swap(logProbs);
+  }
 
 private:
-  std::set<Moses::Phrase> m_ngrams;
-  std::map<const Moses::Hypothesis*, std::map<const Moses::Phrase*, float> > m_scores;
+  struct Entry {
+    typedef uint64_t Key;
+    uint64_t key;
+    size_t id;
+    Key GetKey() const {
+      return key;
+    }
+    void SetKey(Key to) {
+      key = to;
+    }
+  };
+  struct KeyHash {
+    uint64_t operator()(uint64_t key) const;
+  };
+  typedef util::AutoProbing<Entry, KeyHash> Table;
+
+  struct Ngram {
+    size_t prefix, word, order;
+  };
+
+  static uint64_t WordKey(const Moses::Word &word);
+  static uint64_t NgramKey(size_t prefix, size_t word);
+
+  Table m_wordIds, m_ngramIds;
+  size_t m_numWords;
+  std::vector<Ngram> m_ngrams;
+  std::vector<float> m_logProbs;
 };
 
-
 /** Holds a lattice mbr solution, and its scores */
 class LatticeMBRSolution
 {
@@ -118,7 +134,7 @@ public:
   }
 
   /** Initialise ngram scores */
-  void CalcScore(std::map<Moses::Phrase, float>& finalNgramScores, const std::vector<float>& thetas, float mapWeight);
+  void CalcScore(const NgramPosteriors& ngramPosteriors, const std::vector<float>& thetas, float mapWeight);
 
 private:
   std::vector<Moses::Word> m_words;
@@ -133,18 +149,21 @@ struct LatticeMBRSolutionComparator {
   }
 };
 
-void pruneLatticeFB(Lattice & connectedHyp, std::map < const Moses::Hypothesis*, std::set <const Moses::Hypothesis* > > & outgoingHyps, std::map<const Moses::Hypothesis*, std::vector<Edge> >& incomingEdges,
+void pruneLatticeFB(Lattice & connectedHyp, std::map < const Moses::Hypothesis*, std::set <const Moses::Hypothesis* > > & outgoingHyps, PrunedLattice& lattice,
                     const std::vector< float> & estimatedScores, const Moses::Hypothesis*, size_t edgeDensity,float scale);
 
 //Use the ngram scores to rerank the nbest list, return at most n solutions
 void getLatticeMBRNBest(Moses::Manager& manager, Moses::TrellisPathList& nBestList, std::vector<LatticeMBRSolution>& solutions, size_t n);
+void getLatticeMBRNBest(const NgramPosteriors& ngramPosteriors, Moses::TrellisPathList& nBestList, std::vector<LatticeMBRSolution>& solutions, size_t n);
 //calculate expectated ngram counts, clipping at 1 (ie calculating posteriors) if posteriors==true.
-void calcNgramExpectations(Lattice & connectedHyp, std::map<const Moses::Hypothesis*, std::vector<Edge> >& incomingEdges, std::map<Moses::Phrase,
-                           float>& finalNgramScores, bool posteriors);
+void calcNgramExpectations(const PrunedLattice & lattice, NgramPosteriors& ngramScores, bool posteriors);
+//prune the search graph of the manager with the given density and scale, then calculate the ngram expectations
+void calcNgramExpectations(Moses::Manager& manager, size_t edgeDensity, float scale, NgramPosteriors& ngramScores, bool posteriors);
 void GetOutputFactors(const Moses::TrellisPath &path, std::vector <Moses::Word> &translation);
 void extract_ngrams(const std::vector<Moses::Word >& sentence, std::map < Moses::Phrase, int >  & allngrams);
 bool ascendingCoverageCmp(const Moses::Hypothesis* a, const Moses::Hypothesis* b);
 std::vector<Moses::Word> doLatticeMBR(Moses::Manager& manager, Moses::TrellisPathList& nBestList);
+std::vector<Moses::Word> doLatticeMBR(const NgramPosteriors& ngramPosteriors, Moses::TrellisPathList& nBestList);
 const Moses::TrellisPath doConsensusDecoding(Moses::Manager& manager, Moses::TrellisPathList& nBestList);
 //std::vector<Moses::Word> doConsensusDecoding(Moses::Manager& manager, Moses::TrellisPathList& nBestList);
 
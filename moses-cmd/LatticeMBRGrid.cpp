@@ -46,6 +46,8 @@ POSSIBILITY OF SUCH DAMAGE.
 #include <stdexcept>
 #include <set>
 
+#include <boost/shared_ptr.hpp>
+
 #include "IOWrapper.h"
 #include "LatticeMBR.h"
 #include "moses/Manager.h"
@@ -185,6 +187,9 @@ int main(int argc, char* argv[])
     manager.ProcessSentence();
     TrellisPathList nBestList;
     manager.CalcNBest(nBestSize, nBestList,true);
+    //the ngram posteriors only depend on the pruning factor and the scale, so they are
+    //calculated once for each pair and reused for all values of p and r
+    map<pair<size_t,float>, boost::shared_ptr<NgramPosteriors> > posteriorsCache;
     //grid search
     for (vector<float>::const_iterator pi = pgrid.begin(); pi != pgrid.end(); ++pi) {
       float p = *pi;
@@ -199,7 +204,12 @@ int main(int argc, char* argv[])
             float scale = *scale_i;
             staticData.SetMBRScale(scale);
             cout << lineCount << " ||| " << p << " " << r << " " << prune << " " << scale << " ||| ";
-            vector<Word> mbrBestHypo = doLatticeMBR(manager,nBestList);
+            boost::shared_ptr<NgramPosteriors>& posteriors = posteriorsCache[make_pair(prune, scale)];
+            if (!posteriors) {
+              posteriors.reset(new NgramPosteriors());
+              calcNgramExpectations(manager, prune, scale, *posteriors, true);
+            }
+            vector<Word> mbrBestHypo = doLatticeMBR(*posteriors,nBestList);
             OutputBestHypo(mbrBestHypo, lineCount, staticData.GetReportSegmentation(),
                            staticData.GetReportAllFactors(),cout);
           }
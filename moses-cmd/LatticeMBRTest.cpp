@@ -0,0 +1,249 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#define BOOST_TEST_MODULE LatticeMBRTest
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "LatticeMBR.h"
+#include "moses/FactorCollection.h"
+#include "moses/Util.h"
+
+using namespace Moses;
+using namespace MosesCmd;
+using namespace std;
+
+namespace MosesCmd
+{
+extern size_t bleu_order;
+}
+
+namespace
+{
+
+typedef vector<string> Ngram;
+
+/** A lattice built by hand, with the ngram statistics of all its paths counted one by one */
+class TestLattice
+{
+public:
+  TestLattice(size_t numNodes) : m_outgoing(numNodes) {
+    m_lattice.nodes.assign(numNodes, NULL);
+    m_lattice.complete.assign(numNodes, false);
+  }
+
+  //! edges must go from a lower to a higher node
+  void AddEdge(size_t tail, size_t head, float score, const string &words) {
+    m_phrases.push_back(Phrase());
+    vector<string> tokens = Tokenize(words);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      Word word;
+      word.SetFactor(0, FactorCollection::Instance().AddFactor(tokens[i]));
+      m_phrases.back().AddWord(word);
+    }
+    Edge edge;
+    edge.tail = tail;
+    edge.head = head;
+    edge.score = score;
+    edge.words = tokens;
+    edge.phrase = &m_phrases.back();
+    m_outgoing[tail].push_back(m_edges.size());
+    m_edges.push_back(edge);
+  }
+
+  void SetComplete(size_t node) {
+    m_lattice.complete[node] = true;
+  }
+
+  //! the lattice in the form pruneLatticeFB creates
+  const PrunedLattice &GetLattice() {
+    const size_t numNodes = m_lattice.nodes.size();
+    m_lattice.edges.clear();
+    m_lattice.firstEdge.assign(1, 0);
+    for (size_t node = 0; node < numNodes; ++node) {
+      for (size_t e = 0; e < m_edges.size(); ++e) {
+        if (m_edges[e].head == node) {
+          LatticeEdge edge;
+          edge.tail = m_edges[e].tail;
+          edge.score = m_edges[e].score;
+          edge.words = m_edges[e].phrase;
+          m_lattice.edges.push_back(edge);
+        }
+      }
+      m_lattice.firstEdge.push_back(m_lattice.edges.size());
+    }
+    return m_lattice;
+  }
+
+  //! expected count, or posterior, of every ngram over all complete paths
+  map<Ngram, double> CountPaths(bool posteriors) const {
+    map<Ngram, double> scores;
+    double total = 0;
+    vector<string> words;
+    CountPaths(0, 0, words, posteriors, scores, total);
+    for (map<Ngram, double>::iterator it = scores.begin(); it != scores.end(); ++it) {
+      it->second /= total;
+    }
+    return scores;
+  }
+
+private:
+  struct Edge {
+    size_t tail, head;
+    float score;
+    vector<string> words;
+    const Phrase *phrase;
+  };
+
+  void CountPaths(size_t node, double score, vector<string> &words, bool posteriors,
+                  map<Ngram, double> &scores, double &total) const {
+    if (m_lattice.complete[node]) {
+      const double prob = exp(score);
+      total += prob;
+      map<Ngram, size_t> counts;
+      for (size_t start = 0; start < words.size(); ++start) {
+        for (size_t end = start; end < words.size() && end < start + bleu_order; ++end) {
+          ++counts[Ngram(words.begin() + start, words.begin() + end + 1)];
+        }
+      }
+      for (map<Ngram, size_t>::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+        scores[it->first] += prob * (posteriors ? 1 : it->second);
+      }
+    }
+    for (size_t i = 0; i < m_outgoing[node].size(); ++i) {
+      const Edge &edge = m_edges[m_outgoing[node][i]];
+      const size_t size = words.size();
+      words.insert(words.end(), edge.words.begin(), edge.words.end());
+      CountPaths(edge.head, score + edge.score, words, posteriors, scores, total);
+      words.resize(size);
+    }
+  }
+
+  PrunedLattice m_lattice;
+  vector<Edge> m_edges;
+  vector<vector<size_t> > m_outgoing;
+  deque<Phrase> m_phrases;
+};
+
+void CheckAgainstPaths(TestLattice &testLattice, bool posteriors)
+{
+  NgramPosteriors ngrams;
+  calcNgramExpectations(testLattice.GetLattice(), ngrams, posteriors);
+  const map<Ngram, double> expected = testLattice.CountPaths(posteriors);
+
+  for (map<Ngram, double>::const_iterator it = expected.begin(); it != expected.end(); ++it) {
+    const Ngram &words = it->first;
+    size_t ngram = NOT_FOUND;
+    for (size_t i = 0; i < words.size(); ++i) {
+      Word word;
+      word.SetFactor(0, FactorCollection::Instance().AddFactor(words[i]));
+      ngram = ngrams.FindNgram(ngram, ngrams.FindWord(word));
+      BOOST_REQUIRE(ngram != NOT_FOUND);
+    }
+    BOOST_REQUIRE(ngrams.IsScored(ngram));
+    BOOST_CHECK_MESSAGE(fabs(exp(ngrams.GetLogProb(ngram)) - it->second) < 1e-4,
+                        Join(" ", words) << ": " << exp(ngrams.GetLogProb(ngram)) << " != " << it->second);
+  }
+
+  size_t numScored = 0;
+  for (size_t ngram = 0; ngram < ngrams.GetSize(); ++ngram) {
+    numScored += ngrams.IsScored(ngram);
+  }
+  BOOST_CHECK_EQUAL(numScored, expected.size());
+}
+
+//! repeated words within edges, ngrams that span several edges, and empty edges. No path
+//! has an ngram twice further apart than its incoming edge, where posteriors are approximate
+void MakeLattice(TestLattice &lattice)
+{
+  lattice.AddEdge(0, 1, -0.5, "a a");
+  lattice.AddEdge(0, 1, -1.0, "a");
+  lattice.AddEdge(0, 2, -0.7, "b");
+  lattice.AddEdge(1, 3, -0.3, "c");
+  lattice.AddEdge(1, 3, -1.2, "a c");
+  lattice.AddEdge(1, 4, -2.0, "");
+  lattice.AddEdge(2, 3, -0.4, "a b a");
+  lattice.AddEdge(2, 4, -0.9, "a");
+  lattice.AddEdge(3, 5, -0.2, "c");
+  lattice.AddEdge(3, 5, -0.6, "a a");
+  lattice.AddEdge(3, 6, -0.8, "c b a");
+  lattice.AddEdge(4, 5, -0.3, "b a c");
+  lattice.AddEdge(4, 5, -1.5, "");
+  lattice.SetComplete(5);
+  lattice.SetComplete(6);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(lattice_mbr)
+
+BOOST_AUTO_TEST_CASE(expectations_match_paths)
+{
+  TestLattice lattice(7);
+  MakeLattice(lattice);
+  CheckAgainstPaths(lattice, false);
+}
+
+BOOST_AUTO_TEST_CASE(posteriors_match_paths)
+{
+  TestLattice lattice(7);
+  MakeLattice(lattice);
+  CheckAgainstPaths(lattice, true);
+}
+
+// "a c" is on every path, once or twice, but "a a" is followed by "c" only once
+BOOST_AUTO_TEST_CASE(suffix_of_repeated_words)
+{
+  TestLattice lattice(3);
+  lattice.AddEdge(0, 1, 0, "a a");
+  lattice.AddEdge(1, 2, 0, "c");
+  lattice.SetComplete(2);
+  CheckAgainstPaths(lattice, false);
+  CheckAgainstPaths(lattice, true);
+}
+
+// "b a c" ends where the last "a" of the middle edge does, not the first one
+BOOST_AUTO_TEST_CASE(crossing_ngram_ends_at_last_word)
+{
+  TestLattice lattice(4);
+  lattice.AddEdge(0, 1, 0, "b");
+  lattice.AddEdge(1, 2, 0, "a b a");
+  lattice.AddEdge(2, 3, 0, "c");
+  lattice.SetComplete(3);
+  CheckAgainstPaths(lattice, false);
+  CheckAgainstPaths(lattice, true);
+}
+
+// on one path, "a a a" crosses into the last edge twice
+BOOST_AUTO_TEST_CASE(posterior_of_periodic_ngram)
+{
+  TestLattice lattice(3);
+  lattice.AddEdge(0, 1, 0, "a a");
+  lattice.AddEdge(0, 1, -1, "b a");
+  lattice.AddEdge(1, 2, 0, "a a");
+  lattice.SetComplete(2);
+  CheckAgainstPaths(lattice, true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
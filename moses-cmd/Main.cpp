@@ -30,6 +30,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <boost/iostreams/filter/gzip.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 
+#include <algorithm>
 #include <exception>
 #include <fstream>
 #include <sstream>
@@ -94,6 +95,7 @@ public:
                   OutputCollector* detailedTranslationCollector,
                   OutputCollector* alignmentInfoCollector,
                   OutputCollector* unknownsCollector,
+                  OutputCollector* metricsCollector,
                   bool outputSearchGraphSLF,
                   bool outputSearchGraphHypergraph) :
     m_source(source), m_lineNumber(lineNumber),
@@ -103,6 +105,7 @@ public:
     m_detailedTranslationCollector(detailedTranslationCollector),
     m_alignmentInfoCollector(alignmentInfoCollector),
     m_unknownsCollector(unknownsCollector),
+    m_metricsCollector(metricsCollector),
     m_outputSearchGraphSLF(outputSearchGraphSLF),
     m_outputSearchGraphHypergraph(outputSearchGraphHypergraph) {}
 
@@ -325,13 +328,14 @@ public:
             OutputAlignment(out, bestHypo);
           }
 
-          OutputAlignment(m_alignmentInfoCollector, m_lineNumber, bestHypo);
           IFVERBOSE(1) {
             debug << "BEST TRANSLATION: " << *bestHypo << endl;
           }
         } else {
           VERBOSE(1, "NO BEST TRANSLATION" << endl);
         }
+        // an empty line if there is no best hypothesis
+        OutputAlignment(m_alignmentInfoCollector, m_lineNumber, bestHypo);
 
         out << endl;
       }
@@ -353,6 +357,10 @@ public:
 
         // lattice MBR
         if (staticData.UseLatticeMBR()) {
+          // the solution is a word sequence, not a derivation, so there is no alignment
+          if (m_alignmentInfoCollector) {
+            m_alignmentInfoCollector->Write(m_lineNumber, "\n");
+          }
           if (m_nbestCollector) {
             //lattice mbr nbest
             vector<LatticeMBRSolution> solutions;
@@ -410,10 +418,23 @@ public:
     if (m_nbestCollector && !staticData.UseLatticeMBR()) {
       TrellisPathList nBestList;
       ostringstream out;
+      manager.GetSentenceStats().StartTimeNBest();
       manager.CalcNBest(staticData.GetNBestSize(), nBestList,staticData.GetDistinctNBest());
+      manager.GetSentenceStats().StopTimeNBest();
       OutputNBest(out, nBestList, staticData.GetOutputFactorOrder(), m_lineNumber,
                   staticData.GetReportSegmentation());
       m_nbestCollector->Write(m_lineNumber, out.str());
+    } else if (m_nbestCollector && !m_outputCollector) {
+      // lattice MBR n-best list without 1-best output, which is where it is
+      // usually written
+      TrellisPathList nBestList;
+      manager.CalcNBest(staticData.GetMBRSize(), nBestList,true);
+      vector<LatticeMBRSolution> solutions;
+      size_t n  = min(staticData.GetMBRSize(), staticData.GetNBestSize());
+      getLatticeMBRNBest(manager,nBestList,solutions,n);
+      ostringstream out;
+      OutputLatticeMBRNBest(out, solutions,m_lineNumber);
+      m_nbestCollector->Write(m_lineNumber, out.str());
     }
 
     //lattice samples
@@ -445,6 +466,13 @@ public:
       m_unknownsCollector->Write(m_lineNumber, out.str());
     }
 
+    // per-sentence metrics
+    if (m_metricsCollector) {
+      ostringstream out;
+      manager.GetSentenceStats().OutputMetrics(out, m_lineNumber);
+      m_metricsCollector->Write(m_lineNumber, out.str());
+    }
+
     // report additional statistics
     manager.CalcDecoderStatistics();
     VERBOSE(1, "Line " << m_lineNumber << ": Additional reporting took " << additionalReportingTime << " seconds total" << endl);
@@ -469,6 +497,7 @@ private:
   OutputCollector* m_detailedTranslationCollector;
   OutputCollector* m_alignmentInfoCollector;
   OutputCollector* m_unknownsCollector;
+  OutputCollector* m_metricsCollector;
   bool m_outputSearchGraphSLF;
   bool m_outputSearchGraphHypergraph;
   std::ofstream *m_alignmentStream;
@@ -724,8 +753,9 @@ int main(int argc, char** argv)
     }
 
     // initialize stram for word alignment between input and output
+    // note: the alignments are written with the 1-best translation
     auto_ptr<OutputCollector> alignmentInfoCollector;
-    if (!staticData.GetAlignmentOutputFile().empty()) {
+    if (output1best && !staticData.GetAlignmentOutputFile().empty()) {
       alignmentInfoCollector.reset(new OutputCollector(ioWrapper->GetAlignmentOutputStream()));
     }
 
@@ -741,8 +771,46 @@ int main(int argc, char** argv)
       unknownsCollector.reset(new OutputCollector(unknownsStream.get()));
     }
 
+    //initialise stream for per-sentence metrics
+    auto_ptr<OutputCollector> metricsCollector;
+    auto_ptr<ofstream> metricsStream;
+    if (!staticData.GetSentenceMetricsFile().empty()) {
+      metricsStream.reset(new ofstream(staticData.GetSentenceMetricsFile().c_str()));
+      if (!metricsStream->good()) {
+        TRACE_ERR("Unable to open " << staticData.GetSentenceMetricsFile() << " for sentence metrics");
+        exit(1);
+      }
+      metricsCollector.reset(new OutputCollector(metricsStream.get()));
+    }
+
+    vector<OutputCollector*> collectors;
+    collectors.push_back(outputCollector.get());
+    collectors.push_back(nbestCollector.get());
+    collectors.push_back(latticeSamplesCollector.get());
+    collectors.push_back(wordGraphCollector.get());
+    collectors.push_back(searchGraphCollector.get());
+    collectors.push_back(detailedTranslationCollector.get());
+    collectors.push_back(alignmentInfoCollector.get());
+    collectors.push_back(unknownsCollector.get());
+    collectors.push_back(metricsCollector.get());
+    collectors.erase(std::remove(collectors.begin(), collectors.end(), (OutputCollector*) NULL), collectors.end());
+    for (size_t i = 0; i < collectors.size(); ++i) {
+      collectors[i]->SetFirstSourceId(staticData.GetStartTranslationId());
+    }
+
 #ifdef WITH_THREADS
     ThreadPool pool(staticData.ThreadCount());
+    if (staticData.ThreadCount() > 1) {
+      // decoding threads only hand over their output, one thread per stream writes it
+      for (size_t i = 0; i < collectors.size(); ++i) {
+        collectors[i]->SetReorderWindow(staticData.GetOutputReorderWindow());
+        collectors[i]->StartWriterThread();
+      }
+    }
+    // read ahead and translate the longest sentences first, so that they
+    // don't hold up the end of the run
+    const size_t lookahead = staticData.ThreadCount() > 1 ? staticData.GetScheduleLookahead() : 0;
+    vector<pair<size_t, Task*> > batch;
 #endif
 
     // main loop over set of input sentences
@@ -752,6 +820,13 @@ int main(int argc, char** argv)
       IFVERBOSE(1) {
         ResetUserTime();
       }
+#ifdef WITH_THREADS
+      // don't run ahead of a slow sentence by more than the reorder window.
+      // every collector gets one record per line, so none of them waits forever
+      for (size_t i = 0; i < collectors.size(); ++i) {
+        collectors[i]->WaitForWindow(lineCount);
+      }
+#endif
       // set up task of translating one sentence
       TranslationTask* task =
         new TranslationTask(lineCount,source, outputCollector.get(),
@@ -762,11 +837,15 @@ int main(int argc, char** argv)
                             detailedTranslationCollector.get(),
                             alignmentInfoCollector.get(),
                             unknownsCollector.get(),
+                            metricsCollector.get(),
                             staticData.GetOutputSearchGraphSLF(),
                             staticData.GetOutputSearchGraphHypergraph());
       // execute task
 #ifdef WITH_THREADS
-      pool.Submit(task);
+      batch.push_back(make_pair(source->GetSize(), static_cast<Task*>(task)));
+      if (batch.size() >= lookahead) {
+        pool.SubmitBatch(batch);
+      }
 #else
       task->Run();
       delete task;
@@ -778,9 +857,15 @@ int main(int argc, char** argv)
 
     // we are done, finishing up
 #ifdef WITH_THREADS
+    pool.SubmitBatch(batch);
     pool.Stop(true); //flush remaining jobs
+    for (size_t i = 0; i < collectors.size(); ++i) {
+      collectors[i]->StopWriterThread();
+    }
 #endif
 
+    IFVERBOSE(1) PhraseDictionary::PrintCacheStats(std::cerr);
+
     delete ioWrapper;
     FeatureFunction::Destroy();
 
@@ -128,8 +128,10 @@ void PrintTranslationAnalysis(std::ostream &os, const Hypothesis* hypo)
       os << "\tdropped=" << *dwi << std::endl;
     }
   }
+  ScoreComponentCollection scoreBreakdown;
+  translationPath.back()->AddScoreBreakdown(scoreBreakdown);
   os << std::endl << "SCORES (UNWEIGHTED/WEIGHTED): ";
-  os << translationPath.back()->GetScoreBreakdown();
+  os << scoreBreakdown;
   os << " weighted(TODO)";
   os << std::endl;
 }
@@ -409,6 +409,19 @@ BitmapContainer::InitializeEdges()
   BackwardsEdgeSet::iterator iter = m_edges.begin();
   BackwardsEdgeSet::iterator iterEnd = m_edges.end();
 
+  // every edge starts with its top-left corner, fetch them all at once
+  std::vector<std::pair<const Hypothesis*, const TranslationOption*> > corners;
+  for (iter = m_edges.begin(); iter != iterEnd; ++iter) {
+    const BackwardsEdge &edge = **iter;
+    if (!edge.m_hypotheses.empty() && edge.m_translations.size()) {
+      corners.push_back(std::make_pair(edge.m_hypotheses[0], edge.m_translations.Get(0)));
+    }
+  }
+  if (corners.size() > 1) {
+    Hypothesis::PrefetchExpansions(corners);
+  }
+
+  iter = m_edges.begin();
   while (iter != iterEnd) {
     BackwardsEdge *edge = *iter;
     edge->Initialize();
@@ -0,0 +1,109 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+#include "moses/TranslationModel/PhraseDictionary.h"
+
+using namespace Moses;
+
+BOOST_AUTO_TEST_SUITE(cache_coll)
+
+BOOST_AUTO_TEST_CASE(find_and_insert)
+{
+  CacheColl cache;
+  const TargetPhraseCollection *ret = NULL;
+  BOOST_CHECK(!cache.Find(1, ret));
+
+  TargetPhraseCollection *coll = new TargetPhraseCollection;
+  BOOST_CHECK_EQUAL(cache.Insert(1, coll), coll);
+  BOOST_CHECK(cache.Find(1, ret));
+  BOOST_CHECK_EQUAL(ret, coll);
+
+  // the first insertion wins
+  BOOST_CHECK_EQUAL(cache.Insert(1, new TargetPhraseCollection), coll);
+
+  // no translations is an entry too
+  BOOST_CHECK(cache.Insert(2, NULL) == NULL);
+  BOOST_CHECK(cache.Find(2, ret));
+  BOOST_CHECK(ret == NULL);
+
+  BOOST_CHECK_EQUAL(cache.GetSize(), 2);
+  BOOST_CHECK_EQUAL(cache.GetHits(), 2);
+  BOOST_CHECK_EQUAL(cache.GetMisses(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(reduce_keeps_recently_used)
+{
+  CacheColl cache;
+  const TargetPhraseCollection *ret;
+  for (size_t i = 0; i < 1000; ++i) {
+    cache.Insert(i, new TargetPhraseCollection);
+  }
+  for (size_t i = 0; i < 1000; i += 10) {
+    cache.Find(i, ret);
+  }
+  cache.ReleasePins();
+
+  cache.Reduce(2000);
+  BOOST_CHECK_EQUAL(cache.GetSize(), 1000);
+
+  cache.Reduce(320);
+  BOOST_CHECK(cache.GetSize() <= 160);
+  size_t kept = 0;
+  for (size_t i = 0; i < 1000; i += 10) {
+    kept += cache.Find(i, ret);
+  }
+  BOOST_CHECK_EQUAL(kept, 100);
+}
+
+#ifdef WITH_THREADS
+namespace
+{
+void FindMissing(CacheColl *cache, size_t *misses)
+{
+  const TargetPhraseCollection *ret;
+  cache->Find(42, ret);
+  *misses = cache->GetThreadMisses();
+}
+}
+
+BOOST_AUTO_TEST_CASE(thread_counts)
+{
+  CacheColl cache;
+  const TargetPhraseCollection *ret;
+  cache.Insert(1, new TargetPhraseCollection);
+  cache.Find(1, ret);
+  cache.Find(2, ret);
+
+  size_t otherMisses = 0;
+  boost::thread other(FindMissing, &cache, &otherMisses);
+  other.join();
+
+  BOOST_CHECK_EQUAL(otherMisses, 1);
+  BOOST_CHECK_EQUAL(cache.GetThreadHits(), 1);
+  BOOST_CHECK_EQUAL(cache.GetThreadMisses(), 1);
+  BOOST_CHECK_EQUAL(cache.GetMisses(), 2);
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
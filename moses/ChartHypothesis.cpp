@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <vector>
+#include <boost/functional/hash.hpp>
 #include "ChartHypothesis.h"
 #include "RuleCubeItem.h"
 #include "ChartCell.h"
@@ -54,6 +55,7 @@ ChartHypothesis::ChartHypothesis(const ChartTranslationOptions &transOpt,
   ,m_ffStates(StatefulFeatureFunction::GetStatefulFeatureFunctions().size())
   ,m_arcList(NULL)
   ,m_winningHypo(NULL)
+  ,m_recombinationHash(0)
   ,m_manager(manager)
   ,m_id(manager.GetNextHypoId())
 {
@@ -64,6 +66,7 @@ ChartHypothesis::ChartHypothesis(const ChartTranslationOptions &transOpt,
   for (iter = childEntries.begin(); iter != childEntries.end(); ++iter) {
     m_prevHypos.push_back(iter->GetHypothesis());
   }
+  manager.GetSentenceStats().AddCreated();
 }
 
 // Intended to be used by ChartKBestExtractor only.  This creates a mock
@@ -75,6 +78,7 @@ ChartHypothesis::ChartHypothesis(const ChartHypothesis &pred,
   ,m_totalScore(pred.m_totalScore)
   ,m_arcList(NULL)
   ,m_winningHypo(NULL)
+  ,m_recombinationHash(0)
   ,m_manager(pred.m_manager)
   ,m_id(pred.m_manager.GetNextHypoId())
 {
@@ -160,6 +164,9 @@ Phrase ChartHypothesis::GetOutputPhrase() const
 */
 int ChartHypothesis::RecombineCompare(const ChartHypothesis &compare) const
 {
+  if (m_recombinationHash != compare.m_recombinationHash)
+    return (m_recombinationHash < compare.m_recombinationHash) ? -1 : +1;
+
   int comp = 0;
 
   for (unsigned i = 0; i < m_ffStates.size(); ++i) {
@@ -212,6 +219,11 @@ void ChartHypothesis::Evaluate()
     }
   }
 
+  m_recombinationHash = 0;
+  for (unsigned i = 0; i < m_ffStates.size(); ++i) {
+    boost::hash_combine(m_recombinationHash, m_ffStates[i] ? m_ffStates[i]->hash() : 0);
+  }
+
   m_totalScore	= m_scoreBreakdown.GetWeightedScore();
 }
 
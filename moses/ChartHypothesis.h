@@ -63,6 +63,7 @@ protected:
 
   ChartArcList 					*m_arcList; /*! all arcs that end at the same trellis point as this hypothesis */
   const ChartHypothesis 	*m_winningHypo;
+  size_t m_recombinationHash; /*! hash over all feature function states, set by Evaluate() */
 
   std::vector<const ChartHypothesis*> m_prevHypos; // always sorted by source position?
 
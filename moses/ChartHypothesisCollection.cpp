@@ -91,7 +91,7 @@ bool ChartHypothesisCollection::AddHypothesis(ChartHypothesis *hypo, ChartManage
   UTIL_THROW_IF2(iterExisting == m_hypos.end(),
 		  "Adding a hypothesis should have returned a valid iterator");
 
-  //StaticData::Instance().GetSentenceStats().AddRecombination(*hypo, **iterExisting);
+  manager.GetSentenceStats().AddRecombination();
 
   // found existing hypo with same target ending.
   // keep the best 1
@@ -34,6 +34,14 @@
 #include "TreeInput.h"
 #include "moses/FF/WordPenaltyProducer.h"
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/once.hpp>
+#include <boost/thread/tss.hpp>
+#include "ThreadPool.h"
+#endif
+
 using namespace std;
 using namespace Moses;
 
@@ -41,6 +49,55 @@ namespace Moses
 {
 extern bool g_mosesDebug;
 
+#ifdef WITH_THREADS
+namespace
+{
+boost::once_flag s_cellPoolOnce = BOOST_ONCE_INIT;
+boost::scoped_ptr<ThreadPool> s_cellPool;
+
+void CreateCellPool()
+{
+  const size_t threads = StaticData::Instance().GetChartCellThreads();
+  if (threads > 1) {
+    s_cellPool.reset(new ThreadPool(threads));
+  }
+}
+
+//! threads that all sentences share to decode chart cells, NULL if there are none
+ThreadPool *GetCellPool()
+{
+  boost::call_once(CreateCellPool, s_cellPoolOnce);
+  return s_cellPool.get();
+}
+
+void KeepStats(SentenceStats *) {}
+
+//! counts of the cell job running in this thread, NULL outside of cell jobs
+boost::thread_specific_ptr<SentenceStats> s_cellStats(KeepStats);
+
+//! make stats the target of ChartManager::GetSentenceStats() in this thread
+class CellStatsScope
+{
+public:
+  explicit CellStatsScope(SentenceStats &stats)
+    :m_previous(s_cellStats.get()) {
+    s_cellStats.reset(&stats);
+  }
+  ~CellStatsScope() {
+    s_cellStats.reset(m_previous);
+  }
+private:
+  SentenceStats *m_previous;
+};
+}
+#endif
+
+ChartManager::CellWorkspace::CellWorkspace(InputType const& source)
+  :transOptList(StaticData::Instance().GetRuleLimit(), source)
+  ,stats(source)
+{
+}
+
 /* constructor. Initialize everything prior to decoding a particular sentence.
  * \param source the sentence to be decoded
  * \param system which particular set of models to use.
@@ -70,38 +127,34 @@ void ChartManager::ProcessSentence()
   VERBOSE(1,"Translating: " << m_source << endl);
 
   ResetSentenceStats(m_source);
+  GetSentenceStats().StartCacheStats();
+  GetSentenceStats().StartTimeSearch();
 
   VERBOSE(2,"Decoding: " << endl);
   //ChartHypothesis::ResetHypoCount();
 
   AddXmlChartOptions();
 
-  // MAIN LOOP
   size_t size = m_source.GetSize();
-  for (int startPos = size-1; startPos >= 0; --startPos) {
-    for (size_t width = 1; width <= size-startPos; ++width) {
-      size_t endPos = startPos + width - 1;
-      WordsRange range(startPos, endPos);
-
-      // create trans opt
-      m_translationOptionList.Clear();
-      m_parser.Create(range, m_translationOptionList);
-      m_translationOptionList.ApplyThreshold();
-
-      const InputPath &inputPath = m_parser.GetInputPath(range);
-      m_translationOptionList.Evaluate(m_source, inputPath);
-
-      // decode
-      ChartCell &cell = m_hypoStackColl.Get(range);
-      cell.ProcessSentence(m_translationOptionList, m_hypoStackColl);
-
-      m_translationOptionList.Clear();
-      cell.PruneToSize();
-      cell.CleanupArcList();
-      cell.SortHypotheses();
+#ifdef WITH_THREADS
+  ThreadPool *pool = GetCellPool();
+  if (pool && m_parser.EnableParallelLookup()) {
+    ProcessCellsByWidth(*pool);
+  } else
+#endif
+  {
+    // MAIN LOOP
+    for (int startPos = size-1; startPos >= 0; --startPos) {
+      for (size_t width = 1; width <= size-startPos; ++width) {
+        size_t endPos = startPos + width - 1;
+        ProcessCell(WordsRange(startPos, endPos), m_translationOptionList);
+      }
     }
   }
 
+  GetSentenceStats().StopTimeSearch();
+  GetSentenceStats().StopCacheStats();
+
   IFVERBOSE(1) {
 
     for (size_t startPos = 0; startPos < size; ++startPos) {
@@ -123,6 +176,80 @@ void ChartManager::ProcessSentence()
   }
 }
 
+//! collect the rules of one span and decode its cell. All narrower cells inside the span must be done
+void ChartManager::ProcessCell(const WordsRange &range, ChartTranslationOptionList &transOptList)
+{
+  // create trans opt
+  GetSentenceStats().StartTimeCollectOpts();
+  transOptList.Clear();
+  m_parser.Create(range, transOptList);
+  transOptList.ApplyThreshold();
+
+  const InputPath &inputPath = GetParser().GetInputPath(range.GetStartPos(), range.GetEndPos());
+  transOptList.Evaluate(m_source, inputPath);
+  GetSentenceStats().StopTimeCollectOpts();
+
+  // decode
+  ChartCell &cell = m_hypoStackColl.Get(range);
+  cell.ProcessSentence(transOptList, m_hypoStackColl);
+
+  transOptList.Clear();
+  cell.PruneToSize();
+  cell.CleanupArcList();
+  cell.SortHypotheses();
+}
+
+#ifdef WITH_THREADS
+/** decode the cells of each span width concurrently. A cell only depends on
+ *  narrower cells, so every width waits for the one before. Each cell gets
+ *  the same rules, in the same order, as in the main loop, so the
+ *  hypotheses are the same, only their ids are handed out in another order.
+ */
+void ChartManager::ProcessCellsByWidth(ThreadPool &pool)
+{
+  const size_t size = m_source.GetSize();
+  while (m_cellWorkspaces.size() < size) {
+    m_cellWorkspaces.push_back(new CellWorkspace(m_source));
+  }
+
+  for (size_t width = 1; width <= size; ++width) {
+    TaskGroup group(pool);
+    for (size_t startPos = 0; startPos + width <= size; ++startPos) {
+      WordsRange range(startPos, startPos + width - 1);
+      group.Submit(boost::bind(&ChartManager::ProcessCellInWorkspace
+                               , this, range, boost::ref(m_cellWorkspaces[startPos])));
+    }
+    group.Wait();
+  }
+
+  size_t peakArenaBytes = 0;
+  for (size_t startPos = 0; startPos < size; ++startPos) {
+    const CellWorkspace &workspace = m_cellWorkspaces[startPos];
+    GetSentenceStats().AddCounts(workspace.stats);
+    peakArenaBytes += workspace.arena.GetPeakBytesInUse();
+  }
+  GetSentenceStats().SetPeakArenaBytes(peakArenaBytes);
+}
+
+void ChartManager::ProcessCellInWorkspace(const WordsRange &range, CellWorkspace &workspace)
+{
+  SentenceArena::Scope arenaScope(workspace.arena);
+  CellStatsScope statsScope(workspace.stats);
+  ProcessCell(range, workspace.transOptList);
+}
+#endif
+
+SentenceStats& ChartManager::GetSentenceStats() const
+{
+#ifdef WITH_THREADS
+  SentenceStats *cellStats = s_cellStats.get();
+  if (cellStats) {
+    return *cellStats;
+  }
+#endif
+  return *m_sentenceStats;
+}
+
 /** add specific translation options and hypotheses according to the XML override translation scheme.
  *  Doesn't seem to do anything about walls and zones.
  *  @todo check walls & zones. Check that the implementation doesn't leak, xml options sometimes does if you're not careful
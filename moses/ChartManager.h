@@ -28,11 +28,16 @@
 #include "InputType.h"
 #include "WordsRange.h"
 #include "SentenceStats.h"
+#include "SentenceArena.h"
 #include "ChartTranslationOptionList.h"
 #include "ChartParser.h"
 #include "ChartKBestExtractor.h"
 
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/shared_ptr.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
 
 namespace Moses
 {
@@ -42,6 +47,7 @@ class ChartTrellisDetourQueue;
 class ChartTrellisNode;
 class ChartTrellisPath;
 class ChartTrellisPathList;
+class ThreadPool;
 
 /** Holds everything you need to decode 1 sentence with the hierachical/syntax decoder
  */
@@ -55,16 +61,38 @@ private:
                                  const ChartTrellisNode &,
                                  ChartTrellisDetourQueue &);
 
+  /** what the cell jobs of one start position use when the cells of a span
+   *  width are decoded concurrently. Each cell is decoded by one job, and
+   *  no two jobs of a width share a start position.
+   */
+  struct CellWorkspace {
+    CellWorkspace(InputType const& source);
+
+    SentenceArena arena; /**< feature states of the hypotheses in the cells at this start position */
+    ChartTranslationOptionList transOptList;
+    SentenceStats stats; /**< counts of the jobs, added to the sentence once decoding is done */
+  };
+
   InputType const& m_source; /**< source sentence to be translated */
+  boost::ptr_vector<CellWorkspace> m_cellWorkspaces; /**< must outlive m_hypoStackColl, which holds states from their arenas */
   ChartCellCollection m_hypoStackColl;
   std::auto_ptr<SentenceStats> m_sentenceStats;
   clock_t m_start; /**< starting time, used for logging */
   unsigned m_hypothesisId; /* For handing out hypothesis ids to ChartHypothesis */
+#ifdef WITH_THREADS
+  boost::mutex m_hypothesisIdMutex;
+#endif
 
   ChartParser m_parser;
 
   ChartTranslationOptionList m_translationOptionList; /**< pre-computed list of translation options for the phrases in this sentence */
 
+  void ProcessCell(const WordsRange &range, ChartTranslationOptionList &transOptList);
+#ifdef WITH_THREADS
+  void ProcessCellsByWidth(ThreadPool &pool);
+  void ProcessCellInWorkspace(const WordsRange &range, CellWorkspace &workspace);
+#endif
+
 public:
   ChartManager(InputType const& source);
   ~ChartManager();
@@ -82,10 +110,8 @@ public:
     return m_source;
   }
 
-  //! debug data collected when decoding sentence
-  SentenceStats& GetSentenceStats() const {
-    return *m_sentenceStats;
-  }
+  //! debug data collected when decoding sentence, or by the cell job running in this thread
+  SentenceStats& GetSentenceStats() const;
 
   //DIMw
   const ChartCellCollection& GetChartCellCollection() const {
@@ -105,6 +131,9 @@ public:
 
   //! contigious hypo id for each input sentence. For debugging purposes
   unsigned GetNextHypoId() {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_hypothesisIdMutex);
+#endif
     return m_hypothesisId++;
   }
 
@@ -45,6 +45,10 @@ ChartParserUnknown::~ChartParserUnknown()
 
 void ChartParserUnknown::Process(const Word &sourceWord, const WordsRange &range, ChartParserCallback &to)
 {
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+
   // unknown word, add as trans opt
   const StaticData &staticData = StaticData::Instance();
   const UnknownWordPenaltyProducer &unknownWordPenaltyProducer = UnknownWordPenaltyProducer::Instance();
@@ -133,29 +137,22 @@ void ChartParserUnknown::Process(const Word &sourceWord, const WordsRange &range
 
 ChartParser::ChartParser(InputType const &source, ChartCellCollectionBase &cells) :
   m_decodeGraphList(StaticData::Instance().GetDecodeGraphs()),
+  m_cells(cells),
   m_source(source)
 {
   const StaticData &staticData = StaticData::Instance();
 
   staticData.InitializeForInput(source);
   CreateInputPaths(m_source);
-
-  const std::vector<PhraseDictionary*> &dictionaries = PhraseDictionary::GetColl();
-  assert(dictionaries.size() == m_decodeGraphList.size());
-  m_ruleLookupManagers.reserve(dictionaries.size());
-  for (std::size_t i = 0; i < dictionaries.size(); ++i) {
-    const PhraseDictionary *dict = dictionaries[i];
-    PhraseDictionary *nonConstDict = const_cast<PhraseDictionary*>(dict);
-    std::size_t maxChartSpan = m_decodeGraphList[i]->GetMaxChartSpan();
-    ChartRuleLookupManager *lookupMgr = nonConstDict->CreateRuleLookupManager(*this, cells, maxChartSpan);
-    m_ruleLookupManagers.push_back(lookupMgr);
-  }
-
+  CreateRuleLookupManagers(m_ruleLookupManagers);
 }
 
 ChartParser::~ChartParser()
 {
   RemoveAllInColl(m_ruleLookupManagers);
+  for (size_t i = 0; i < m_startPosLookupManagers.size(); ++i) {
+    RemoveAllInColl(m_startPosLookupManagers[i]);
+  }
   StaticData::Instance().CleanUpAfterSentenceProcessing(m_source);
 
   InputPathMatrix::const_iterator iterOuter;
@@ -170,12 +167,52 @@ ChartParser::~ChartParser()
   }
 }
 
+void ChartParser::CreateRuleLookupManagers(std::vector<ChartRuleLookupManager*> &managers)
+{
+  const std::vector<PhraseDictionary*> &dictionaries = PhraseDictionary::GetColl();
+  assert(dictionaries.size() == m_decodeGraphList.size());
+  managers.reserve(dictionaries.size());
+  for (std::size_t i = 0; i < dictionaries.size(); ++i) {
+    const PhraseDictionary *dict = dictionaries[i];
+    PhraseDictionary *nonConstDict = const_cast<PhraseDictionary*>(dict);
+    std::size_t maxChartSpan = m_decodeGraphList[i]->GetMaxChartSpan();
+    ChartRuleLookupManager *lookupMgr = nonConstDict->CreateRuleLookupManager(*this, m_cells, maxChartSpan);
+    managers.push_back(lookupMgr);
+  }
+}
+
+bool ChartParser::EnableParallelLookup()
+{
+  if (!m_startPosLookupManagers.empty()) {
+    return true;
+  }
+
+  const size_t size = m_source.GetSize();
+  m_startPosLookupManagers.resize(size);
+  for (size_t startPos = 0; startPos < size; ++startPos) {
+    std::vector<ChartRuleLookupManager*> &managers = m_startPosLookupManagers[startPos];
+    CreateRuleLookupManagers(managers);
+    for (size_t i = 0; i < managers.size(); ++i) {
+      if (!managers[i]->SetSpanLocal()) {
+        for (size_t j = 0; j <= startPos; ++j) {
+          RemoveAllInColl(m_startPosLookupManagers[j]);
+        }
+        m_startPosLookupManagers.clear();
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 void ChartParser::Create(const WordsRange &wordsRange, ChartParserCallback &to)
 {
-  assert(m_decodeGraphList.size() == m_ruleLookupManagers.size());
+  const std::vector<ChartRuleLookupManager*> &ruleLookupManagers = m_startPosLookupManagers.empty()
+      ? m_ruleLookupManagers : m_startPosLookupManagers[wordsRange.GetStartPos()];
+  assert(m_decodeGraphList.size() == ruleLookupManagers.size());
 
   std::vector <DecodeGraph*>::const_iterator iterDecodeGraph;
-  std::vector <ChartRuleLookupManager*>::const_iterator iterRuleLookupManagers = m_ruleLookupManagers.begin();
+  std::vector <ChartRuleLookupManager*>::const_iterator iterRuleLookupManagers = ruleLookupManagers.begin();
   for (iterDecodeGraph = m_decodeGraphList.begin(); iterDecodeGraph != m_decodeGraphList.end(); ++iterDecodeGraph, ++iterRuleLookupManagers) {
     const DecodeGraph &decodeGraph = **iterDecodeGraph;
     assert(decodeGraph.GetSize() == 1);
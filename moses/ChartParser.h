@@ -27,6 +27,10 @@
 #include "StackVec.h"
 #include "InputPath.h"
 
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#endif
+
 namespace Moses
 {
 
@@ -53,6 +57,9 @@ public:
 private:
   std::vector<Phrase*> m_unksrcs;
   std::list<TargetPhraseCollection*> m_cacheTargetPhraseCollection;
+#ifdef WITH_THREADS
+  boost::mutex m_mutex; //!< spans of one width may be processed concurrently
+#endif
 };
 
 class ChartParser
@@ -63,6 +70,13 @@ public:
 
   void Create(const WordsRange &range, ChartParserCallback &to);
 
+  /** Give every start position its own span-local rule lookup managers, so
+   *  that Create() may be called concurrently for spans of the same width,
+   *  once all narrower spans are decoded. Returns false, and changes
+   *  nothing, if a rule table does not support span-local lookup.
+   */
+  bool EnableParallelLookup();
+
   //! the sentence being decoded
   //const Sentence &GetSentence() const;
   long GetTranslationId() const;
@@ -75,12 +89,15 @@ private:
   ChartParserUnknown m_unknown;
   std::vector <DecodeGraph*> m_decodeGraphList;
   std::vector<ChartRuleLookupManager*> m_ruleLookupManagers;
+  std::vector<std::vector<ChartRuleLookupManager*> > m_startPosLookupManagers; /**< one set per start position, see EnableParallelLookup() */
+  ChartCellCollectionBase &m_cells;
   InputType const& m_source; /**< source sentence to be translated */
 
   typedef std::vector< std::vector<InputPath*> > InputPathMatrix;
   InputPathMatrix	m_inputPathMatrix;
 
   void CreateInputPaths(const InputType &input);
+  void CreateRuleLookupManagers(std::vector<ChartRuleLookupManager*> &managers);
   InputPath &GetInputPath(size_t startPos, size_t endPos);
 
 };
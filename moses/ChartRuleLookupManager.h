@@ -69,6 +69,16 @@ public:
     size_t lastPos,  // last position to consider if using lookahead
     ChartParserCallback &outColl) = 0;
 
+  /** Switch to looking up every span on its own, reading only the chart
+   *  cells inside it. Spans of one width can then be looked up in any
+   *  order, and concurrently if each start position has its own manager.
+   *  Returns false if this manager needs the spans in the usual order
+   *  (start positions descending, widths ascending).
+   */
+  virtual bool SetSpanLocal() {
+    return false;
+  }
+
 private:
   //! Non-copyable: copy constructor and assignment operator not implemented.
   ChartRuleLookupManager(const ChartRuleLookupManager &);
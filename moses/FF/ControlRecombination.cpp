@@ -48,6 +48,16 @@ int ControlRecombinationState::Compare(const FFState& other) const
   }
 }
 
+size_t ControlRecombinationState::hash() const
+{
+  if (m_ff.GetType() == SameOutput) {
+    // the output phrases are compared word by word, see FFState::hash()
+    return m_outputPhrase.GetSize();
+  } else {
+    return boost::hash<const void*>()(m_hypo);
+  }
+}
+
 std::vector<float> ControlRecombination::DefaultWeights() const
 {
   UTIL_THROW_IF2(m_numScoreComponents,
@@ -1,9 +1,41 @@
+#include <cstdlib>
+
 #include "moses/FF/FFState.h"
+#include "moses/SentenceArena.h"
+#include "util/scoped.hh"
 
 namespace Moses
 {
 
+namespace
+{
+// every state is preceded by the arena it was allocated from (NULL for the
+// heap), padded so that the state itself stays aligned
+const std::size_t HeaderSize = SentenceArena::Alignment;
+}
+
 FFState::~FFState() {}
 
+void *FFState::operator new(std::size_t size)
+{
+  SentenceArena *arena = SentenceArena::GetCurrent();
+  void *block = arena
+                ? arena->Allocate(size + HeaderSize)
+                : util::MallocOrThrow(size + HeaderSize);
+  *static_cast<SentenceArena**>(block) = arena;
+  return static_cast<char*>(block) + HeaderSize;
 }
 
+void FFState::operator delete(void *ptr, std::size_t size)
+{
+  if (ptr == NULL) return;
+  void *block = static_cast<char*>(ptr) - HeaderSize;
+  SentenceArena *arena = *static_cast<SentenceArena**>(block);
+  if (arena) {
+    arena->Free(block, size + HeaderSize);
+  } else {
+    std::free(block);
+  }
+}
+
+}
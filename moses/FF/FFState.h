@@ -1,6 +1,7 @@
 #ifndef moses_FFState_h
 #define moses_FFState_h
 
+#include <cstddef>
 #include <vector>
 
 
@@ -12,6 +13,24 @@ class FFState
 public:
   virtual ~FFState();
   virtual int Compare(const FFState& other) const = 0;
+
+  /** Hash of the state, used to find recombination candidates quickly.
+   *  States for which Compare() returns 0 must have the same hash. The
+   *  default puts all states in one bucket, so Compare() decides alone.
+   *  Word::Compare() skips any factor that either word lacks, so words
+   *  that compare equal need not share factors: a state compared word by
+   *  word can hash how many words it holds, but not the words themselves.
+   */
+  virtual size_t hash() const {
+    return 0;
+  }
+
+  /** States are taken from the SentenceArena that is current in the calling
+   *  thread, or from the heap if there is none. Each state remembers where it
+   *  came from, so it may be deleted from anywhere.
+   */
+  static void *operator new(std::size_t size);
+  static void operator delete(void *ptr, std::size_t size);
 };
 
 class DummyState : public FFState
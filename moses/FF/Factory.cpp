@@ -158,6 +158,7 @@ FeatureRegistry::FeatureRegistry()
   MOSES_FNAME(PhrasePairFeature);
   MOSES_FNAME(LexicalReordering);
   MOSES_FNAME2("Generation", GenerationDictionary);
+  MOSES_FNAME2("GenerationMapped", GenerationDictionaryMapped);
   MOSES_FNAME(BleuScoreFeature);
   MOSES_FNAME2("Distortion", DistortionScoreProducer);
   MOSES_FNAME2("WordPenalty", WordPenaltyProducer);
@@ -55,6 +55,12 @@ public:
   virtual void Load() {
   }
 
+  //! features whose Load() has to finish before Load() of this one starts
+  //! when feature functions are loaded concurrently (load-threads)
+  virtual std::vector<const FeatureFunction*> GetLoadDependencies() const {
+    return std::vector<const FeatureFunction*>();
+  }
+
   static void ResetDescriptionCounts() {
     description_counts.clear();
   }
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <fstream>
 #include "GlobalLexicalModel.h"
 #include "moses/StaticData.h"
@@ -19,10 +20,10 @@ GlobalLexicalModel::GlobalLexicalModel(const std::string &line)
 
   // define bias word
   FactorCollection &factorCollection = FactorCollection::Instance();
-  m_bias = new Word();
+  Word bias;
   const Factor* factor = factorCollection.AddFactor( Input, m_inputFactorsVec[0], "**BIAS**" );
-  m_bias->SetFactor( m_inputFactorsVec[0], factor );
-
+  bias.SetFactor( m_inputFactorsVec[0], factor );
+  m_biasId = AddWord( m_inputVocab, bias );
 }
 
 void GlobalLexicalModel::SetParameter(const std::string& key, const std::string& value)
@@ -40,15 +41,20 @@ void GlobalLexicalModel::SetParameter(const std::string& key, const std::string&
 
 GlobalLexicalModel::~GlobalLexicalModel()
 {
-  // delete words in the hash data structure
-  DoubleHash::const_iterator iter;
-  for(iter = m_hash.begin(); iter != m_hash.end(); iter++ ) {
-    map< const Word*, float, WordComparer >::const_iterator iter2;
-    for(iter2 = iter->second.begin(); iter2 != iter->second.end(); iter2++ ) {
-      delete iter2->first; // delete input word
-    }
-    delete iter->first; // delete output word
+}
+
+Word GlobalLexicalModel::ProjectWord(const Word &word, const std::vector<FactorType> &factors)
+{
+  Word projected;
+  for (size_t i = 0 ; i < factors.size() ; i++) {
+    projected.SetFactor( factors[i], word[factors[i]] );
   }
+  return projected;
+}
+
+size_t GlobalLexicalModel::AddWord(Vocabulary &vocab, const Word &word)
+{
+  return vocab.insert( make_pair( word, vocab.size() ) ).first->second;
 }
 
 void GlobalLexicalModel::Load()
@@ -74,79 +80,85 @@ void GlobalLexicalModel::Load()
     }
 
     // create the output word
-    Word *outWord = new Word();
+    Word outWord;
     vector<string> factorString = Tokenize( token[0], factorDelimiter );
     for (size_t i=0 ; i < m_outputFactorsVec.size() ; i++) {
       const FactorDirection& direction = Output;
       const FactorType& factorType = m_outputFactorsVec[i];
       const Factor* factor = factorCollection.AddFactor( direction, factorType, factorString[i] );
-      outWord->SetFactor( factorType, factor );
+      outWord.SetFactor( factorType, factor );
     }
 
     // create the input word
-    Word *inWord = new Word();
+    Word inWord;
     factorString = Tokenize( token[1], factorDelimiter );
     for (size_t i=0 ; i < m_inputFactorsVec.size() ; i++) {
       const FactorDirection& direction = Input;
       const FactorType& factorType = m_inputFactorsVec[i];
       const Factor* factor = factorCollection.AddFactor( direction, factorType, factorString[i] );
-      inWord->SetFactor( factorType, factor );
+      inWord.SetFactor( factorType, factor );
     }
 
     // maximum entropy feature score
     float score = Scan<float>(token[2]);
 
-    // std::cerr << "storing word " << *outWord << " " << *inWord << " " << score << endl;
-
     // store feature in hash
-    DoubleHash::iterator keyOutWord = m_hash.find( outWord );
-    if( keyOutWord == m_hash.end() ) {
-      m_hash[outWord][inWord] = score;
-    } else { // already have hash for outword, delete the word to avoid leaks
-      (keyOutWord->second)[inWord] = score;
-      delete outWord;
-    }
+    const size_t outputId = AddWord( m_outputVocab, outWord );
+    const size_t inputId = AddWord( m_inputVocab, inWord );
+    m_weights[ WeightKey( outputId, inputId ) ] = score;
   }
 }
 
-void GlobalLexicalModel::InitializeForInput( Sentence const& in )
+void GlobalLexicalModel::InitializeForInput( InputType const& in )
 {
   m_local.reset(new ThreadLocalStorage);
-  m_local->input = &in;
+
+  // collect the distinct input words that have weights, each is scored once
+  vector<size_t> &inputIds = m_local->inputIds;
+  inputIds.push_back( m_biasId );
+  for(size_t inputIndex = 0; inputIndex < in.GetSize(); inputIndex++ ) {
+    const Word inputWord = ProjectWord( in.GetWord( inputIndex ), m_inputFactorsVec );
+    const Vocabulary::const_iterator entry = m_inputVocab.find( inputWord );
+    if ( entry != m_inputVocab.end()
+         && find( inputIds.begin(), inputIds.end(), entry->second ) == inputIds.end() ) {
+      inputIds.push_back( entry->second );
+    }
+  }
+}
+
+float GlobalLexicalModel::ScoreWord( size_t outputId ) const
+{
+  WordScoreCache &wordScores = m_local->wordScores;
+  const WordScoreCache::const_iterator query = wordScores.find( outputId );
+  if ( query != wordScores.end() ) {
+    return query->second;
+  }
+
+  const vector<size_t> &inputIds = m_local->inputIds;
+  float sum = 0;
+  for(size_t i = 0; i < inputIds.size(); i++ ) {
+    const WeightTable::const_iterator weight = m_weights.find( WeightKey( outputId, inputIds[i] ) );
+    if( weight != m_weights.end() ) {
+      sum += weight->second;
+    }
+  }
+  // Hal Daume says: 1/( 1 + exp [ - sum_i w_i * f_i ] )
+  const float score = FloorScore( log(1/(1+exp(-sum))) );
+  wordScores.insert( make_pair( outputId, score ) );
+  return score;
 }
 
 float GlobalLexicalModel::ScorePhrase( const TargetPhrase& targetPhrase ) const
 {
-  const Sentence& input = *(m_local->input);
   float score = 0;
   for(size_t targetIndex = 0; targetIndex < targetPhrase.GetSize(); targetIndex++ ) {
-    float sum = 0;
-    const Word& targetWord = targetPhrase.GetWord( targetIndex );
-    VERBOSE(2,"glm " << targetWord << ": ");
-    const DoubleHash::const_iterator targetWordHash = m_hash.find( &targetWord );
-    if( targetWordHash != m_hash.end() ) {
-      SingleHash::const_iterator inputWordHash = targetWordHash->second.find( m_bias );
-      if( inputWordHash != targetWordHash->second.end() ) {
-        VERBOSE(2,"*BIAS* " << inputWordHash->second);
-        sum += inputWordHash->second;
-      }
-
-      set< const Word*, WordComparer > alreadyScored; // do not score a word twice
-      for(size_t inputIndex = 0; inputIndex < input.GetSize(); inputIndex++ ) {
-        const Word& inputWord = input.GetWord( inputIndex );
-        if ( alreadyScored.find( &inputWord ) == alreadyScored.end() ) {
-          SingleHash::const_iterator inputWordHash = targetWordHash->second.find( &inputWord );
-          if( inputWordHash != targetWordHash->second.end() ) {
-            VERBOSE(2," " << inputWord << " " << inputWordHash->second);
-            sum += inputWordHash->second;
-          }
-          alreadyScored.insert( &inputWord );
-        }
-      }
-    }
-    // Hal Daume says: 1/( 1 + exp [ - sum_i w_i * f_i ] )
-    VERBOSE(2," p=" << FloorScore( log(1/(1+exp(-sum))) ) << endl);
-    score += FloorScore( log(1/(1+exp(-sum))) );
+    const Word targetWord = ProjectWord( targetPhrase.GetWord( targetIndex ), m_outputFactorsVec );
+    const Vocabulary::const_iterator entry = m_outputVocab.find( targetWord );
+    const float wordScore = ( entry != m_outputVocab.end() )
+                            ? ScoreWord( entry->second )
+                            : FloorScore( log(0.5f) ); // no weights, sum is 0
+    VERBOSE(2,"glm " << targetPhrase.GetWord( targetIndex ) << ": p=" << wordScore << endl);
+    score += wordScore;
   }
   return score;
 }
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <boost/unordered_map.hpp>
 #include "StatelessFeatureFunction.h"
 #include "moses/Factor.h"
 #include "moses/Phrase.h"
@@ -30,26 +31,35 @@ class InputType;
  * This is a implementation of Mauser et al., 2009's model that predicts
  * each output word from _all_ the input words. The intuition behind this
  * feature is that it uses context words for disambiguation
+ *
+ * Input and output words are numbered at load time and the weights are kept
+ * in one hash table keyed on the (output, input) id pair. For each sentence
+ * the distinct input ids are collected once, so scoring an output word is a
+ * sum over the weights of the active input words, and is memoised until the
+ * next sentence.
  */
 class GlobalLexicalModel : public StatelessFeatureFunction
 {
-  typedef std::map< const Word*, std::map< const Word*, float, WordComparer >, WordComparer > DoubleHash;
-  typedef std::map< const Word*, float, WordComparer > SingleHash;
-  typedef std::map< const TargetPhrase*, float > LexiconCache;
+  typedef boost::unordered_map< Word, size_t > Vocabulary;
+  typedef boost::unordered_map< uint64_t, float > WeightTable;
+  typedef boost::unordered_map< const TargetPhrase*, float > LexiconCache;
+  typedef boost::unordered_map< size_t, float > WordScoreCache;
 
   struct ThreadLocalStorage {
     LexiconCache cache;
-    const Sentence *input;
+    WordScoreCache wordScores;
+    std::vector<size_t> inputIds; //! distinct input word ids of the sentence, bias first
   };
 
 private:
-  DoubleHash m_hash;
+  Vocabulary m_inputVocab, m_outputVocab;
+  WeightTable m_weights;
 #ifdef WITH_THREADS
   boost::thread_specific_ptr<ThreadLocalStorage> m_local;
 #else
   std::auto_ptr<ThreadLocalStorage> m_local;
 #endif
-  Word *m_bias;
+  size_t m_biasId;
 
   FactorMask m_inputFactors, m_outputFactors;
   std::vector<FactorType> m_inputFactorsVec, m_outputFactorsVec;
@@ -57,6 +67,13 @@ private:
 
   void Load();
 
+  static Word ProjectWord(const Word &word, const std::vector<FactorType> &factors);
+  static size_t AddWord(Vocabulary &vocab, const Word &word);
+  static uint64_t WeightKey(size_t outputId, size_t inputId) {
+    return (static_cast<uint64_t>(outputId) << 32) | inputId;
+  }
+
+  float ScoreWord( size_t outputId ) const;
   float ScorePhrase( const TargetPhrase& targetPhrase ) const;
   float GetFromCacheOrScorePhrase( const TargetPhrase& targetPhrase ) const;
 
@@ -66,7 +83,7 @@ public:
 
   void SetParameter(const std::string& key, const std::string& value);
 
-  void InitializeForInput( Sentence const& in );
+  void InitializeForInput( InputType const& in );
 
   bool IsUseable(const FactorMask &mask) const;
 
@@ -173,6 +173,18 @@ int LexicalReorderingState::ComparePrevScores(const Scores *other) const
   return 0;
 }
 
+size_t LexicalReorderingState::HashPrevScores() const
+{
+  // NULL compares unequal to any scores, so give it a seed of its own
+  if (m_prevScore == NULL)
+    return 1;
+
+  size_t seed = 0;
+  for(size_t i = m_offset; i < m_offset + m_configuration.GetNumberOfTypes(); i++)
+    boost::hash_combine(seed, (*m_prevScore)[i]);
+  return seed;
+}
+
 bool PhraseBasedReorderingState::m_useFirstBackwardScore = true;
 
 PhraseBasedReorderingState::PhraseBasedReorderingState(const PhraseBasedReorderingState *prev, const TranslationOption &topt)
@@ -203,6 +215,15 @@ int PhraseBasedReorderingState::Compare(const FFState& o) const
   return 1;
 }
 
+size_t PhraseBasedReorderingState::hash() const
+{
+  size_t seed = hash_value(m_prevRange);
+  if (m_direction == LexicalReorderingConfiguration::Forward) {
+    boost::hash_combine(seed, HashPrevScores());
+  }
+  return seed;
+}
+
 LexicalReorderingState* PhraseBasedReorderingState::Expand(const TranslationOption& topt, Scores& scores) const
 {
   ReorderingType reoType;
@@ -301,6 +322,13 @@ int BidirectionalReorderingState::Compare(const FFState& o) const
     return m_forward->Compare(*other.m_forward);
 }
 
+size_t BidirectionalReorderingState::hash() const
+{
+  size_t seed = m_backward->hash();
+  boost::hash_combine(seed, m_forward->hash());
+  return seed;
+}
+
 LexicalReorderingState* BidirectionalReorderingState::Expand(const TranslationOption& topt, Scores& scores) const
 {
   LexicalReorderingState *newbwd = m_backward->Expand(topt, scores);
@@ -325,6 +353,11 @@ int HierarchicalReorderingBackwardState::Compare(const FFState& o) const
   return m_reoStack.Compare(other.m_reoStack);
 }
 
+size_t HierarchicalReorderingBackwardState::hash() const
+{
+  return m_reoStack.hash();
+}
+
 LexicalReorderingState* HierarchicalReorderingBackwardState::Expand(const TranslationOption& topt, Scores& scores) const
 {
 
@@ -418,6 +451,13 @@ int HierarchicalReorderingForwardState::Compare(const FFState& o) const
   return 1;
 }
 
+size_t HierarchicalReorderingForwardState::hash() const
+{
+  size_t seed = hash_value(m_prevRange);
+  boost::hash_combine(seed, HashPrevScores());
+  return seed;
+}
+
 // For compatibility with the phrase-based reordering model, scoring is one step delayed.
 // The forward model takes determines orientations heuristically as follows:
 //  mono:   if the next phrase comes after the conditioning phrase and
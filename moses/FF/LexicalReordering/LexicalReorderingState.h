@@ -112,6 +112,7 @@ protected:
   void CopyScores(Scores& scores, const TranslationOption& topt, ReorderingType reoType) const;
   void ClearScores(Scores& scores) const;
   int ComparePrevScores(const Scores *other) const;
+  size_t HashPrevScores() const;
 
   //constants for the different type of reorderings (corresponding to indexes in the table file)
   static const ReorderingType M = 0;  // monotonic
@@ -140,6 +141,7 @@ public:
   }
 
   virtual int Compare(const FFState& o) const;
+  virtual size_t hash() const;
   virtual LexicalReorderingState* Expand(const TranslationOption& topt, Scores& scores) const;
 };
 
@@ -156,6 +158,7 @@ public:
   PhraseBasedReorderingState(const PhraseBasedReorderingState *prev, const TranslationOption &topt);
 
   virtual int Compare(const FFState& o) const;
+  virtual size_t hash() const;
   virtual LexicalReorderingState* Expand(const TranslationOption& topt, Scores& scores) const;
 
   ReorderingType GetOrientationTypeMSD(WordsRange currRange) const;
@@ -177,6 +180,7 @@ public:
                                       const TranslationOption &topt, ReorderingStack reoStack);
 
   virtual int Compare(const FFState& o) const;
+  virtual size_t hash() const;
   virtual LexicalReorderingState* Expand(const TranslationOption& hypo, Scores& scores) const;
 
 private:
@@ -200,6 +204,7 @@ public:
   HierarchicalReorderingForwardState(const HierarchicalReorderingForwardState *prev, const TranslationOption &topt);
 
   virtual int Compare(const FFState& o) const;
+  virtual size_t hash() const;
   virtual LexicalReorderingState* Expand(const TranslationOption& hypo, Scores& scores) const;
 
 private:
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+
 #include "LexicalReorderingTable.h"
 #include "moses/InputFileStream.h"
 //#include "LVoc.h" //need IPhrase
@@ -8,6 +11,10 @@
 #include "moses/TargetPhrase.h"
 #include "moses/TargetPhraseCollection.h"
 
+#include "util/file.hh"
+#include "util/murmur_hash.hh"
+#include "util/tokenize_piece.hh"
+
 #if !defined WIN32 || defined __MINGW32__ || defined HAVE_CMPH
 #include "moses/TranslationModel/CompactPT/LexicalReorderingTableCompact.h"
 #endif
@@ -58,7 +65,10 @@ LexicalReorderingTable* LexicalReorderingTable::LoadAvailable(const std::string&
 #endif
   if(compactLexr)
     return compactLexr;
-  if(FileExists(filePath+".binlexr.idx")) {
+  if(FileExists(filePath+".mlexr")) {
+    //hashed table shared by all threads
+    return new LexicalReorderingTableMapped(filePath, f_factors, e_factors, c_factors);
+  } else if(FileExists(filePath+".binlexr.idx")) {
     //there exists a binary version use that
     return new LexicalReorderingTableTree(filePath, f_factors, e_factors, c_factors);
   } else {
@@ -710,5 +720,214 @@ void LexicalReorderingTableTree::Cache(const ConfusionNet& input){
 };
 */
 
+/*
+ * functions for LexicalReorderingTableMapped
+ */
+namespace
+{
+const char kMappedMagic[8] = {'m', 'l', 'e', 'x', 'r', '\0', '\0', '1'};
+// appended after each of the f, e and c phrases so that words cannot move between them
+const uint64_t kFieldEnd = 0x9ae16a3b2f90404fULL;
+
+inline uint64_t auxMixHash(uint64_t key, uint64_t value)
+{
+  uint64_t both[2] = {key, value};
+  return util::MurmurHash64A(both, sizeof(both));
+}
+
+// 0 marks an empty bucket
+inline uint64_t auxFinishKey(uint64_t key)
+{
+  return key ? key : 1;
+}
+
+// hash of the factors of one word, the same as auxHashToken of "a|b"
+uint64_t auxHashWord(const Word& word, const FactorList& factors)
+{
+  uint64_t hash = 0;
+  for(size_t i = 0; i < factors.size(); ++i) {
+    const Factor* factor = word[factors[i]];
+    StringPiece str = factor ? factor->GetString() : StringPiece();
+    hash = util::MurmurHash64A(str.data(), str.size(), hash);
+  }
+  return hash;
+}
+
+uint64_t auxHashToken(const StringPiece& token)
+{
+  uint64_t hash = 0;
+  for(util::TokenIter<util::SingleCharacter> it(token, '|'); it; ++it) {
+    hash = util::MurmurHash64A(it->data(), it->size(), hash);
+  }
+  return hash;
 }
 
+uint64_t auxHashPhrase(uint64_t key, const Phrase& phrase, const FactorList& factors)
+{
+  for(size_t i = 0; i < phrase.GetSize(); ++i) {
+    key = auxMixHash(key, auxHashWord(phrase.GetWord(i), factors));
+  }
+  return auxMixHash(key, kFieldEnd);
+}
+}
+
+struct LexicalReorderingTableMapped::Header {
+  char magic[8];
+  uint64_t numKeyFields;
+  uint64_t numScores;
+  uint64_t numEntries;
+  uint64_t tableBytes;
+};
+
+LexicalReorderingTableMapped::LexicalReorderingTableMapped(
+  const std::string& filePath,
+  const std::vector<FactorType>& f_factors,
+  const std::vector<FactorType>& e_factors,
+  const std::vector<FactorType>& c_factors)
+  : LexicalReorderingTable(f_factors, e_factors, c_factors)
+{
+  const std::string fileName = filePath + ".mlexr";
+  {
+    // the mapping stays valid after the file is closed
+    util::scoped_fd file(util::OpenReadOrThrow(fileName.c_str()));
+    util::MapRead(util::LAZY, file.get(), 0, util::SizeOrThrow(file.get()), m_Memory);
+  }
+
+  UTIL_THROW_IF2(m_Memory.size() < sizeof(Header)
+                 || !std::equal(kMappedMagic, kMappedMagic + sizeof(kMappedMagic), m_Memory.begin()),
+                 fileName << " is not a mapped reordering table");
+  Header header;
+  std::memcpy(&header, m_Memory.begin(), sizeof(Header));
+  const size_t numKeyFields = !m_FactorsF.empty() + !m_FactorsE.empty() + !m_FactorsC.empty();
+  UTIL_THROW_IF2(header.numKeyFields != numKeyFields,
+                 fileName << " has " << header.numKeyFields << " key fields but the feature uses " << numKeyFields);
+  UTIL_THROW_IF2(m_Memory.size() != sizeof(Header) + header.tableBytes + header.numEntries * header.numScores * sizeof(float),
+                 fileName << " is truncated");
+
+  char* table = const_cast<char*>(m_Memory.begin()) + sizeof(Header);
+  m_Table = Table(table, header.tableBytes, 0);
+  m_Scores = reinterpret_cast<const float*>(table + header.tableBytes);
+  m_NumEntries = header.numEntries;
+  m_NumScores = header.numScores;
+}
+
+Scores LexicalReorderingTableMapped::GetScore(const Phrase& f, const Phrase& e, const Phrase& c)
+{
+  uint64_t key = 0;
+  if(!m_FactorsF.empty()) {
+    key = auxHashPhrase(key, f, m_FactorsF);
+  }
+  if(!m_FactorsE.empty()) {
+    key = auxHashPhrase(key, e, m_FactorsE);
+  }
+  Scores scores;
+  if(m_FactorsC.empty()) {
+    Find(auxFinishKey(key), scores);
+    return scores;
+  }
+  //try from large to smaller context, hashing each context word once
+  std::vector<uint64_t> words(c.GetSize());
+  for(size_t i = 0; i < c.GetSize(); ++i) {
+    words[i] = auxHashWord(c.GetWord(i), m_FactorsC);
+  }
+  for(size_t i = 0; i <= c.GetSize(); ++i) {
+    uint64_t contextKey = key;
+    for(size_t j = i; j < words.size(); ++j) {
+      contextKey = auxMixHash(contextKey, words[j]);
+    }
+    if(Find(auxFinishKey(auxMixHash(contextKey, kFieldEnd)), scores)) {
+      break;
+    }
+  }
+  return scores;
+}
+
+bool LexicalReorderingTableMapped::Find(uint64_t key, Scores& scores) const
+{
+  Table::ConstIterator it;
+  if(!m_Table.Find(key, it)) {
+    return false;
+  }
+  const float* begin = m_Scores + it->offset;
+  scores.assign(begin, begin + m_NumScores);
+  return true;
+}
+
+void LexicalReorderingTableMapped::DbgDump(std::ostream* out) const
+{
+  *out << "mapped table with " << m_NumEntries << " entries of "
+       << m_NumScores << " scores\n";
+}
+
+bool LexicalReorderingTableMapped::Create(std::istream& inFile, const std::string& outFileName)
+{
+  std::vector<uint64_t> keys;
+  std::vector<float> scores;
+  size_t numKeyFields = 0;
+  size_t numScores = 0;
+  std::string line;
+  size_t lnc = 0;
+  while(getline(inFile, line)) {
+    ++lnc;
+    if(0 == lnc % 100000) {
+      TRACE_ERR(".");
+    }
+    std::vector<std::string> tokens = TokenizeMultiCharSeparator(line, "|||");
+    std::vector<float> p = Scan<float>(Tokenize(tokens.back()));
+    if(1 == lnc) {
+      numKeyFields = tokens.size() - 1;
+      numScores = p.size();
+    }
+    if(tokens.size() - 1 != numKeyFields || p.size() != numScores) {
+      TRACE_ERR("ERROR: line " << lnc << " does not have " << numKeyFields
+                << " key fields and " << numScores << " scores: '" << line << "'\n");
+      return false;
+    }
+    uint64_t key = 0;
+    for(size_t t = 0; t < numKeyFields; ++t) {
+      std::vector<std::string> words = Tokenize(tokens[t]);
+      for(size_t i = 0; i < words.size(); ++i) {
+        key = auxMixHash(key, auxHashToken(words[i]));
+      }
+      key = auxMixHash(key, kFieldEnd);
+    }
+    keys.push_back(auxFinishKey(key));
+    std::transform(p.begin(),p.end(),p.begin(),TransformScore);
+    std::transform(p.begin(),p.end(),p.begin(),FloorScore);
+    scores.insert(scores.end(), p.begin(), p.end());
+  }
+  if(keys.empty()) {
+    TRACE_ERR("ERROR: empty lexicalised reordering file\n");
+    return false;
+  }
+
+  Header header;
+  std::copy(kMappedMagic, kMappedMagic + sizeof(kMappedMagic), header.magic);
+  header.numKeyFields = numKeyFields;
+  header.numScores = numScores;
+  header.numEntries = keys.size();
+  header.tableBytes = Table::Size(keys.size(), 1.5);
+
+  std::vector<char> buffer(header.tableBytes);
+  Table table(&buffer[0], buffer.size(), 0);
+  table.Clear();
+  for(size_t i = 0; i < keys.size(); ++i) {
+    Entry entry;
+    entry.key = keys[i];
+    entry.offset = i * numScores;
+    Table::MutableIterator it;
+    if(table.FindOrInsert(entry, it)) {
+      TRACE_ERR("ERROR: key of line " << (i + 1) << " is already in the table\n");
+      return false;
+    }
+  }
+
+  util::scoped_fd file(util::CreateOrThrow((outFileName + ".mlexr").c_str()));
+  util::WriteOrThrow(file.get(), &header, sizeof(Header));
+  util::WriteOrThrow(file.get(), &buffer[0], buffer.size());
+  util::WriteOrThrow(file.get(), &scores[0], scores.size() * sizeof(float));
+  TRACE_ERR("\n" << keys.size() << " entries\n");
+  return true;
+}
+
+}
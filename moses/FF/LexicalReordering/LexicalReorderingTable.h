@@ -20,6 +20,9 @@
 #include "moses/Sentence.h"
 #include "moses/PrefixTreeMap.h"
 
+#include "util/mmap.hh"
+#include "util/probing_hash_table.hh"
+
 namespace Moses
 {
 
@@ -153,6 +156,49 @@ private:
   TableType m_Table;
 };
 
+/** Reordering table in a single memory-mapped file (<table>.mlexr).
+ *  The keys are 64-bit hashes of the f, e and c phrases, built straight from
+ *  the interned factor strings, so a lookup allocates no key strings.
+ *  The table is read-only once loaded and is shared by all threads.
+ */
+class LexicalReorderingTableMapped : public LexicalReorderingTable
+{
+public:
+  LexicalReorderingTableMapped(const std::string& filePath,
+                               const std::vector<FactorType>& f_factors,
+                               const std::vector<FactorType>& e_factors,
+                               const std::vector<FactorType>& c_factors);
+public:
+  virtual std::vector<float> GetScore(const Phrase& f, const Phrase& e, const Phrase& c);
+  void DbgDump(std::ostream* out) const;
+public:
+  //! convert a text table to outFileName.mlexr
+  static bool Create(std::istream& inFile, const std::string& outFileName);
+private:
+  struct Entry {
+    typedef uint64_t Key;
+    uint64_t key;
+    uint64_t offset; // into the score array, in floats
+    Key GetKey() const {
+      return key;
+    }
+    void SetKey(Key to) {
+      key = to;
+    }
+  };
+  typedef util::ProbingHashTable<Entry, util::IdentityHash> Table;
+
+  struct Header;
+
+  bool Find(uint64_t key, Scores& scores) const;
+
+  util::scoped_memory m_Memory;
+  Table m_Table;
+  const float* m_Scores;
+  size_t m_NumEntries;
+  size_t m_NumScores;
+};
+
 }
 
 #endif
@@ -1,7 +1,9 @@
 #include <fstream>
+#include <boost/bind.hpp>
 #include "OpSequenceModel.h"
 #include "osmHyp.h"
 #include "moses/Util.h"
+#include "moses/ResourceRegistry.h"
 #include "util/exception.hh"
 
 using namespace std;
@@ -21,17 +23,25 @@ OpSequenceModel::OpSequenceModel(const std::string &line)
 
 OpSequenceModel::~OpSequenceModel()
 {
-	delete OSM;
+}
+
+namespace
+{
+Model *LoadOperationModel(const std::string &path)
+{
+  return new Model(path.c_str());
+}
 }
 
 void OpSequenceModel :: readLanguageModel(const char *lmFile)
 {
 
   string unkOp = "_TRANS_SLF_";
-  OSM = new Model(m_lmPath.c_str());
+  OSM = ResourceRegistry::Instance().Acquire<Model>("OSM " + m_lmPath, boost::bind(&LoadOperationModel, m_lmPath));
   State startState = OSM->NullContextState();
   State endState;
   unkOpProb = OSM->Score(startState,OSM->GetVocabulary().Index(unkOp),endState);
+  m_vocab.load(OSM->GetVocabulary());
 }
 
 
@@ -42,23 +52,21 @@ void OpSequenceModel::Load()
 
 
 
-void OpSequenceModel:: Evaluate(const Phrase &source
-                                , const TargetPhrase &targetPhrase
-                                , ScoreComponentCollection &scoreBreakdown
-                                , ScoreComponentCollection &estimatedFutureScore) const
+void OpSequenceModel::InitializeForInput(InputType const& source)
 {
+  if (m_phraseCache.get()) {
+    m_phraseCache->clear();
+  } else {
+    m_phraseCache.reset(new PhraseCache());
+  }
+}
 
-  osmHypothesis obj;
-  obj.setState(OSM->NullContextState());
-  WordsBitmap myBitmap(source.GetSize());
-  vector <string> mySourcePhrase;
+void OpSequenceModel::MakePhrase(osmPhrase &phrase, const vector<string> &source, const TargetPhrase &target) const
+{
   vector <string> myTargetPhrase;
-  vector<float> scores;
   vector <int> alignments;
-  int startIndex = 0;
-  int endIndex = source.GetSize();
 
-  const AlignmentInfo &align = targetPhrase.GetAlignTerm();
+  const AlignmentInfo &align = target.GetAlignTerm();
   AlignmentInfo::const_iterator iter;
 
   for (iter = align.begin(); iter != align.end(); ++iter) {
@@ -66,21 +74,57 @@ void OpSequenceModel:: Evaluate(const Phrase &source
     alignments.push_back(iter->second);
   }
 
-  for (int i = 0; i < targetPhrase.GetSize(); i++) {
-    if (targetPhrase.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
+  for (size_t i = 0; i < target.GetSize(); i++) {
+    if (target.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
       myTargetPhrase.push_back("_TRANS_SLF_");
     else
-      myTargetPhrase.push_back(targetPhrase.GetWord(i).GetFactor(tFactor)->GetString().as_string());
+      myTargetPhrase.push_back(target.GetWord(i).GetFactor(tFactor)->GetString().as_string());
+  }
+
+  phrase.construct(m_vocab, alignments, source, myTargetPhrase);
+}
+
+const osmPhrase &OpSequenceModel::GetPhrase(const Hypothesis &cur_hypo) const
+{
+  if (!m_phraseCache.get()) {
+    m_phraseCache.reset(new PhraseCache());
+  }
+  const TranslationOption &option = cur_hypo.GetTranslationOption();
+  PhraseCache::iterator found = m_phraseCache->find(&option);
+  if (found != m_phraseCache->end()) {
+    return found->second;
+  }
+
+  const InputType &source = cur_hypo.GetManager().GetSource();
+  const WordsRange &sourceRange = option.GetSourceWordsRange();
+  vector <string> mySourcePhrase;
+  for (size_t i = sourceRange.GetStartPos(); i <= sourceRange.GetEndPos(); i++) {
+    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
   }
 
+  osmPhrase &phrase = (*m_phraseCache)[&option];
+  MakePhrase(phrase, mySourcePhrase, option.GetTargetPhrase());
+  return phrase;
+}
+
+void OpSequenceModel:: Evaluate(const Phrase &source
+                                , const TargetPhrase &targetPhrase
+                                , ScoreComponentCollection &scoreBreakdown
+                                , ScoreComponentCollection &estimatedFutureScore) const
+{
+
+  osmHypothesis obj(m_vocab, OSM->NullContextState(), source.GetSize());
+  WordsBitmap myBitmap(source.GetSize());
+  vector <string> mySourcePhrase;
+  vector<float> scores;
+  osmPhrase phrase;
+
   for (int i = 0; i < source.GetSize(); i++) {
     mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
   }
 
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
-  obj.constructCepts(alignments,startIndex,endIndex-1,targetPhrase.GetSize());
-  obj.computeOSMFeature(startIndex,myBitmap);
-  obj.calculateOSMProb(*OSM);
+  MakePhrase(phrase, mySourcePhrase, targetPhrase);
+  obj.computeOSMFeature(*OSM, phrase, 0, myBitmap);
   obj.populateScores(scores,numFeatures);
   estimatedFutureScore.PlusEquals(this, scores);
 
@@ -92,106 +136,21 @@ FFState* OpSequenceModel::Evaluate(
   const FFState* prev_state,
   ScoreComponentCollection* accumulator) const
 {
-  const TargetPhrase &target = cur_hypo.GetCurrTargetPhrase();
-  const WordsBitmap &bitmap = cur_hypo.GetWordsBitmap();
-  WordsBitmap myBitmap = bitmap;
-  const Manager &manager = cur_hypo.GetManager();
-  const InputType &source = manager.GetSource();
-  const Sentence &sourceSentence = static_cast<const Sentence&>(source);
-  osmHypothesis obj;
-  vector <string> mySourcePhrase;
-  vector <string> myTargetPhrase;
-  vector<float> scores;
-
-
-  //target.GetWord(0)
-
-  //cerr << target <<" --- "<<target.GetSourcePhrase()<< endl;  // English ...
-
-  //cerr << align << endl;   // Alignments ...
-  //cerr << cur_hypo.GetCurrSourceWordsRange() << endl;
-
-  //cerr << source <<endl;
-
-// int a = sourceRange.GetStartPos();
-// cerr << source.GetWord(a);
-  //cerr <<a<<endl;
-
-  //const Sentence &sentence = static_cast<const Sentence&>(curr_hypo.GetManager().GetSource());
-
-
   const WordsRange & sourceRange = cur_hypo.GetCurrSourceWordsRange();
   int startIndex  = sourceRange.GetStartPos();
   int endIndex = sourceRange.GetEndPos();
-  const AlignmentInfo &align = cur_hypo.GetCurrTargetPhrase().GetAlignTerm();
-  osmState * statePtr;
-
-  vector <int> alignments;
-
-
-
-  AlignmentInfo::const_iterator iter;
-
-  for (iter = align.begin(); iter != align.end(); ++iter) {
-    //cerr << iter->first << "----" << iter->second << " ";
-    alignments.push_back(iter->first);
-    alignments.push_back(iter->second);
-  }
-
-
-  //cerr<<bitmap<<endl;
-  //cerr<<startIndex<<" "<<endIndex<<endl;
-
-
-  for (int i = startIndex; i <= endIndex; i++) {
-    myBitmap.SetValue(i,0); // resetting coverage of this phrase ...
-    mySourcePhrase.push_back(source.GetWord(i).GetFactor(sFactor)->GetString().as_string());
-    // cerr<<mySourcePhrase[i]<<endl;
-  }
-
-  for (int i = 0; i < target.GetSize(); i++) {
-
-    if (target.GetWord(i).IsOOV() && sFactor == 0 && tFactor == 0)
-      myTargetPhrase.push_back("_TRANS_SLF_");
-    else
-      myTargetPhrase.push_back(target.GetWord(i).GetFactor(tFactor)->GetString().as_string());
-
-  }
-
+  vector<float> scores;
 
-  //cerr<<myBitmap<<endl;
+  WordsBitmap myBitmap = cur_hypo.GetWordsBitmap();
+  myBitmap.SetValue(startIndex, endIndex, false); // resetting coverage of this phrase ...
 
-  obj.setState(prev_state);
-  obj.constructCepts(alignments,startIndex,endIndex,target.GetSize());
-  obj.setPhrases(mySourcePhrase , myTargetPhrase);
-  obj.computeOSMFeature(startIndex,myBitmap);
-  obj.calculateOSMProb(*OSM);
+  osmHypothesis obj(m_vocab, *static_cast<const osmState *>(prev_state));
+  obj.computeOSMFeature(*OSM, GetPhrase(cur_hypo), startIndex, myBitmap);
   obj.populateScores(scores,numFeatures);
-  //obj.print();
-
-  /*
-    if (bitmap.GetFirstGapPos() == NOT_FOUND)
-    {
-
-      int xx;
-  	 cerr<<bitmap<<endl;
-  	 int a = bitmap.GetFirstGapPos();
-  	 obj.print();
-      cin>>xx;
-    }
-    */
-
-
 
   accumulator->PlusEquals(this, scores);
 
   return obj.saveState();
-
-
-
-
-  //return statePtr;
-// return NULL;
 }
 
 FFState* OpSequenceModel::EvaluateChart(
@@ -209,7 +168,7 @@ const FFState* OpSequenceModel::EmptyHypothesisState(const InputType &input) con
 
   State startState = OSM->BeginSentenceState();
 
-  return new osmState(startState);
+  return new osmState(startState, input.GetSize());
 }
 
 std::string OpSequenceModel::GetScoreProducerWeightShortName(unsigned idx) const
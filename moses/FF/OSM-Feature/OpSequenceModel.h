@@ -3,6 +3,13 @@
 #include <string>
 #include <map>
 #include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#else
+#include <boost/scoped_ptr.hpp>
+#endif
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/Manager.h"
 #include "moses/FF/OSM-Feature/osmHyp.h"
@@ -17,7 +24,7 @@ class OpSequenceModel : public StatefulFeatureFunction
 public:
 
 
-  lm::ngram::Model * OSM;
+  boost::shared_ptr<lm::ngram::Model> OSM; // shared with other features that use the same file ...
   float unkOpProb;
   int sFactor;	// Source Factor ...
   int tFactor;	// Target Factor ...
@@ -28,6 +35,7 @@ public:
 
   void readLanguageModel(const char *);
   void Load();
+  void InitializeForInput(InputType const& source);
 
   FFState* Evaluate(
     const Hypothesis& cur_hypo,
@@ -64,9 +72,19 @@ protected:
   typedef std::vector<float> Scores;
   std::map<ParallelPhrase, Scores> m_futureCost;
 
-  std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
-  std::set <int> targetNullWords;
   std::string m_lmPath;
+  osmVocabulary m_vocab;
+
+  // operations of the translation options of the current sentence, per thread
+  typedef boost::unordered_map<const TranslationOption*, osmPhrase> PhraseCache;
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<PhraseCache> m_phraseCache;
+#else
+  mutable boost::scoped_ptr<PhraseCache> m_phraseCache;
+#endif
+
+  void MakePhrase(osmPhrase &phrase, const std::vector<std::string> &source, const TargetPhrase &target) const;
+  const osmPhrase &GetPhrase(const Hypothesis &cur_hypo) const;
 
 
 };
@@ -1,25 +1,29 @@
 #include "osmHyp.h"
 #include <sstream>
+#include <boost/functional/hash.hpp>
 
 using namespace std;
 using namespace lm::ngram;
 
 namespace Moses
 {
-osmState::osmState(const State & val)
+osmState::osmState(const State & val, size_t sentenceSize)
   :j(0)
   ,E(0)
+  ,unfilled(sentenceSize)
+  ,filled(sentenceSize)
 {
   lmState = val;
 
 }
 
-void osmState::saveState(int jVal, int eVal, map <int , string> & gapVal)
+osmState::osmState(const State & val, int jVal, int eVal, const WordsBitmap & unfilledVal, const WordsBitmap & filledVal)
+  :j(jVal)
+  ,E(eVal)
+  ,unfilled(unfilledVal)
+  ,filled(filledVal)
 {
-  gap.clear();
-  gap = gapVal;
-  j = jVal;
-  E = eVal;
+  lmState = val;
 }
 
 int osmState::Compare(const FFState& otherBase) const
@@ -29,8 +33,12 @@ int osmState::Compare(const FFState& otherBase) const
     return (j < other.j) ? -1 : +1;
   if (E != other.E)
     return (E < other.E) ? -1 : +1;
-  if (gap != other.gap)
-    return (gap < other.gap) ? -1 : +1;
+  int ret = unfilled.Compare(other.unfilled);
+  if (ret != 0)
+    return ret;
+  ret = filled.Compare(other.filled);
+  if (ret != 0)
+    return ret;
 
   if (lmState.length < other.lmState.length) return -1;
 
@@ -39,6 +47,18 @@ int osmState::Compare(const FFState& otherBase) const
   return 0;
 }
 
+size_t osmState::hash() const
+{
+  // like Compare(), looks at the length of the LM state but not its words
+  size_t seed = 0;
+  boost::hash_combine(seed, j);
+  boost::hash_combine(seed, E);
+  boost::hash_combine(seed, unfilled.hash());
+  boost::hash_combine(seed, filled.hash());
+  boost::hash_combine(seed, lmState.length);
+  return seed;
+}
+
 
 std::string osmState :: getName() const
 {
@@ -48,347 +68,163 @@ std::string osmState :: getName() const
 
 //////////////////////////////////////////////////
 
-osmHypothesis :: osmHypothesis()
-{
-  opProb = 0;
-  gapWidth = 0;
-  gapCount = 0;
-  openGapCount = 0;
-  deletionCount = 0;
-  gapCount = 0;
-  j = 0;
-  E = 0;
-  gap.clear();
-}
-
-void osmHypothesis :: setState(const FFState* prev_state)
+void osmVocabulary :: load(const lm::ngram::Vocabulary & val)
 {
-
-  if(prev_state != NULL) {
-
-    j = static_cast <const osmState *> (prev_state)->getJ();
-    E =  static_cast <const osmState *> (prev_state)->getE();
-    gap = static_cast <const osmState *> (prev_state)->getGap();
-    lmState = static_cast <const osmState *> (prev_state)->getLMState();
+  vocab = &val;
+  insertGap = index("_INS_GAP_");
+  jumpForward = index("_JMP_FWD_");
+  continueCept = index("_CONT_CEPT_");
+  translateSelf = index("_TRANS_SLF_");
+
+  jumpBackIds.clear();
+  for (int gp = 1; ; gp++) {
+    lm::WordIndex id = index(jumpBackName(gp));
+    if (id == val.NotFound())
+      break;
+    jumpBackIds.push_back(id);
   }
 }
 
-osmState * osmHypothesis :: saveState()
+std::string osmVocabulary :: jumpBackName(int gp)
 {
-
-  osmState * statePtr = new osmState(lmState);
-  statePtr->saveState(j,E,gap);
-  return statePtr;
+  std::ostringstream stm;
+  stm<<"_JMP_BCK_"<<gp;
+  return stm.str();
 }
 
-int osmHypothesis :: isTranslationOperation(int x)
+lm::WordIndex osmVocabulary :: jumpBack(int gp) const
 {
-  if (operations[x].find("_JMP_BCK_") != -1)
-    return 0;
-
-  if (operations[x].find("_JMP_FWD_") != -1)
-    return 0;
-
-  if (operations[x].find("_CONT_CEPT_") != -1)
-    return 0;
-
-  if (operations[x].find("_INS_GAP_") != -1)
-    return 0;
-
-  return 1;
-
+  if (gp >= 1 && gp <= (int) jumpBackIds.size())
+    return jumpBackIds[gp - 1];
+  // longer jumps than the model knows in one run ...
+  return index(jumpBackName(gp));
 }
 
-void osmHypothesis :: removeReorderingOperations()
-{
-  gapCount = 0;
-  deletionCount = 0;
-  openGapCount = 0;
-  gapWidth = 0;
-
-  std::vector <std::string> tupleSequence;
-
-  for (int x = 0; x < operations.size(); x++) {
-    // cout<<operations[x]<<endl;
-
-    if(isTranslationOperation(x) == 1) {
-      tupleSequence.push_back(operations[x]);
-    }
-
-  }
-
-  operations.clear();
-  operations = tupleSequence;
-}
+//////////////////////////////////////////////////
 
-void osmHypothesis :: calculateOSMProb(Model & ptrOp)
+void osmPhrase :: addStep(StepType type, int sourcePos, lm::WordIndex operation)
 {
-
-  opProb = 0;
-  State currState = lmState;
-  State temp;
-
-  for (int i = 0; i<operations.size(); i++) {
-    temp = currState;
-    opProb += ptrOp.Score(temp,ptrOp.GetVocabulary().Index(operations[i]),currState);
-  }
-
-  lmState = currState;
-
-  //print();
+  Step step;
+  step.type = type;
+  step.sourcePos = sourcePos;
+  step.operation = operation;
+  steps.push_back(step);
 }
 
-
-int osmHypothesis :: firstOpenGap(vector <int> & coverageVector)
+void osmPhrase :: addDeletions(const osmVocabulary & vocab, const vector <string> & currE, const set <int> & sourceNullWords, int currTargetIndex, const set <int> & doneTargetIndexes)
 {
+  do {
+    addStep(Delete, 0, vocab.index("_DEL_" + currE[currTargetIndex]));
+    currTargetIndex++;
 
-  int firstOG =-1;
-
-  for(int nd = 0; nd < coverageVector.size(); nd++) {
-    if(coverageVector[nd]==0) {
-      firstOG = nd;
-      return firstOG;
+    while(doneTargetIndexes.find(currTargetIndex) != doneTargetIndexes.end()) {
+      currTargetIndex++;
     }
-  }
-
-  return firstOG;
-
-}
-
-string osmHypothesis :: intToString(int num)
-{
-
-  std::ostringstream stm;
-  stm<<num;
-
-  return stm.str();
-
+  } while (sourceNullWords.find(currTargetIndex) != sourceNullWords.end());
 }
 
-void osmHypothesis :: generateOperations(int & startIndex , int j1 , int contFlag , WordsBitmap & coverageVector , string english , string german , set <int> & targetNullWords , vector <string> & currF)
+void osmPhrase :: getMeCepts ( set <int> & eSide , set <int> & fSide , map <int , vector <int> > & tS , map <int , vector <int> > & sT)
 {
+  set <int> :: iterator iter;
 
-  int gFlag = 0;
-  int gp = 0;
-  int ans;
-
+  size_t sz = eSide.size();
+  vector <int> t;
 
-  if ( j < j1) { // j1 is the index of the source word we are about to generate ...
-    //if(coverageVector[j]==0) // if source word at j is not generated yet ...
-    if(coverageVector.GetValue(j)==0) { // if source word at j is not generated yet ...
-      operations.push_back("_INS_GAP_");
-      gFlag++;
-      gap[j]="Unfilled";
-    }
-    if (j == E) {
-      j = j1;
-    } else {
-      operations.push_back("_JMP_FWD_");
-      j=E;
-    }
-  }
+  for (iter = eSide.begin(); iter != eSide.end(); iter++) {
+    t = tS[*iter];
 
-  if (j1 < j) {
-    // if(j < E && coverageVector[j]==0)
-    if(j < E && coverageVector.GetValue(j)==0) {
-      operations.push_back("_INS_GAP_");
-      gFlag++;
-      gap[j]="Unfilled";
+    for (size_t i = 0; i < t.size(); i++) {
+      fSide.insert(t[i]);
     }
 
-    j=closestGap(gap,j1,gp);
-    operations.push_back("_JMP_BCK_"+ intToString(gp));
-
-    //cout<<"I am j "<<j<<endl;
-    //cout<<"I am j1 "<<j1<<endl;
-
-    if(j==j1)
-      gap[j]="Filled";
   }
 
-  if (j < j1) {
-    operations.push_back("_INS_GAP_");
-    gap[j] = "Unfilled";
-    gFlag++;
-    j=j1;
-  }
+  for (iter = fSide.begin(); iter != fSide.end(); iter++) {
 
-  if(contFlag == 0) { // First words of the multi-word cept ...
+    t = sT[*iter];
 
-    if(english == "_TRANS_SLF_") { // Unknown word ...
-      operations.push_back("_TRANS_SLF_");
-    } else {
-      operations.push_back("_TRANS_" + english + "_TO_" + german);
+    for (size_t i = 0 ; i<t.size(); i++) {
+      eSide.insert(t[i]);
     }
 
-    //ans = firstOpenGap(coverageVector);
-    ans = coverageVector.GetFirstGapPos();
-
-    if (ans != -1)
-      gapWidth += j - ans;
-
-  } else if (contFlag == 2) {
-
-    operations.push_back("_INS_" + german);
-    ans = coverageVector.GetFirstGapPos();
-
-    if (ans != -1)
-      gapWidth += j - ans;
-    deletionCount++;
-  } else {
-    operations.push_back("_CONT_CEPT_");
   }
 
-  //coverageVector[j]=1;
-  coverageVector.SetValue(j,1);
-  j+=1;
-
-  if(E<j)
-    E=j;
-
-  if (gFlag > 0)
-    gapCount++;
-
-  openGapCount += getOpenGaps();
-
-  //if (coverageVector[j] == 0 && targetNullWords.find(j) != targetNullWords.end())
-  if (coverageVector.GetValue(j) == 0 && targetNullWords.find(j) != targetNullWords.end()) {
-    j1 = j;
-    german = currF[j1-startIndex];
-    english = "_INS_";
-    generateOperations(startIndex, j1, 2 , coverageVector , english , german , targetNullWords , currF);
-  }
-
-}
-
-void osmHypothesis :: print()
-{
-  for (int i = 0; i< operations.size(); i++) {
-    cerr<<operations[i]<<" ";
-
+  if (eSide.size () > sz) {
+    getMeCepts(eSide,fSide,tS,sT);
   }
 
-  cerr<<endl<<endl;
-
-  cerr<<"Operation Probability "<<opProb<<endl;
-  cerr<<"Gap Count "<<gapCount<<endl;
-  cerr<<"Open Gap Count "<<openGapCount<<endl;
-  cerr<<"Gap Width "<<gapWidth<<endl;
-  cerr<<"Deletion Count "<<deletionCount<<endl;
-
-  cerr<<"_______________"<<endl;
 }
 
-int osmHypothesis :: closestGap(map <int,string> gap, int j1, int & gp)
+void osmPhrase :: construct(const osmVocabulary & vocab, vector <int> & align , const vector <string> & currF , const vector <string> & currE)
 {
 
-  int dist=1172;
-  int value=-1;
-  int temp=0;
-  gp=0;
-  int opGap=0;
-
-  map <int,string> :: iterator iter;
-
-  iter=gap.end();
-
-  do {
-    iter--;
-    //cout<<"Trapped "<<iter->first<<endl;
+  std::map <int , vector <int> > sT;
+  std::map <int , vector <int> > tS;
+  std::set <int> eSide;
+  std::set <int> fSide;
+  std::set <int> sourceNullWords; // Unaligned target words ...
+  std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
+  std::set <int> :: iterator iter;
+  std :: map <int , vector <int> > :: iterator iter2;
 
-    if(iter->first==j1 && iter->second== "Unfilled") {
-      opGap++;
-      gp = opGap;
-      return j1;
+  for (size_t i = 0;  i < align.size(); i+=2) {
+    tS[align[i+1]].push_back(align[i]);
+    sT[align[i]].push_back(align[i+1]);
+  }
 
+  targetNullWords.assign(currF.size(), false);
+  insertions.assign(currF.size(), vocab.translateSelf);
+  for (size_t i = 0; i < currF.size(); i++) { // What are unaligned source words in this phrase ...
+    if (sT.find(i) == sT.end()) {
+      targetNullWords[i] = true;
+      insertions[i] = vocab.index("_INS_" + currF[i]);
     }
+  }
 
-    if(iter->second =="Unfilled") {
-      opGap++;
-      temp = iter->first - j1;
-
-      if(temp<0)
-        temp=temp * -1;
-
-      if(dist>temp && iter->first < j1) {
-        dist=temp;
-        value=iter->first;
-        gp=opGap;
-      }
+  for (size_t i = 0; i < currE.size(); i++) { // What are unaligned target words in this phrase ...
+    if (tS.find(i) == tS.end()) {
+      sourceNullWords.insert(i);
     }
-
-
-  } while(iter!=gap.begin());
-
-  return value;
-}
-
-
-
-int osmHypothesis :: getOpenGaps()
-{
-  map <int,string> :: iterator iter;
-
-  int nd = 0;
-  for (iter = gap.begin(); iter!=gap.end(); iter++) {
-    if(iter->second == "Unfilled")
-      nd++;
   }
 
-  return nd;
-
-}
+  while (tS.size() != 0 && sT.size() != 0) {
 
-void osmHypothesis :: generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes)
-{
+    iter2 = tS.begin();
 
-  operations.push_back("_DEL_" + english);
-  currTargetIndex++;
+    eSide.clear();
+    fSide.clear();
+    eSide.insert (iter2->first);
 
-  while(doneTargetIndexes.find(currTargetIndex) != doneTargetIndexes.end()) {
-    currTargetIndex++;
-  }
+    getMeCepts(eSide, fSide, tS , sT);
 
-  if (sourceNullWords.find(currTargetIndex) != sourceNullWords.end()) {
-    english = currE[currTargetIndex];
-    generateDeleteOperations(english,currTargetIndex,doneTargetIndexes);
-  }
+    for (iter = eSide.begin(); iter != eSide.end(); iter++) {
+      iter2 = tS.find(*iter);
+      tS.erase(iter2);
+    }
 
-}
+    for (iter = fSide.begin(); iter != fSide.end(); iter++) {
+      iter2 = sT.find(*iter);
+      sT.erase(iter2);
+    }
 
-void osmHypothesis :: computeOSMFeature(int startIndex , WordsBitmap & coverageVector)
-{
+    ceptsInPhrase.push_back(make_pair (fSide , eSide));
+  }
 
+  // Lay out the operations in the order the decoder generates them ...
   set <int> doneTargetIndexes;
-  set <int> eSide;
-  set <int> fSide;
-  set <int> :: iterator iter;
   string english;
   string source;
-  int j1;
-  int start = 0;
   int targetIndex = 0;
-  doneTargetIndexes.clear();
-
+  steps.clear();
 
-  if (targetNullWords.size() != 0) { // Source words to be deleted in the start of this phrase ...
-    iter = targetNullWords.begin();
-
-    if (*iter == startIndex) {
-
-      j1 = startIndex;
-      source = currF[j1-startIndex];
-      english = "_INS_";
-      generateOperations(startIndex, j1, 2 , coverageVector , english , source , targetNullWords , currF);
-    }
+  if (!currF.empty() && targetNullWords[0]) { // Source words to be deleted in the start of this phrase ...
+    addStep(Insert, 0, insertions[0]);
   }
 
   if (sourceNullWords.find(targetIndex) != sourceNullWords.end()) { // first word has to be deleted ...
-    english = currE[targetIndex];
-    generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+    addDeletions(vocab, currE, sourceNullWords, targetIndex, doneTargetIndexes);
   }
 
-
   for (int i = 0; i < ceptsInPhrase.size(); i++) {
     source = "";
     english = "";
@@ -421,15 +257,15 @@ void osmHypothesis :: computeOSMFeature(int startIndex , WordsBitmap & coverageV
     }
 
     iter = fSide.begin();
-    j1 = *iter + startIndex;
+    if(english == "_TRANS_SLF_") { // Unknown word ...
+      addStep(Translate, *iter, vocab.translateSelf);
+    } else {
+      addStep(Translate, *iter, vocab.index("_TRANS_" + english + "_TO_" + source));
+    }
     iter++;
 
-    generateOperations(startIndex, j1, 0 , coverageVector , english , source , targetNullWords , currF);
-
-
     for (; iter != fSide.end(); iter++) {
-      j1 = *iter + startIndex;
-      generateOperations(startIndex, j1, 1 , coverageVector , english , source , targetNullWords , currF);
+      addStep(ContinueCept, *iter, vocab.continueCept);
     }
 
     targetIndex++; // Check whether the next target word is unaligned ...
@@ -439,145 +275,184 @@ void osmHypothesis :: computeOSMFeature(int startIndex , WordsBitmap & coverageV
     }
 
     if(sourceNullWords.find(targetIndex) != sourceNullWords.end()) {
-      english = currE[targetIndex];
-      generateDeleteOperations(english,targetIndex, doneTargetIndexes);
+      addDeletions(vocab, currE, sourceNullWords, targetIndex, doneTargetIndexes);
     }
   }
 
-  //removeReorderingOperations();
+}
 
-  //print();
+//////////////////////////////////////////////////
 
+osmHypothesis :: osmHypothesis(const osmVocabulary & vocabVal, const osmState & prev_state)
+  :vocab(vocabVal)
+  ,j(prev_state.getJ())
+  ,E(prev_state.getE())
+  ,unfilled(prev_state.getUnfilled())
+  ,filled(prev_state.getFilled())
+  ,lmState(prev_state.getLMState())
+{
+  opProb = 0;
+  gapWidth = 0;
+  gapCount = 0;
+  openGapCount = 0;
+  deletionCount = 0;
 }
 
-void osmHypothesis :: getMeCepts ( set <int> & eSide , set <int> & fSide , map <int , vector <int> > & tS , map <int , vector <int> > & sT)
+osmHypothesis :: osmHypothesis(const osmVocabulary & vocabVal, const State & val, size_t sentenceSize)
+  :vocab(vocabVal)
+  ,j(0)
+  ,E(0)
+  ,unfilled(sentenceSize)
+  ,filled(sentenceSize)
+  ,lmState(val)
 {
-  set <int> :: iterator iter;
-
-  int sz = eSide.size();
-  vector <int> t;
-
-  for (iter = eSide.begin(); iter != eSide.end(); iter++) {
-    t = tS[*iter];
-
-    for (int i = 0; i < t.size(); i++) {
-      fSide.insert(t[i]);
-    }
-
-  }
-
-  for (iter = fSide.begin(); iter != fSide.end(); iter++) {
-
-    t = sT[*iter];
-
-    for (int i = 0 ; i<t.size(); i++) {
-      eSide.insert(t[i]);
-    }
+  opProb = 0;
+  gapWidth = 0;
+  gapCount = 0;
+  openGapCount = 0;
+  deletionCount = 0;
+}
 
-  }
+osmState * osmHypothesis :: saveState()
+{
 
-  if (eSide.size () > sz) {
-    getMeCepts(eSide,fSide,tS,sT);
-  }
+  return new osmState(lmState, j, E, unfilled, filled);
+}
 
+void osmHypothesis :: setGap(int pos, bool isFilled)
+{
+  unfilled.SetValue(pos, !isFilled);
+  filled.SetValue(pos, isFilled);
 }
 
-void osmHypothesis :: constructCepts(vector <int> & align , int startIndex , int endIndex, int targetPhraseLength)
+void osmHypothesis :: scoreOperation(const Model & ptrOp, lm::WordIndex operation)
 {
+  State temp = lmState;
+  opProb += ptrOp.Score(temp, operation, lmState);
+}
 
-  std::map <int , vector <int> > sT;
-  std::map <int , vector <int> > tS;
-  std::set <int> eSide;
-  std::set <int> fSide;
-  std::set <int> :: iterator iter;
-  std :: map <int , vector <int> > :: iterator iter2;
-  std :: pair < set <int> , set <int> > cept;
-  int src;
-  int tgt;
+void osmHypothesis :: generateOperations(const Model & ptrOp, const osmPhrase & phrase, int startIndex, int j1 , osmPhrase::StepType type , WordsBitmap & coverageVector , lm::WordIndex operation)
+{
 
+  int gFlag = 0;
+  int gp = 0;
+  size_t ans;
 
-  for (int i = 0;  i < align.size(); i+=2) {
-    src = align[i];
-    tgt = align[i+1];
-    tS[tgt].push_back(src);
-    sT[src].push_back(tgt);
-  }
 
-  for (int i = startIndex; i<= endIndex; i++) { // What are unaligned source words in this phrase ...
-    if (sT.find(i-startIndex) == sT.end()) {
-      targetNullWords.insert(i);
+  if ( j < j1) { // j1 is the index of the source word we are about to generate ...
+    if(coverageVector.GetValue(j)==0) { // if source word at j is not generated yet ...
+      scoreOperation(ptrOp, vocab.insertGap);
+      gFlag++;
+      setGap(j, false);
+    }
+    if (j == E) {
+      j = j1;
+    } else {
+      scoreOperation(ptrOp, vocab.jumpForward);
+      j=E;
     }
   }
 
-  for (int i = 0; i < targetPhraseLength; i++) { // What are unaligned target words in this phrase ...
-    if (tS.find(i) == tS.end()) {
-      sourceNullWords.insert(i);
+  if (j1 < j) {
+    if(j < E && coverageVector.GetValue(j)==0) {
+      scoreOperation(ptrOp, vocab.insertGap);
+      gFlag++;
+      setGap(j, false);
     }
-  }
 
+    j=closestGap(j1,gp);
+    scoreOperation(ptrOp, vocab.jumpBack(gp));
 
-  while (tS.size() != 0 && sT.size() != 0) {
+    if(j==j1)
+      setGap(j, true);
+  }
 
-    iter2 = tS.begin();
+  if (j < j1) {
+    scoreOperation(ptrOp, vocab.insertGap);
+    setGap(j, false);
+    gFlag++;
+    j=j1;
+  }
 
-    eSide.clear();
-    fSide.clear();
-    eSide.insert (iter2->first);
+  scoreOperation(ptrOp, operation);
 
-    getMeCepts(eSide, fSide, tS , sT);
+  if(type == osmPhrase::Translate || type == osmPhrase::Insert) { // First words of the multi-word cept ...
 
-    for (iter = eSide.begin(); iter != eSide.end(); iter++) {
-      iter2 = tS.find(*iter);
-      tS.erase(iter2);
-    }
+    ans = coverageVector.GetFirstGapPos();
 
-    for (iter = fSide.begin(); iter != fSide.end(); iter++) {
-      iter2 = sT.find(*iter);
-      sT.erase(iter2);
-    }
+    if (ans != NOT_FOUND)
+      gapWidth += j - (int) ans;
 
-    cept = make_pair (fSide , eSide);
-    ceptsInPhrase.push_back(cept);
+    if (type == osmPhrase::Insert)
+      deletionCount++;
   }
 
+  coverageVector.SetValue(j,1);
+  j+=1;
 
+  if(E<j)
+    E=j;
 
-  /*
+  if (gFlag > 0)
+    gapCount++;
 
-  	  cerr<<"Extracted Cepts "<<endl;
-  		for (int i = 0; i < ceptsInPhrase.size(); i++)
-  			{
+  openGapCount += unfilled.GetNumWordsCovered();
 
-  				fSide = ceptsInPhrase[i].first;
-  				eSide = ceptsInPhrase[i].second;
+  const lm::WordIndex *insertion = phrase.getInsertion(j - startIndex);
+  if (insertion != NULL && coverageVector.GetValue(j) == 0) {
+    generateOperations(ptrOp, phrase, startIndex, j, osmPhrase::Insert , coverageVector , *insertion);
+  }
+
+}
+
+void osmHypothesis :: print()
+{
+  cerr<<"Operation Probability "<<opProb<<endl;
+  cerr<<"Gap Count "<<gapCount<<endl;
+  cerr<<"Open Gap Count "<<openGapCount<<endl;
+  cerr<<"Gap Width "<<gapWidth<<endl;
+  cerr<<"Deletion Count "<<deletionCount<<endl;
 
-  				for (iter = eSide.begin(); iter != eSide.end(); iter++)
-  				{
-  			   		cerr<<*iter<<" ";
-  				}
-  			    	cerr<<"<---> ";
+  cerr<<"_______________"<<endl;
+}
 
-  				for (iter = fSide.begin(); iter != fSide.end(); iter++)
-  				{
-  					cerr<<*iter<<" ";
-  				}
+int osmHypothesis :: closestGap(int j1, int & gp)
+{
 
-  				cerr<<endl;
-  			}
-  			cerr<<endl;
+  int value=-1;
+  gp=0;
+  int opGap=0;
 
-  		cerr<<"Unaligned Target Words"<<endl;
+  // open gaps from right to left, the first one left of j1 is the closest ...
+  for (int pos = (int) unfilled.GetSize() - 1; pos >= 0; pos--) {
+    if (!unfilled.GetValue(pos))
+      continue;
 
-  		for (iter = sourceNullWords.begin(); iter != sourceNullWords.end(); iter++)
-  			cerr<<*iter<<"<--->"<<endl;
+    opGap++;
+    if (pos == j1) {
+      gp = opGap;
+      return j1;
+    }
 
-  		cerr<<"Unaligned Source Words"<<endl;
+    if (pos < j1 && value == -1) {
+      value = pos;
+      gp = opGap;
+    }
+  }
 
-  		for (iter = targetNullWords.begin(); iter != targetNullWords.end(); iter++)
-  			cerr<<*iter<<"<--->"<<endl;
+  return value;
+}
 
-  */
+void osmHypothesis :: computeOSMFeature(const Model & ptrOp, const osmPhrase & phrase, int startIndex , WordsBitmap & coverageVector)
+{
+  const vector <osmPhrase::Step> & steps = phrase.getSteps();
 
+  for (size_t i = 0; i < steps.size(); i++) {
+    if (steps[i].type == osmPhrase::Delete)
+      scoreOperation(ptrOp, steps[i].operation);
+    else
+      generateOperations(ptrOp, phrase, startIndex, steps[i].sourcePos + startIndex, steps[i].type, coverageVector, steps[i].operation);
+  }
 }
 
 void osmHypothesis :: populateScores(vector <float> & scores , const int numFeatures)
@@ -596,4 +471,3 @@ void osmHypothesis :: populateScores(vector <float> & scores , const int numFeat
 
 
 } // namespace
-
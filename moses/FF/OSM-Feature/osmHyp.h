@@ -2,6 +2,7 @@
 
 # include "moses/FF/FFState.h"
 # include "moses/Manager.h"
+# include "moses/WordsBitmap.h"
 #include "lm/model.hh"
 # include <set>
 # include <map>
@@ -14,17 +15,21 @@ namespace Moses
 class osmState : public FFState
 {
 public:
-  osmState(const lm::ngram::State & val);
+  osmState(const lm::ngram::State & val, size_t sentenceSize);
+  osmState(const lm::ngram::State & val, int jVal, int eVal, const WordsBitmap & unfilledVal, const WordsBitmap & filledVal);
   int Compare(const FFState& other) const;
-  void saveState(int jVal, int eVal, std::map <int , std::string> & gapVal);
+  size_t hash() const;
   int getJ()const {
     return j;
   }
   int getE()const {
     return E;
   }
-  std::map <int , std::string> getGap() const {
-    return gap;
+  const WordsBitmap & getUnfilled() const {
+    return unfilled;
+  }
+  const WordsBitmap & getFilled() const {
+    return filled;
   }
 
   lm::ngram::State getLMState() const {
@@ -36,20 +41,79 @@ public:
 
 protected:
   int j, E;
-  std::map <int,std::string> gap;
+  WordsBitmap unfilled; // Gaps that are still open ...
+  WordsBitmap filled; // Gaps that were jumped back to and filled ...
   lm::ngram::State lmState;
 };
 
-class osmHypothesis
+// Operation ids in the OSM vocabulary that do not depend on the phrase, resolved once at load time ...
+class osmVocabulary
 {
+public:
+  osmVocabulary() : vocab(NULL) {}
+  void load(const lm::ngram::Vocabulary & val);
+
+  lm::WordIndex index(const std::string & operation) const {
+    return vocab->Index(operation);
+  }
+  lm::WordIndex jumpBack(int gp) const;
+
+  lm::WordIndex insertGap, jumpForward, continueCept, translateSelf;
 
 private:
+  static std::string jumpBackName(int gp);
+
+  const lm::ngram::Vocabulary * vocab;
+  std::vector <lm::WordIndex> jumpBackIds; // _JMP_BCK_1 at [0] up to the first one the model does not know ...
+};
 
+// The part of the operation sequence that only depends on the phrase pair, built once per translation option ...
+class osmPhrase
+{
+public:
+  enum StepType {
+    Translate = 0,
+    ContinueCept = 1,
+    Insert = 2,
+    Delete = 3
+  };
+
+  struct Step {
+    StepType type;
+    int sourcePos; // relative to the phrase, unused for deletions ...
+    lm::WordIndex operation;
+  };
+
+  void construct(const osmVocabulary & vocab, std::vector <int> & align , const std::vector <std::string> & currF , const std::vector <std::string> & currE);
+
+  const std::vector <Step> & getSteps() const {
+    return steps;
+  }
+  // _INS_ operation of an unaligned source word, or NULL ...
+  const lm::WordIndex * getInsertion(int sourcePos) const {
+    return (sourcePos < (int) targetNullWords.size() && targetNullWords[sourcePos]) ? &insertions[sourcePos] : NULL;
+  }
+
+private:
+  std::vector <Step> steps;
+  std::vector <lm::WordIndex> insertions;
+  std::vector <bool> targetNullWords; // Unaligned source words ...
 
-  std::vector <std::string> operations;	// List of operations required to generated this hyp ...
-  std::map <int,std::string> gap;	// Maintains gap history ...
+  void addStep(StepType type, int sourcePos, lm::WordIndex operation);
+  void addDeletions(const osmVocabulary & vocab, const std::vector <std::string> & currE, const std::set <int> & sourceNullWords, int currTargetIndex, const std::set <int> & doneTargetIndexes);
+  void getMeCepts ( std::set <int> & eSide , std::set <int> & fSide , std::map <int , std::vector <int> > & tS , std::map <int , std::vector <int> > & sT);
+};
+
+class osmHypothesis
+{
+
+private:
+
+  const osmVocabulary & vocab;
   int j;	// Position after the last source word generated ...
   int E; // Position after the right most source word so far generated ...
+  WordsBitmap unfilled; // Maintains gap history ...
+  WordsBitmap filled;
   lm::ngram::State lmState; // KenLM's Model State ...
 
   int gapCount; // Number of gaps inserted ...
@@ -58,41 +122,20 @@ private:
   int gapWidth;
   double opProb;
 
-  std::vector <std::string> currE;
-  std::vector <std::string> currF;
-  std::vector < std::pair < std::set <int> , std::set <int> > > ceptsInPhrase;
-  std::set <int> targetNullWords;
-  std::set <int> sourceNullWords;
-
-  int closestGap(std::map <int,std::string> gap,int j1, int & gp);
-  int firstOpenGap(std::vector <int> & coverageVector);
-  std::string intToString(int);
-  int  getOpenGaps();
-  int isTranslationOperation(int j);
-  void removeReorderingOperations();
-
-  void getMeCepts ( std::set <int> & eSide , std::set <int> & fSide , std::map <int , std::vector <int> > & tS , std::map <int , std::vector <int> > & sT);
+  int closestGap(int j1, int & gp);
+  void setGap(int pos, bool isFilled);
+  void scoreOperation(const lm::ngram::Model & ptrOp, lm::WordIndex operation);
+  void generateOperations(const lm::ngram::Model & ptrOp, const osmPhrase & phrase, int startIndex, int j1 , osmPhrase::StepType type , WordsBitmap & coverageVector , lm::WordIndex operation);
 
 public:
 
-  osmHypothesis();
+  osmHypothesis(const osmVocabulary & vocabVal, const osmState & prev_state);
+  osmHypothesis(const osmVocabulary & vocabVal, const lm::ngram::State & val, size_t sentenceSize);
   ~osmHypothesis() {};
-  void generateOperations(int & startIndex, int j1 , int contFlag , WordsBitmap & coverageVector , std::string english , std::string german , std::set <int> & targetNullWords , std::vector <std::string> & currF);
-  void generateDeleteOperations(std::string english, int currTargetIndex, std::set <int> doneTargetIndexes);
-  void calculateOSMProb(lm::ngram::Model & ptrOp);
-  void computeOSMFeature(int startIndex , WordsBitmap & coverageVector);
-  void constructCepts(std::vector <int> & align , int startIndex , int endIndex, int targetPhraseLength);
-  void setPhrases(std::vector <std::string> & val1 , std::vector <std::string> & val2) {
-    currF = val1;
-    currE = val2;
-  }
-  void setState(const FFState* prev_state);
+  void computeOSMFeature(const lm::ngram::Model & ptrOp, const osmPhrase & phrase, int startIndex , WordsBitmap & coverageVector);
   osmState * saveState();
   void print();
   void populateScores(std::vector <float> & scores , const int numFeatures);
-  void setState(const lm::ngram::State & val) {
-    lmState = val;
-  }
 
 };
 
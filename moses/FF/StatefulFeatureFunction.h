@@ -1,10 +1,14 @@
 #pragma once
 
+#include <utility>
+#include <vector>
+
 #include "FeatureFunction.h"
 
 namespace Moses
 {
 class FFState;
+class TargetPhrase;
 
 /** base class for all stateful feature functions.
  * eg. LM, distortion penalty
@@ -39,6 +43,16 @@ public:
     int /* featureID - used to index the state in the previous hypotheses */,
     ScoreComponentCollection* accumulator) const = 0;
 
+  //! (state of the hypothesis to be extended, phrase it is extended with)
+  typedef std::vector<std::pair<const FFState*, const TargetPhrase*> > Expansions;
+
+  /** Called with a batch of expansions before they are evaluated one by one,
+   * e.g. so that a language model can prefetch everything it will look up
+   * and the cache misses overlap. Does nothing by default.
+   */
+  virtual void PrefetchExpansions(const Expansions & /* expansions */) const {
+  }
+
   //! return the state associated with the empty hypothesis for a given sentence
   virtual const FFState* EmptyHypothesisState(const InputType &input) const = 0;
 
@@ -24,6 +24,10 @@ public:
     return m_words;
   }
   virtual int Compare(const FFState& other) const;
+  virtual size_t hash() const {
+    // the context is compared word by word, see FFState::hash()
+    return m_words.size();
+  }
 
 private:
   std::vector<Word> m_words;
@@ -171,6 +175,18 @@ public:
     }
     return 0;
   }
+
+  //! lengths of the prefix and suffix that Compare() looks at
+  size_t hash() const {
+    size_t seed = 0;
+    if (m_startPos > 0) {
+      boost::hash_combine(seed, GetPrefix().GetSize());
+    }
+    if (m_endPos < m_inputSize - 1) {
+      boost::hash_combine(seed, GetSuffix().GetSize());
+    }
+    return seed;
+  }
 };
 
 /** Sets the features of observed ngrams.
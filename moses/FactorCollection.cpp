@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifdef WITH_THREADS
 #include <boost/thread/locks.hpp>
 #endif
+#include <algorithm>
 #include <ostream>
 #include <string>
 #include "FactorCollection.h"
@@ -35,36 +36,70 @@ namespace Moses
 {
 FactorCollection FactorCollection::s_instance;
 
+#ifdef WITH_THREADS
+FactorCollection::ThreadCache::ThreadCache()
+{
+  std::fill(m_factors, m_factors + Size, static_cast<const Factor*>(NULL));
+}
+#endif
+
 const Factor *FactorCollection::AddFactor(const StringPiece &factorString, bool isNonTerminal)
 {
+  const uint64_t hash = util::MurmurHashNative(factorString.data(), factorString.size());
+
+#ifdef WITH_THREADS
+  ThreadCache *cache = m_threadCache.get();
+  if (cache == NULL) {
+    cache = new ThreadCache;
+    m_threadCache.reset(cache);
+  }
+  const Factor *&cached = cache->m_factors[(hash + isNonTerminal) % ThreadCache::Size];
+  // non-terminal ids are below moses_MaxNumNonterminals
+  if (cached && cached->GetString() == factorString
+      && (cached->GetId() < moses_MaxNumNonterminals) == isNonTerminal) {
+    return cached;
+  }
+#endif
+
   FactorFriend to_ins;
   to_ins.in.m_string = factorString;
-  to_ins.in.m_id = (isNonTerminal) ? m_factorIdNonTerminal : m_factorId;
-  Set & set = (isNonTerminal) ? m_set : m_setNonTerminal;
+  Shard &shard = (isNonTerminal ? m_shardsNonTerminal : m_shards)[(hash >> 32) % NumShards];
+  Set::const_iterator i;
   // If we're threaded, hope a read-only lock is sufficient.
 #ifdef WITH_THREADS
   {
     // read=lock scope
-    boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
-    Set::const_iterator i = set.find(to_ins);
-    if (i != set.end()) return &i->in;
+    boost::shared_lock<boost::shared_mutex> read_lock(shard.m_accessLock);
+    i = shard.m_set.find(to_ins);
+    if (i != shard.m_set.end()) return cached = &i->in;
   }
-  boost::unique_lock<boost::shared_mutex> lock(m_accessLock);
+  boost::unique_lock<boost::shared_mutex> lock(shard.m_accessLock);
 #endif // WITH_THREADS
-  std::pair<Set::iterator, bool> ret(set.insert(to_ins));
-  if (ret.second) {
-    ret.first->in.m_string.set(
-      memcpy(m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
+  i = shard.m_set.find(to_ins);
+  if (i == shard.m_set.end()) {
+    to_ins.in.m_id = NewId(isNonTerminal);
+    i = shard.m_set.insert(to_ins).first;
+    i->in.m_string.set(
+      memcpy(shard.m_string_backing.Allocate(factorString.size()), factorString.data(), factorString.size()),
       factorString.size());
-    if (isNonTerminal) {
-      m_factorIdNonTerminal++;
-      UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
-    }
-    else {
-      m_factorId++;
-    }
   }
-  return &ret.first->in;
+#ifdef WITH_THREADS
+  cached = &i->in;
+#endif
+  return &i->in;
+}
+
+size_t FactorCollection::NewId(bool isNonTerminal)
+{
+#ifdef WITH_THREADS
+  boost::lock_guard<boost::mutex> lock(m_idLock);
+#endif
+  if (isNonTerminal) {
+    size_t id = m_factorIdNonTerminal++;
+    UTIL_THROW_IF2(m_factorIdNonTerminal >= moses_MaxNumNonterminals, "Number of non-terminals exceeds maximum size reserved. Adjust parameter moses_MaxNumNonterminals, then recompile");
+    return id;
+  }
+  return m_factorId++;
 }
 
 FactorCollection::~FactorCollection() {}
@@ -74,11 +109,14 @@ TO_STRING_BODY(FactorCollection);
 // friend
 ostream& operator<<(ostream& out, const FactorCollection& factorCollection)
 {
+  for (size_t shard = 0; shard < FactorCollection::NumShards; ++shard) {
+    const FactorCollection::Set &set = factorCollection.m_shards[shard].m_set;
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_accessLock);
+    boost::shared_lock<boost::shared_mutex> lock(factorCollection.m_shards[shard].m_accessLock);
 #endif
-  for (FactorCollection::Set::const_iterator i = factorCollection.m_set.begin(); i != factorCollection.m_set.end(); ++i) {
-    out << i->in;
+    for (FactorCollection::Set::const_iterator i = set.begin(); i != set.end(); ++i) {
+      out << i->in;
+    }
   }
   return out;
 }
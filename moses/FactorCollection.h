@@ -28,7 +28,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 #ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/tss.hpp>
 #endif
 
 #include "util/murmur_hash.hh"
@@ -62,6 +64,11 @@ struct FactorFriend {
  * from being created on the stack, etc), their memory addresses can
  * be used as keys to uniquely identify them.
  * Only 1 FactorCollection object should be created.
+ *
+ * The strings are spread over shards by hash, each with its own lock, so
+ * threads interning different strings rarely wait for each other. Each
+ * thread also remembers the factors it interned last and finds those again
+ * without taking any lock.
  */
 class FactorCollection
 {
@@ -78,20 +85,40 @@ class FactorCollection
     }
   };
   typedef boost::unordered_set<FactorFriend, HashFactor, EqualsFactor> Set;
-  Set m_set;
-  Set m_setNonTerminal;
 
-  util::Pool m_string_backing;
+  //! the factors whose strings hash to one shard
+  struct Shard {
+    Set m_set;
+    util::Pool m_string_backing;
+#ifdef WITH_THREADS
+    //reader-writer lock
+    mutable boost::shared_mutex m_accessLock;
+#endif
+  };
+  static const size_t NumShards = 64;
+
+  Shard m_shards[NumShards];
+  Shard m_shardsNonTerminal[NumShards];
 
   static FactorCollection s_instance;
 #ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::shared_mutex m_accessLock;
+  //! direct-mapped cache of the factors one thread looked up last
+  struct ThreadCache {
+    static const size_t Size = 1024;
+    const Factor *m_factors[Size];
+    ThreadCache();
+  };
+  boost::thread_specific_ptr<ThreadCache> m_threadCache;
+
+  //! guards the id counters
+  boost::mutex m_idLock;
 #endif
 
   size_t m_factorIdNonTerminal; /**< unique, contiguous ids, starting from 0, for each non-terminal factor */
   size_t m_factorId; /**< unique, contiguous ids, starting from moses_MaxNumNonterminals, for each terminal factor */
 
+  size_t NewId(bool isNonTerminal);
+
   //! constructor. only the 1 static variable can be created
   FactorCollection()
     : m_factorIdNonTerminal(0)
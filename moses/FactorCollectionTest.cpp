@@ -0,0 +1,90 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
+#include "FactorCollection.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+void Intern(vector<const Factor*> *factors)
+{
+  FactorCollection &fc = FactorCollection::Instance();
+  for (size_t i = 0; i < factors->size(); ++i) {
+    (*factors)[i] = fc.AddFactor("factor_collection_test_" + boost::lexical_cast<string>(i));
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(factor_collection)
+
+BOOST_AUTO_TEST_CASE(same_string_same_factor)
+{
+  FactorCollection &fc = FactorCollection::Instance();
+  string str("factor_collection_same");
+  const Factor *terminal = fc.AddFactor(str);
+  // the collection keeps its own copy of the string
+  str[0] = 'F';
+  BOOST_CHECK_EQUAL(terminal->GetString(), "factor_collection_same");
+  BOOST_CHECK_EQUAL(fc.AddFactor("factor_collection_same"), terminal);
+  BOOST_CHECK(terminal->GetId() >= moses_MaxNumNonterminals);
+
+  const Factor *nonTerminal = fc.AddFactor("factor_collection_same", true);
+  BOOST_CHECK(nonTerminal != terminal);
+  BOOST_CHECK(nonTerminal->GetId() < moses_MaxNumNonterminals);
+  BOOST_CHECK_EQUAL(fc.AddFactor("factor_collection_same", true), nonTerminal);
+  BOOST_CHECK_EQUAL(fc.AddFactor("factor_collection_same"), terminal);
+}
+
+#ifdef WITH_THREADS
+BOOST_AUTO_TEST_CASE(threads_agree_on_factors)
+{
+  const size_t numThreads = 8;
+  vector<vector<const Factor*> > factors(numThreads, vector<const Factor*>(5000));
+  boost::thread_group threads;
+  for (size_t t = 0; t < numThreads; ++t) {
+    threads.create_thread(boost::bind(&Intern, &factors[t]));
+  }
+  threads.join_all();
+
+  set<size_t> ids;
+  for (size_t i = 0; i < factors[0].size(); ++i) {
+    for (size_t t = 1; t < numThreads; ++t) {
+      BOOST_CHECK_EQUAL(factors[t][i], factors[0][i]);
+    }
+    ids.insert(factors[0][i]->GetId());
+  }
+  BOOST_CHECK_EQUAL(ids.size(), factors[0].size());
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include <stdexcept>
 
@@ -371,18 +372,20 @@ FVector& FVector::operator+= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) + i->second);
-  for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
-    m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  m_features.Merge(rhs.m_features, plus<FValue>());
+  if (rhs.m_coreFeatures.size() == m_coreFeatures.size()) {
+    m_coreFeatures += rhs.m_coreFeatures;
+  } else {
+    for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
+      m_coreFeatures[i] += rhs.m_coreFeatures[i];
+  }
   return *this;
 }
 
 // add only sparse features
 void FVector::sparsePlusEquals(const FVector& rhs)
 {
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) + i->second);
+  m_features.Merge(rhs.m_features, plus<FValue>());
 }
 
 // assign only core features
@@ -540,12 +543,12 @@ FVector& FVector::operator-= (const FVector& rhs)
 {
   if (rhs.m_coreFeatures.size() > m_coreFeatures.size())
     resize(rhs.m_coreFeatures.size());
-  for (const_iterator i = rhs.cbegin(); i != rhs.cend(); ++i)
-    set(i->first, get(i->first) -(i->second));
-  for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
-    if (i < rhs.m_coreFeatures.size()) {
+  m_features.Merge(rhs.m_features, minus<FValue>());
+  if (rhs.m_coreFeatures.size() == m_coreFeatures.size()) {
+    m_coreFeatures -= rhs.m_coreFeatures;
+  } else {
+    for (size_t i = 0; i < rhs.m_coreFeatures.size(); ++i)
       m_coreFeatures[i] -= rhs.m_coreFeatures[i];
-    }
   }
   return *this;
 }
@@ -798,11 +801,31 @@ FValue FVector::inner_product(const FVector& rhs) const
 {
   assert(m_coreFeatures.size() == rhs.m_coreFeatures.size());
   FValue product = 0.0;
-  for (const_iterator i = cbegin(); i != cend(); ++i) {
-    product += ((i->second)*(rhs.get(i->first)));
+  if (!m_features.empty() && !rhs.m_features.empty()) {
+    if (m_features.size() * 8 < rhs.m_features.size()) {
+      // typically a few scores against a large weight vector: binary search
+      for (const_iterator i = cbegin(); i != cend(); ++i) {
+        product += ((i->second)*(rhs.get(i->first)));
+      }
+    } else {
+      const_iterator l = cbegin(), r = rhs.cbegin();
+      while (l != cend() && r != rhs.cend()) {
+        if (l->first < r->first) {
+          ++l;
+        } else if (r->first < l->first) {
+          ++r;
+        } else {
+          product += ((l->second)*(r->second));
+          ++l;
+          ++r;
+        }
+      }
+    }
   }
+  const FValue *lhsCore = m_coreFeatures.size() ? &m_coreFeatures[0] : NULL;
+  const FValue *rhsCore = rhs.m_coreFeatures.size() ? &rhs.m_coreFeatures[0] : NULL;
   for (size_t i = 0; i < m_coreFeatures.size(); ++i) {
-    product += m_coreFeatures[i]*rhs.m_coreFeatures[i];
+    product += lhsCore[i]*rhsCore[i];
   }
   return product;
 }
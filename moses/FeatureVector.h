@@ -22,6 +22,7 @@
 #ifndef FEATUREVECTOR_H
 #define FEATUREVECTOR_H
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <sstream>
@@ -87,6 +88,9 @@ struct FName {
 
   bool operator==(const FName& rhs) const ;
   bool operator!=(const FName& rhs) const ;
+  bool operator<(const FName& rhs) const {
+    return m_id < rhs.m_id;
+  }
 
   static size_t getId(const std::string& name);
   static size_t getHopeIdCount(const std::string& name);
@@ -121,6 +125,127 @@ struct FNameHash
 
 class ProxyFVector;
 
+/**
+ * Sparse features as (name, value) pairs in a flat array sorted by feature id.
+ * The sparse part of a score vector usually holds only a handful of entries,
+ * so this is cheaper to copy than a hash map and lets sums and inner products
+ * walk both operands in order.
+ **/
+class SparseFVector
+{
+public:
+  typedef std::pair<FName, FValue> value_type;
+  typedef std::vector<value_type> Coll;
+  typedef Coll::iterator iterator;
+  typedef Coll::const_iterator const_iterator;
+
+  iterator begin() {
+    return m_coll.begin();
+  }
+  iterator end() {
+    return m_coll.end();
+  }
+  const_iterator begin() const {
+    return m_coll.begin();
+  }
+  const_iterator end() const {
+    return m_coll.end();
+  }
+  const_iterator cbegin() const {
+    return m_coll.begin();
+  }
+  const_iterator cend() const {
+    return m_coll.end();
+  }
+
+  size_t size() const {
+    return m_coll.size();
+  }
+  bool empty() const {
+    return m_coll.empty();
+  }
+  void clear() {
+    m_coll.clear();
+  }
+
+  iterator find(const FName& name) {
+    iterator i = LowerBound(name);
+    return (i != m_coll.end() && i->first == name) ? i : m_coll.end();
+  }
+  const_iterator find(const FName& name) const {
+    return const_cast<SparseFVector*>(this)->find(name);
+  }
+
+  //! value of name, inserted as 0 if it is not there yet
+  FValue& operator[](const FName& name) {
+    iterator i = LowerBound(name);
+    if (i == m_coll.end() || i->first != name) {
+      i = m_coll.insert(i, value_type(name, 0));
+    }
+    return i->second;
+  }
+
+  void erase(const FName& name) {
+    iterator i = find(name);
+    if (i != m_coll.end()) {
+      m_coll.erase(i);
+    }
+  }
+
+  //! this[n] = op(this[n], rhs[n]) for every n in rhs, missing values are 0
+  template <class Op>
+  void Merge(const SparseFVector& rhs, Op op);
+
+  void swap(SparseFVector& other) {
+    m_coll.swap(other.m_coll);
+  }
+
+private:
+  Coll m_coll;
+
+  struct NameLess {
+    bool operator()(const value_type& a, const FName& b) const {
+      return a.first < b;
+    }
+  };
+
+  iterator LowerBound(const FName& name) {
+    // features are mostly added in id order, so try the end first
+    if (m_coll.empty() || m_coll.back().first < name) {
+      return m_coll.end();
+    }
+    return std::lower_bound(m_coll.begin(), m_coll.end(), name, NameLess());
+  }
+};
+
+template <class Op>
+void SparseFVector::Merge(const SparseFVector& rhs, Op op)
+{
+  if (rhs.empty()) return;
+
+  Coll merged;
+  merged.reserve(m_coll.size() + rhs.m_coll.size());
+  const_iterator l = m_coll.begin(), r = rhs.m_coll.begin();
+  while (l != m_coll.end() || r != rhs.m_coll.end()) {
+    if (r == rhs.m_coll.end() || (l != m_coll.end() && l->first < r->first)) {
+      merged.push_back(*l++);
+    } else if (l == m_coll.end() || r->first < l->first) {
+      merged.push_back(value_type(r->first, op(FValue(0), r->second)));
+      ++r;
+    } else {
+      merged.push_back(value_type(l->first, op(l->second, r->second)));
+      ++l;
+      ++r;
+    }
+  }
+  m_coll.swap(merged);
+}
+
+inline void swap(SparseFVector &first, SparseFVector &second)
+{
+  first.swap(second);
+}
+
 /**
  * A sparse feature (or weight) vector.
  **/
@@ -141,7 +266,7 @@ public:
   **/
   void resize(size_t newsize);
 
-  typedef boost::unordered_map<FName,FValue,FNameHash, FNameEquals> FNVmap;
+  typedef SparseFVector FNVmap;
   /** Iterators */
   typedef FNVmap::iterator iterator;
   typedef FNVmap::const_iterator const_iterator;
@@ -306,6 +306,41 @@ BOOST_AUTO_TEST_CASE(ip)
   BOOST_CHECK_CLOSE((FValue)p1, 1.1*0.5 + -0.1*0.25 + 2.2*2.4, TOL);
 }
 
+BOOST_AUTO_TEST_CASE(sparse_sorted)
+{
+  FVector f1, f2;
+  FName n1("sa");
+  FName n2("sb");
+  FName n3("sc");
+  FName n4("sd");
+  // insert out of id order
+  f1[n3] = 3;
+  f1[n1] = 1;
+  f2[n4] = 4;
+  f2[n2] = 2;
+  f2[n1] = 0.5;
+  f1 += f2;
+  BOOST_CHECK_EQUAL(f1.size(), 4);
+  FVector::const_iterator i = f1.cbegin();
+  BOOST_CHECK(i->first == n1);
+  BOOST_CHECK_CLOSE(i->second, 1.5, TOL);
+  for (FVector::const_iterator prev = i++; i != f1.cend(); prev = i++) {
+    BOOST_CHECK(prev->first < i->first);
+  }
+  BOOST_CHECK_CLOSE((FValue)f1[n4], 4, TOL);
+
+  // large rhs takes the binary search path
+  FVector weights;
+  for (size_t j = 0; j < 100; ++j) {
+    ostringstream name;
+    name << "w" << j;
+    weights[FName(name.str())] = 1;
+  }
+  weights[n3] = 2;
+  BOOST_CHECK_CLOSE(inner_product(f1, weights), 3*2, TOL);
+  BOOST_CHECK_CLOSE(f1.inner_product(weights), 3*2, TOL);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
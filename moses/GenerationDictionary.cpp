@@ -19,8 +19,11 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <string>
+#include <boost/unordered_map.hpp>
 #include "GenerationDictionary.h"
 #include "FactorCollection.h"
 #include "Word.h"
@@ -29,6 +32,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "StaticData.h"
 #include "UserMessage.h"
 #include "util/exception.hh"
+#include "util/file.hh"
+#include "util/murmur_hash.hh"
 
 using namespace std;
 
@@ -138,5 +143,274 @@ void GenerationDictionary::SetParameter(const std::string& key, const std::strin
   }
 }
 
+/*
+ * functions for GenerationDictionaryMapped
+ */
+namespace
+{
+const char kMappedMagic[8] = {'m', 'g', 'e', 'n', '\0', '\0', '\0', '1'};
+
+// 0 marks an empty bucket
+inline uint64_t HashSource(const uint32_t *ids, size_t size)
+{
+  uint64_t key = util::MurmurHash64A(ids, size * sizeof(uint32_t));
+  return key ? key : 1;
+}
+
+inline uint64_t RoundUp8(uint64_t size)
+{
+  return (size + 7) & ~static_cast<uint64_t>(7);
+}
+
+// orders the lines of a table by input word, then output word, then line
+struct RecordOrder {
+  RecordOrder(const std::vector<uint32_t> &sources, size_t numInput, const std::vector<uint32_t> &records, size_t recordSize, size_t numOutput)
+    : m_sources(sources), m_numInput(numInput), m_records(records), m_recordSize(recordSize), m_numOutput(numOutput) {}
+
+  int Compare(size_t a, size_t b) const {
+    const uint32_t *sourceA = &m_sources[a * m_numInput], *sourceB = &m_sources[b * m_numInput];
+    for (size_t i = 0; i < m_numInput; ++i) {
+      if (sourceA[i] != sourceB[i]) return sourceA[i] < sourceB[i] ? -1 : 1;
+    }
+    const uint32_t *targetA = &m_records[a * m_recordSize], *targetB = &m_records[b * m_recordSize];
+    for (size_t i = 0; i < m_numOutput; ++i) {
+      if (targetA[i] != targetB[i]) return targetA[i] < targetB[i] ? -1 : 1;
+    }
+    return 0;
+  }
+  bool operator()(size_t a, size_t b) const {
+    int ret = Compare(a, b);
+    return ret ? ret < 0 : a < b;
+  }
+
+  const std::vector<uint32_t> &m_sources;
+  size_t m_numInput;
+  const std::vector<uint32_t> &m_records;
+  size_t m_recordSize, m_numOutput;
+};
+}
+
+struct GenerationDictionaryMapped::Header {
+  char magic[8];
+  uint64_t numInputFactors;
+  uint64_t numOutputFactors;
+  uint64_t numScores;
+  uint64_t vocabSize;
+  uint64_t vocabBytes; // strings ending in 0, padded to 8 bytes
+  uint64_t numSources;
+  uint64_t numRecords;
+  uint64_t tableBytes;
+};
+
+GenerationDictionaryMapped::GenerationDictionaryMapped(const std::string &line)
+  : GenerationDictionary(line)
+  , m_records(NULL)
+  , m_numSources(0)
+  , m_numScores(0)
+  , m_recordSize(0)
+{
+}
+
+void GenerationDictionaryMapped::Load()
+{
+  const std::string fileName = m_filePath + ".mgen";
+  {
+    // the mapping stays valid after the file is closed
+    util::scoped_fd file(util::OpenReadOrThrow(fileName.c_str()));
+    util::MapRead(util::LAZY, file.get(), 0, util::SizeOrThrow(file.get()), m_memory);
+  }
+
+  UTIL_THROW_IF2(m_memory.size() < sizeof(Header)
+                 || !std::equal(kMappedMagic, kMappedMagic + sizeof(kMappedMagic), m_memory.begin()),
+                 fileName << " is not a mapped generation table");
+  Header header;
+  std::memcpy(&header, m_memory.begin(), sizeof(Header));
+  UTIL_THROW_IF2(header.numInputFactors != GetInput().size() || header.numOutputFactors != GetOutput().size(),
+                 fileName << " maps " << header.numInputFactors << " to " << header.numOutputFactors
+                 << " factors, but the feature maps " << GetInput().size() << " to " << GetOutput().size());
+  UTIL_THROW_IF2(header.numScores < GetNumScoreComponents(),
+                 fileName << " has " << header.numScores << " scores, but the feature expects "
+                 << GetNumScoreComponents());
+  m_recordSize = header.numOutputFactors + header.numScores;
+  UTIL_THROW_IF2(m_memory.size() != sizeof(Header) + header.vocabBytes + header.tableBytes
+                 + header.numRecords * m_recordSize * sizeof(uint32_t),
+                 fileName << " is truncated");
+
+  // intern the vocabulary once, so that lookups work on factor ids
+  FactorCollection &factorCollection = FactorCollection::Instance();
+  const char *vocab = m_memory.begin() + sizeof(Header);
+  m_factors.resize(header.vocabSize);
+  size_t maxFactorId = 0;
+  for (size_t i = 0; i < header.vocabSize; ++i) {
+    const size_t length = std::strlen(vocab);
+    m_factors[i] = factorCollection.AddFactor(StringPiece(vocab, length));
+    maxFactorId = std::max(maxFactorId, m_factors[i]->GetId());
+    vocab += length + 1;
+  }
+  m_vocabIds.assign(header.vocabSize ? maxFactorId + 1 : 0, 0);
+  for (size_t i = 0; i < m_factors.size(); ++i) {
+    m_vocabIds[m_factors[i]->GetId()] = i + 1;
+  }
+
+  char *table = const_cast<char*>(m_memory.begin()) + sizeof(Header) + header.vocabBytes;
+  m_table = Table(table, header.tableBytes, 0);
+  m_records = reinterpret_cast<const uint32_t*>(table + header.tableBytes);
+  m_numSources = header.numSources;
+  m_numScores = header.numScores;
+}
+
+const OutputWordCollection *GenerationDictionaryMapped::FindWord(const Word &word) const
+{
+  const std::vector<FactorType> &input = GetInput();
+  uint32_t ids[MAX_NUM_FACTORS];
+  for (size_t i = 0; i < input.size(); ++i) {
+    const Factor *factor = word[input[i]];
+    if (!factor || factor->GetId() >= m_vocabIds.size() || !m_vocabIds[factor->GetId()]) {
+      return NULL;
+    }
+    ids[i] = m_vocabIds[factor->GetId()] - 1;
+  }
+  Table::ConstIterator it;
+  if (!m_table.Find(HashSource(ids, input.size()), it)) {
+    return NULL;
+  }
+
+  if (!m_found.get()) {
+    m_found.reset(new OutputWordCollection());
+  }
+  OutputWordCollection &found = *m_found;
+  found.clear();
+
+  const std::vector<FactorType> &output = GetOutput();
+  std::vector<float> scores(GetNumScoreComponents());
+  const uint32_t *record = m_records + it->begin * m_recordSize;
+  for (size_t r = 0; r < it->count; ++r, record += m_recordSize) {
+    Word outputWord;
+    for (size_t i = 0; i < output.size(); ++i) {
+      outputWord.SetFactor(output[i], m_factors[record[i]]);
+    }
+    if (!scores.empty()) {
+      std::memcpy(&scores[0], record + output.size(), scores.size() * sizeof(float));
+    }
+    found[outputWord].Assign(this, scores);
+  }
+  return &found;
 }
 
+bool GenerationDictionaryMapped::Create(std::istream &inFile, const std::string &outFileName)
+{
+  boost::unordered_map<std::string, uint32_t> vocabIds;
+  std::string vocab;
+  std::vector<uint32_t> sources, records;
+  size_t numInput = 0, numOutput = 0, numScores = 0;
+
+  string line;
+  size_t lineNum = 0;
+  while (getline(inFile, line)) {
+    ++lineNum;
+    if (0 == lineNum % 100000) {
+      TRACE_ERR(".");
+    }
+    vector<string> token = Tokenize(line);
+    if (token.empty()) {
+      continue;
+    }
+    vector<string> inputFactors = token.size() > 1 ? Tokenize(token[0], "|") : vector<string>();
+    vector<string> outputFactors = token.size() > 1 ? Tokenize(token[1], "|") : vector<string>();
+    if (sources.empty()) {
+      numInput = inputFactors.size();
+      numOutput = outputFactors.size();
+      numScores = token.size() - 2;
+    }
+    if (token.size() < 2 || !numInput || !numOutput || inputFactors.size() != numInput || outputFactors.size() != numOutput || token.size() - 2 != numScores) {
+      TRACE_ERR("ERROR: line " << lineNum << " does not map " << numInput << " to " << numOutput
+                << " factors with " << numScores << " scores: '" << line << "'\n");
+      return false;
+    }
+
+    for (size_t i = 0; i < numInput + numOutput; ++i) {
+      const string &factor = i < numInput ? inputFactors[i] : outputFactors[i - numInput];
+      std::pair<boost::unordered_map<std::string, uint32_t>::iterator, bool> added
+        = vocabIds.insert(std::make_pair(factor, static_cast<uint32_t>(vocabIds.size())));
+      if (added.second) {
+        vocab.append(factor).push_back('\0');
+      }
+      (i < numInput ? sources : records).push_back(added.first->second);
+    }
+    for (size_t i = 0; i < numScores; ++i) {
+      float score = FloorScore(TransformScore(Scan<float>(token[2 + i])));
+      uint32_t bits;
+      std::memcpy(&bits, &score, sizeof(float));
+      records.push_back(bits);
+    }
+  }
+  if (sources.empty()) {
+    TRACE_ERR("ERROR: empty generation table\n");
+    return false;
+  }
+
+  // group the output words by input word. Of repeated pairs the last line counts, as in the text table
+  const size_t recordSize = numOutput + numScores;
+  const size_t numLines = records.size() / recordSize;
+  std::vector<size_t> order(numLines);
+  for (size_t i = 0; i < numLines; ++i) {
+    order[i] = i;
+  }
+  RecordOrder compare(sources, numInput, records, recordSize, numOutput);
+  std::sort(order.begin(), order.end(), compare);
+
+  std::vector<Entry> entries;
+  std::vector<uint32_t> sorted;
+  for (size_t i = 0; i < numLines; ++i) {
+    if (i + 1 < numLines && !compare.Compare(order[i], order[i + 1])) {
+      continue;
+    }
+    const uint32_t *source = &sources[order[i] * numInput];
+    if (entries.empty() || std::memcmp(source, &sources[order[entries.back().key] * numInput], numInput * sizeof(uint32_t))) {
+      Entry entry;
+      entry.key = i; // a line of the input word until the table is built
+      entry.begin = sorted.size() / recordSize;
+      entry.count = 0;
+      entries.push_back(entry);
+    }
+    ++entries.back().count;
+    sorted.insert(sorted.end(), records.begin() + order[i] * recordSize, records.begin() + (order[i] + 1) * recordSize);
+  }
+
+  Header header;
+  std::copy(kMappedMagic, kMappedMagic + sizeof(kMappedMagic), header.magic);
+  header.numInputFactors = numInput;
+  header.numOutputFactors = numOutput;
+  header.numScores = numScores;
+  header.vocabSize = vocabIds.size();
+  header.vocabBytes = RoundUp8(vocab.size());
+  header.numSources = entries.size();
+  header.numRecords = sorted.size() / recordSize;
+  header.tableBytes = Table::Size(entries.size(), 1.5);
+  vocab.resize(header.vocabBytes, '\0');
+
+  std::vector<char> buffer(header.tableBytes);
+  Table table(&buffer[0], buffer.size(), 0);
+  table.Clear();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    Entry entry = entries[i];
+    entry.key = HashSource(&sources[order[entry.key] * numInput], numInput);
+    Table::MutableIterator it;
+    if (table.FindOrInsert(entry, it)) {
+      TRACE_ERR("ERROR: hash collision between input words\n");
+      return false;
+    }
+  }
+
+  util::scoped_fd file(util::CreateOrThrow((outFileName + ".mgen").c_str()));
+  util::WriteOrThrow(file.get(), &header, sizeof(Header));
+  util::WriteOrThrow(file.get(), vocab.data(), vocab.size());
+  util::WriteOrThrow(file.get(), &buffer[0], buffer.size());
+  if (!sorted.empty()) {
+    util::WriteOrThrow(file.get(), &sorted[0], sorted.size() * sizeof(uint32_t));
+  }
+  TRACE_ERR("\n" << entries.size() << " input words, " << header.numRecords << " output words\n");
+  return true;
+}
+
+}
@@ -22,14 +22,23 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_GenerationDictionary_h
 #define moses_GenerationDictionary_h
 
+#include <iosfwd>
 #include <list>
 #include <map>
 #include <stdexcept>
 #include <vector>
+#include <stdint.h>
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#else
+#include <boost/scoped_ptr.hpp>
+#endif
 #include "ScoreComponentCollection.h"
 #include "Phrase.h"
 #include "TypeDef.h"
 #include "moses/FF/DecodeFeature.h"
+#include "util/mmap.hh"
+#include "util/probing_hash_table.hh"
 
 namespace Moses
 {
@@ -67,17 +76,72 @@ public:
   /** number of unique input entries in the generation table.
   * NOT the number of lines in the generation table
   */
-  size_t GetSize() const {
+  virtual size_t GetSize() const {
     return m_collection.size();
   }
   /** returns a bag of output words, OutputWordCollection, for a particular input word.
-  *	Or NULL if the input word isn't found. The search function used is the WordComparer functor
+  *	Or NULL if the input word isn't found. The search function used is the WordComparer functor.
+  * Implementations may return a buffer of the calling thread that the next FindWord()
+  * in the same thread overwrites, so copy what you need to keep
   */
-  const OutputWordCollection *FindWord(const Word &word) const;
+  virtual const OutputWordCollection *FindWord(const Word &word) const;
   void SetParameter(const std::string& key, const std::string& value);
 
 };
 
+/** Generation table in one memory-mapped file, path.mgen, written by
+ *  processGenerationTable. Lookups hash the file's vocabulary ids of the
+ *  input factors, which are matched to factors once at load time.
+ */
+class GenerationDictionaryMapped : public GenerationDictionary
+{
+public:
+  GenerationDictionaryMapped(const std::string &line);
+
+  void Load();
+
+  size_t GetSize() const {
+    return m_numSources;
+  }
+  /** the output words are decoded into a buffer of the calling thread,
+   *  which is valid until the next FindWord() in that thread
+   */
+  const OutputWordCollection *FindWord(const Word &word) const;
+
+  //! convert a text generation table to outFileName.mgen
+  static bool Create(std::istream &inFile, const std::string &outFileName);
+
+private:
+  struct Entry {
+    typedef uint64_t Key;
+    uint64_t key;
+    uint32_t begin, count; // range of the input word's records
+    Key GetKey() const {
+      return key;
+    }
+    void SetKey(Key to) {
+      key = to;
+    }
+  };
+  typedef util::ProbingHashTable<Entry, util::IdentityHash> Table;
+
+  struct Header;
+
+  util::scoped_memory m_memory;
+  Table m_table;
+  const uint32_t *m_records; // output factor ids followed by the scores, per output word
+  size_t m_numSources, m_numScores, m_recordSize;
+
+  std::vector<const Factor*> m_factors; // by vocabulary id of the file
+  std::vector<uint32_t> m_vocabIds; // vocabulary id + 1 by Factor::GetId(), 0 if not in the file
+
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<OutputWordCollection> m_found;
+#else
+  mutable boost::scoped_ptr<OutputWordCollection> m_found;
+#endif
+};
+
 
 }
 #endif
@@ -0,0 +1,99 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+
+#include <sstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "FactorCollection.h"
+#include "GenerationDictionary.h"
+#include "MockTempFile.h"
+
+using namespace Moses;
+using namespace MosesTest;
+using namespace std;
+
+namespace
+{
+
+const char* const kTable =
+  "a x 0.5 0.25\n"
+  "a y 0.5 0.75\n"
+  "b x 1 1\n"
+  "a x 0.1 0.2\n";
+
+Word MakeWord(FactorType factorType, const string &str)
+{
+  Word word;
+  word.SetFactor(factorType, FactorCollection::Instance().AddFactor(str));
+  return word;
+}
+
+// the mapped table next to the text one
+void CreateMapped(const string &path)
+{
+  istringstream in(kTable);
+  BOOST_REQUIRE(GenerationDictionaryMapped::Create(in, path));
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(generation_dictionary)
+
+BOOST_AUTO_TEST_CASE(mapped_matches_text)
+{
+  MockTempFileGuard file("generation_dictionary_test", kTable, ".mgen");
+  CreateMapped(file.GetPath());
+  // feature functions stay registered, so they are left for FeatureFunction::Destroy()
+  GenerationDictionary &text = *new GenerationDictionary("Generation name=GenerationTestText input-factor=0 output-factor=1 num-features=2 path=" + file.GetPath());
+  text.Load();
+  GenerationDictionaryMapped &mapped = *new GenerationDictionaryMapped("GenerationMapped name=GenerationTestMapped input-factor=0 output-factor=1 num-features=2 path=" + file.GetPath());
+  mapped.Load();
+  BOOST_CHECK_EQUAL(mapped.GetSize(), text.GetSize());
+
+  const char* const queries[] = {"a", "b", "c", "x"};
+  for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+    const Word word = MakeWord(0, queries[i]);
+    const OutputWordCollection *expected = text.FindWord(word);
+    const OutputWordCollection *actual = mapped.FindWord(word);
+    BOOST_REQUIRE_EQUAL(actual == NULL, expected == NULL);
+    if (!expected) continue;
+    BOOST_REQUIRE_EQUAL(actual->size(), expected->size());
+    OutputWordCollection::const_iterator a = actual->begin(), e = expected->begin();
+    for (; e != expected->end(); ++a, ++e) {
+      BOOST_CHECK(a->first == e->first);
+      vector<float> actualScores = a->second.GetScoresForProducer(&mapped);
+      vector<float> expectedScores = e->second.GetScoresForProducer(&text);
+      BOOST_CHECK_EQUAL_COLLECTIONS(actualScores.begin(), actualScores.end(), expectedScores.begin(), expectedScores.end());
+    }
+  }
+  // the later line of a repeated pair counts
+  BOOST_CHECK_EQUAL(mapped.FindWord(MakeWord(0, "a"))->size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_rejects_empty_table)
+{
+  // nothing is written when there are no records
+  istringstream in("\n \n\n");
+  BOOST_CHECK(!GenerationDictionaryMapped::Create(in, "/tmp/generation_dictionary_test_empty"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <limits>
 #include <vector>
 #include <algorithm>
+#include <boost/functional/hash.hpp>
 
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
@@ -32,6 +33,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "StaticData.h"
 #include "InputType.h"
 #include "Manager.h"
+#include "SentenceArena.h"
 #include "moses/FF/FFState.h"
 #include "moses/FF/StatefulFeatureFunction.h"
 #include "moses/FF/StatelessFeatureFunction.h"
@@ -41,9 +43,14 @@ using namespace std;
 namespace Moses
 {
 
-#ifdef USE_HYPO_POOL
-ObjectPool<Hypothesis> Hypothesis::s_objectPool("Hypothesis", 300000);
-#endif
+namespace
+{
+void FreeArcList(SentenceArena &arena, ArcList *arcList)
+{
+  arcList->~ArcList();
+  arena.Free(arcList, sizeof(ArcList));
+}
+}
 
 Hypothesis::Hypothesis(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt)
   : m_prevHypo(NULL)
@@ -61,6 +68,7 @@ Hypothesis::Hypothesis(Manager& manager, InputType const& source, const Translat
   , m_transOpt(initialTransOpt)
   , m_manager(manager)
   , m_id(m_manager.GetNextHypoId())
+  , m_recombinationHashComputed(false)
 {
   // used for initial seeding of trans process
   // initialize scores
@@ -85,15 +93,14 @@ Hypothesis::Hypothesis(const Hypothesis &prevHypo, const TranslationOption &tran
   , m_wordDeleted(false)
   , m_totalScore(0.0f)
   , m_futureScore(0.0f)
-  , m_scoreBreakdown(prevHypo.GetScoreBreakdown())
+  , m_currScoreBreakdown(transOpt.GetScoreBreakdown())
   , m_ffStates(prevHypo.m_ffStates.size())
   , m_arcList(NULL)
   , m_transOpt(transOpt)
   , m_manager(prevHypo.GetManager())
   , m_id(m_manager.GetNextHypoId())
+  , m_recombinationHashComputed(false)
 {
-  m_scoreBreakdown.PlusEquals(transOpt.GetScoreBreakdown());
-
   // assert that we are not extending our hypothesis by retranslating something
   // that this hypothesis has already translated!
   assert(!m_sourceCompleted.Overlap(m_currSourceWordsRange));
@@ -116,11 +123,18 @@ Hypothesis::~Hypothesis()
     }
     m_arcList->clear();
 
-    delete m_arcList;
+    FreeArcList(m_manager.GetArena(), m_arcList);
     m_arcList = NULL;
   }
 }
 
+void Hypothesis::Free(Hypothesis *hypo)
+{
+  SentenceArena &arena = hypo->m_manager.GetArena();
+  hypo->~Hypothesis();
+  arena.Free(hypo, sizeof(Hypothesis));
+}
+
 void Hypothesis::AddArc(Hypothesis *loserHypo)
 {
   if (!m_arcList) {
@@ -128,7 +142,7 @@ void Hypothesis::AddArc(Hypothesis *loserHypo)
       this->m_arcList = loserHypo->m_arcList;  // take ownership, we'll delete
       loserHypo->m_arcList = 0;                // prevent a double deletion
     } else {
-      this->m_arcList = new ArcList();
+      this->m_arcList = new (m_manager.GetArena().Allocate(sizeof(ArcList))) ArcList();
     }
   } else {
     if (loserHypo->m_arcList) {  // both have an arc list: merge. delete loser
@@ -136,7 +150,7 @@ void Hypothesis::AddArc(Hypothesis *loserHypo)
       size_t add_size = loserHypo->m_arcList->size();
       this->m_arcList->resize(my_size + add_size, 0);
       std::memcpy(&(*m_arcList)[0] + my_size, &(*loserHypo->m_arcList)[0], add_size * sizeof(Hypothesis *));
-      delete loserHypo->m_arcList;
+      FreeArcList(m_manager.GetArena(), loserHypo->m_arcList);
       loserHypo->m_arcList = 0;
     } else { // loserHypo doesn't have any arcs
       // DO NOTHING
@@ -153,18 +167,30 @@ Hypothesis* Hypothesis::CreateNext(const TranslationOption &transOpt) const
   return Create(*this, transOpt);
 }
 
+void Hypothesis::PrefetchExpansions(const std::vector<std::pair<const Hypothesis*, const TranslationOption*> > &expansions)
+{
+  const StaticData &staticData = StaticData::Instance();
+  const vector<const StatefulFeatureFunction*>& ffs =
+    StatefulFeatureFunction::GetStatefulFeatureFunctions();
+  StatefulFeatureFunction::Expansions states(expansions.size());
+  for (unsigned i = 0; i < ffs.size(); ++i) {
+    const StatefulFeatureFunction &ff = *ffs[i];
+    if (staticData.IsFeatureFunctionIgnored(ff)) continue;
+    for (size_t j = 0; j < expansions.size(); ++j) {
+      states[j].first = expansions[j].first->m_ffStates[i];
+      states[j].second = &expansions[j].second->GetTargetPhrase();
+    }
+    ff.PrefetchExpansions(states);
+  }
+}
+
 /***
  * return the subclass of Hypothesis most appropriate to the given translation option
  */
 Hypothesis* Hypothesis::Create(const Hypothesis &prevHypo, const TranslationOption &transOpt)
 {
-
-#ifdef USE_HYPO_POOL
-  Hypothesis *ptr = s_objectPool.getPtr();
+  void *ptr = prevHypo.m_manager.GetArena().Allocate(sizeof(Hypothesis));
   return new(ptr) Hypothesis(prevHypo, transOpt);
-#else
-  return new Hypothesis(prevHypo, transOpt);
-#endif
 }
 /***
  * return the subclass of Hypothesis most appropriate to the given target phrase
@@ -172,12 +198,8 @@ Hypothesis* Hypothesis::Create(const Hypothesis &prevHypo, const TranslationOpti
 
 Hypothesis* Hypothesis::Create(Manager& manager, InputType const& m_source, const TranslationOption &initialTransOpt)
 {
-#ifdef USE_HYPO_POOL
-  Hypothesis *ptr = s_objectPool.getPtr();
+  void *ptr = manager.GetArena().Allocate(sizeof(Hypothesis));
   return new(ptr) Hypothesis(manager, m_source, initialTransOpt);
-#else
-  return new Hypothesis(manager, m_source, initialTransOpt);
-#endif
 }
 
 /** check, if two hypothesis can be recombined.
@@ -190,6 +212,12 @@ int Hypothesis::RecombineCompare(const Hypothesis &compare) const
   // -1 = this < compare
   // +1 = this > compare
   // 0	= this ==compare
+  // hypotheses that can be recombined have the same hash, so a mismatch
+  // settles the comparison without looking at the states
+  size_t hash = GetRecombinationHash(), compareHash = compare.GetRecombinationHash();
+  if (hash != compareHash)
+    return (hash < compareHash) ? -1 : +1;
+
   int comp = m_sourceCompleted.Compare(compare.m_sourceCompleted);
   if (comp != 0)
     return comp;
@@ -206,6 +234,15 @@ int Hypothesis::RecombineCompare(const Hypothesis &compare) const
   return 0;
 }
 
+size_t Hypothesis::CalcRecombinationHash() const
+{
+  size_t seed = m_sourceCompleted.hash();
+  for (unsigned i = 0; i < m_ffStates.size(); ++i) {
+    boost::hash_combine(seed, m_ffStates[i] ? m_ffStates[i]->hash() : 0);
+  }
+  return seed;
+}
+
 void Hypothesis::EvaluateWith(const StatefulFeatureFunction &sfff,
                               int state_idx)
 {
@@ -214,7 +251,7 @@ void Hypothesis::EvaluateWith(const StatefulFeatureFunction &sfff,
     m_ffStates[state_idx] = sfff.Evaluate(
                               *this,
                               m_prevHypo ? m_prevHypo->m_ffStates[state_idx] : NULL,
-                              &m_scoreBreakdown);
+                              &m_currScoreBreakdown);
   }
 }
 
@@ -222,7 +259,7 @@ void Hypothesis::EvaluateWith(const StatelessFeatureFunction& slff)
 {
   const StaticData &staticData = StaticData::Instance();
   if (! staticData.IsFeatureFunctionIgnored( slff )) {
-    slff.Evaluate(*this, &m_scoreBreakdown);
+    slff.Evaluate(*this, &m_currScoreBreakdown);
   }
 }
 
@@ -256,7 +293,7 @@ void Hypothesis::Evaluate(const SquareMatrix &futureScore)
     if (! staticData.IsFeatureFunctionIgnored(ff)) {
       m_ffStates[i] = ff.Evaluate(*this,
                                   m_prevHypo ? m_prevHypo->m_ffStates[i] : NULL,
-                                  &m_scoreBreakdown);
+                                  &m_currScoreBreakdown);
     }
   }
 
@@ -269,7 +306,11 @@ void Hypothesis::Evaluate(const SquareMatrix &futureScore)
   m_futureScore = futureScore.CalcFutureScore( m_sourceCompleted );
 
   // TOTAL
-  m_totalScore = m_scoreBreakdown.GetWeightedScore() + m_futureScore;
+  // only the scores added here need weighting, the rest is in the back-pointer
+  m_totalScore = m_currScoreBreakdown.GetWeightedScore() + m_futureScore;
+  if (m_prevHypo) {
+    m_totalScore += m_prevHypo->GetScore();
+  }
 
   IFVERBOSE(2) {
     m_manager.GetSentenceStats().StopTimeEstimateScore();
@@ -315,10 +356,20 @@ void Hypothesis::PrintHypothesis() const
   //	TRACE_ERR( "\tlanguage model cost "); // <<m_score[ScoreType::LanguageModelScore]<<endl;
   //	TRACE_ERR( "\tword penalty "); // <<(m_score[ScoreType::WordPenalty]*weightWordPenalty)<<endl;
   TRACE_ERR( "\tscore "<<m_totalScore - m_futureScore<<" + future cost "<<m_futureScore<<" = "<<m_totalScore<<endl);
-  TRACE_ERR(  "\tunweighted feature scores: " << m_scoreBreakdown << endl);
+  ScoreComponentCollection scoreBreakdown;
+  AddScoreBreakdown(scoreBreakdown);
+  TRACE_ERR(  "\tunweighted feature scores: " << scoreBreakdown << endl);
   //PrintLMScores();
 }
 
+void Hypothesis::AddScoreBreakdown(ScoreComponentCollection &scores) const
+{
+  // each hypothesis only keeps the scores it adds to its back-pointer
+  for (const Hypothesis *hypo = this; hypo != NULL; hypo = hypo->m_prevHypo) {
+    scores.PlusEquals(hypo->m_currScoreBreakdown);
+  }
+}
+
 void Hypothesis::CleanupArcList()
 {
   // point this hypo's main hypo to itself
@@ -383,7 +434,9 @@ ostream& operator<<(ostream& out, const Hypothesis& hypo)
 
   // scores
   out << " [total=" << hypo.GetTotalScore() << "]";
-  out << " " << hypo.GetScoreBreakdown();
+  ScoreComponentCollection scoreBreakdown;
+  hypo.AddScoreBreakdown(scoreBreakdown);
+  out << " " << scoreBreakdown;
 
   // alignment
   out << " " << hypo.GetCurrTargetPhrase().GetAlignNonTerm();
@@ -34,7 +34,6 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "GenerationDictionary.h"
 #include "ScoreComponentCollection.h"
 #include "InputType.h"
-#include "ObjectPool.h"
 
 namespace Moses
 {
@@ -64,8 +63,6 @@ class Hypothesis
   friend std::ostream& operator<<(std::ostream&, const Hypothesis&);
 
 protected:
-  static ObjectPool<Hypothesis> s_objectPool;
-
   const Hypothesis* m_prevHypo; /*! backpointer to previous hypothesis (from which this one was created) */
 //	const Phrase			&m_targetPhrase; /*! target phrase being created at the current decoding step */
   WordsBitmap				m_sourceCompleted; /*! keeps track of which words have been translated so far */
@@ -77,7 +74,7 @@ protected:
   bool							m_wordDeleted;
   float							m_totalScore;  /*! score so far */
   float							m_futureScore; /*! estimated future cost to translate rest of sentence */
-  ScoreComponentCollection m_scoreBreakdown; /*! scores for this hypothesis */
+  ScoreComponentCollection m_currScoreBreakdown; /*! scores added by this hypothesis alone */
   std::vector<const FFState*> m_ffStates;
   const Hypothesis 	*m_winningHypo;
   ArcList 					*m_arcList; /*! all arcs that end at the same trellis point as this hypothesis */
@@ -86,18 +83,23 @@ protected:
 
   int m_id; /*! numeric ID of this hypothesis, used for logging */
 
+  mutable size_t m_recombinationHash; /*! cached result of GetRecombinationHash() */
+  mutable bool m_recombinationHashComputed;
+
   /*! used by initial seeding of the translation process */
   Hypothesis(Manager& manager, InputType const& source, const TranslationOption &initialTransOpt);
   /*! used when creating a new hypothesis using a translation option (phrase translation) */
   Hypothesis(const Hypothesis &prevHypo, const TranslationOption &transOpt);
 
-public:
-  static ObjectPool<Hypothesis> &GetObjectPool() {
-    return s_objectPool;
-  }
+  size_t CalcRecombinationHash() const;
 
+public:
   ~Hypothesis();
 
+  /** destroy a hypothesis made by Create() and return its memory to the
+   *  arena of its Manager */
+  static void Free(Hypothesis *hypo);
+
   /** return the subclass of Hypothesis most appropriate to the given translation option */
   static Hypothesis* Create(const Hypothesis &prevHypo, const TranslationOption &transOpt);
 
@@ -109,6 +111,10 @@ public:
   /** return the subclass of Hypothesis most appropriate to the given translation option */
   Hypothesis* CreateNext(const TranslationOption &transOpt) const;
 
+  /** let the stateful feature functions prefetch for a batch of expansions
+   *  (hypothesis, option it is extended with) that is about to be created */
+  static void PrefetchExpansions(const std::vector<std::pair<const Hypothesis*, const TranslationOption*> > &expansions);
+
   void PrintHypothesis() const;
 
   const InputType& GetInput() const {
@@ -190,6 +196,16 @@ public:
 
   int RecombineCompare(const Hypothesis &compare) const;
 
+  /** hash over the coverage and all feature function states.
+   *  Hypotheses that can be recombined have the same hash */
+  size_t GetRecombinationHash() const {
+    if (!m_recombinationHashComputed) {
+      m_recombinationHash = CalcRecombinationHash();
+      m_recombinationHashComputed = true;
+    }
+    return m_recombinationHash;
+  }
+
   void GetOutputPhrase(Phrase &out) const;
 
   void ToStream(std::ostream& out) const {
@@ -227,8 +243,11 @@ public:
   inline const ArcList* GetArcList() const {
     return m_arcList;
   }
-  const ScoreComponentCollection& GetScoreBreakdown() const {
-    return m_scoreBreakdown;
+  //! adds the scores along the whole path up to this hypothesis to scores
+  void AddScoreBreakdown(ScoreComponentCollection &scores) const;
+  //! scores added by this hypothesis alone, relative to GetPrevHypo()
+  const ScoreComponentCollection& GetCurrScoreBreakdown() const {
+    return m_currScoreBreakdown;
   }
   float GetTotalScore() const {
     return m_totalScore;
@@ -241,6 +260,7 @@ public:
   }
   void SetFFState(int idx, FFState* state) {
     m_ffStates[idx] = state;
+    m_recombinationHashComputed = false;
   }
 
   // Added by oliver.wilson@ed.ac.uk for async lm stuff.
@@ -261,39 +281,29 @@ public:
 
 std::ostream& operator<<(std::ostream& out, const Hypothesis& hypothesis);
 
-// sorting helper
+// sorting helper. Ties go to the older hypothesis, so that the order does
+// not depend on the order of the input
 struct CompareHypothesisTotalScore {
   bool operator()(const Hypothesis* hypo1, const Hypothesis* hypo2) const {
-    return hypo1->GetTotalScore() > hypo2->GetTotalScore();
+    if (hypo1->GetTotalScore() != hypo2->GetTotalScore()) {
+      return hypo1->GetTotalScore() > hypo2->GetTotalScore();
+    }
+    return hypo1->GetId() < hypo2->GetId();
   }
 };
 
-#ifdef USE_HYPO_POOL
-
-#define FREEHYPO(hypo) \
-{ \
-	ObjectPool<Hypothesis> &pool = Hypothesis::GetObjectPool(); \
-	pool.freeObject(hypo); \
-} \
- 
-#else
-#define FREEHYPO(hypo) delete hypo
-#endif
+#define FREEHYPO(hypo) Hypothesis::Free(hypo)
 
-/** defines less-than relation on hypotheses.
-* The particular order is not important for us, we need just to figure out
-* which hypothesis are equal based on:
+/** defines which hypotheses can be recombined, ie. are equal based on:
 *   the last n-1 target words are the same
 *   and the covers (source words translated) are the same
-* Directly using RecombineCompare is unreliable because the Compare methods
-* of some states are based on archictecture-dependent pointer comparisons.
-* That's why we use the hypothesis IDs instead.
+* Only called for hypotheses with the same GetRecombinationHash().
 */
-class HypothesisRecombinationOrderer
+class HypothesisRecombinationEqual
 {
 public:
   bool operator()(const Hypothesis* hypoA, const Hypothesis* hypoB) const {
-    return (hypoA->RecombineCompare(*hypoB) < 0);
+    return (hypoA->RecombineCompare(*hypoB) == 0);
   }
 };
 
@@ -44,8 +44,9 @@ HypothesisStackNormal::HypothesisStackNormal(Manager& manager) :
 /** remove all hypotheses from the collection */
 void HypothesisStackNormal::RemoveAll()
 {
-  while (m_hypos.begin() != m_hypos.end()) {
-    Remove(m_hypos.begin());
+  for (iterator iter = m_hypos.begin(); iter != m_hypos.end(); ) {
+    iterator removeHyp = iter++;
+    Remove(removeHyp);
   }
 }
 
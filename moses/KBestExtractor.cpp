@@ -0,0 +1,188 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2014 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "KBestExtractor.h"
+
+#include "StaticData.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace Moses
+{
+
+// The top vertex joins the final hypotheses, as if they had been recombined.
+// Its candidates are the 1-best derivations of each of them.
+KBestExtractor::KBestExtractor(
+    const std::vector<const Hypothesis*> &finalHypos)
+{
+  for (std::vector<const Hypothesis*>::const_iterator p = finalHypos.begin();
+       p != finalHypos.end(); ++p) {
+    Vertex &w = FindOrCreateVertex(**p);
+    m_topVertex.candidates.push(
+      CreateDerivation(NULL, &w, 0, w.kBestList[0]->score));
+  }
+  m_topVertex.visited = true;
+}
+
+const KBestExtractor::Derivation *KBestExtractor::Get(std::size_t i)
+{
+  LazyKthBest(m_topVertex, i+1);
+  if (m_topVertex.kBestList.size() <= i) {
+    return NULL;
+  }
+  return m_topVertex.kBestList[i];
+}
+
+// Collect the hypotheses along a derivation from the top vertex.  The chain
+// is walked from the final hypothesis backwards, then reversed.
+void KBestExtractor::GetEdges(const Derivation &d,
+                              std::vector<const Hypothesis*> &edges)
+{
+  edges.clear();
+  for (const Derivation *p = &d; p != NULL; p = p->subderivation) {
+    if (p->edge) {
+      edges.push_back(p->edge);
+    }
+  }
+  std::reverse(edges.begin(), edges.end());
+}
+
+Phrase KBestExtractor::GetOutputPhrase(const Derivation &d)
+{
+  const std::vector<FactorType> &outputFactor =
+    StaticData::Instance().GetOutputFactorOrder();
+
+  std::vector<const Hypothesis*> edges;
+  GetEdges(d, edges);
+
+  Phrase ret(ARRAY_SIZE_INCR);
+  // Skip the initial hypothesis, it has no target phrase.
+  for (std::size_t i = 1; i < edges.size(); ++i) {
+    const TargetPhrase &phrase = edges[i]->GetCurrTargetPhrase();
+    for (std::size_t pos = 0; pos < phrase.GetSize(); ++pos) {
+      Word &newWord = ret.AddWord();
+      for (std::size_t j = 0; j < outputFactor.size(); ++j) {
+        FactorType factorType = outputFactor[j];
+        const Factor *factor = phrase.GetFactor(pos, factorType);
+        UTIL_THROW_IF2(factor == NULL,
+                       "No factor " << factorType << " at position " << pos);
+        newWord[factorType] = factor;
+      }
+    }
+  }
+  return ret;
+}
+
+// Look for the vertex corresponding to a given Hypothesis, creating a new one
+// (and the 1-best derivation through the hypothesis itself) if necessary.
+KBestExtractor::Vertex &KBestExtractor::FindOrCreateVertex(const Hypothesis &h)
+{
+  std::pair<VertexMap::iterator, bool> p =
+    m_vertexMap.insert(VertexMap::value_type(&h, Vertex()));
+  Vertex &v = p.first->second;
+  if (!p.second) {
+    return v;  // Vertex was already in m_vertexMap.
+  }
+  v.hypothesis = &h;
+  const Hypothesis *prevHypo = h.GetPrevHypo();
+  Vertex *tail = prevHypo ? &FindOrCreateVertex(*prevHypo) : NULL;
+  v.kBestList.push_back(CreateDerivation(&h, tail, 0, h.GetTotalScore()));
+  return v;
+}
+
+const KBestExtractor::Derivation *KBestExtractor::CreateDerivation(
+    const Hypothesis *edge, Vertex *tail, std::size_t backPointer, float score)
+{
+  m_derivations.push_back(Derivation());
+  Derivation &d = m_derivations.back();
+  d.edge = edge;
+  d.tail = tail;
+  d.backPointer = backPointer;
+  d.subderivation = tail ? tail->kBestList[backPointer] : NULL;
+  d.score = score;
+  return &d;
+}
+
+// Create the 1-best derivation for each arc of v and add it to v's candidate
+// queue.  An arc ends in the same coverage as v.hypothesis, so its total
+// score includes the same future score and the two can be compared directly.
+void KBestExtractor::GetCandidates(Vertex &v)
+{
+  const ArcList *arcList = v.hypothesis->GetArcList();
+  if (arcList) {
+    for (std::size_t i = 0; i < arcList->size(); ++i) {
+      const Hypothesis &arc = *(*arcList)[i];
+      const Hypothesis *prevHypo = arc.GetPrevHypo();
+      Vertex *tail = prevHypo ? &FindOrCreateVertex(*prevHypo) : NULL;
+      v.candidates.push(CreateDerivation(&arc, tail, 0, arc.GetTotalScore()));
+    }
+  }
+}
+
+// Lazily fill v's k-best list.
+void KBestExtractor::LazyKthBest(Vertex &v, std::size_t k)
+{
+  // If this is the first visit to vertex v then initialize the priority queue.
+  if (v.visited == false) {
+    // The 1-best derivation should already be in v's k-best list.
+    assert(v.kBestList.size() == 1);
+    GetCandidates(v);
+    v.visited = true;
+  }
+  // Add derivations to the k-best list until it contains k or there are none
+  // left to add.
+  while (v.kBestList.size() < k) {
+    // Update the priority queue by adding the neighbours of the derivations
+    // that have not been expanded yet (normally just the last one).
+    while (v.expanded < v.kBestList.size()) {
+      LazyNext(v, *v.kBestList[v.expanded++]);
+    }
+    // Check if there are any derivations left in the queue.
+    if (v.candidates.empty()) {
+      break;
+    }
+    // Move the next best derivation to the k-best list.
+    v.kBestList.push_back(v.candidates.top());
+    v.candidates.pop();
+  }
+}
+
+// Create the neighbour of Derivation d, which uses the next best derivation
+// of its tail, and add it to v's candidate queue.
+void KBestExtractor::LazyNext(Vertex &v, const Derivation &d)
+{
+  if (d.tail == NULL) {
+    return;
+  }
+  Vertex &pred = *d.tail;
+  // Ensure that pred's k-best list contains enough derivations.
+  std::size_t k = d.backPointer + 2;
+  LazyKthBest(pred, k);
+  if (pred.kBestList.size() < k) {
+    // pred's derivations have been exhausted.
+    return;
+  }
+  const Derivation *newSub = pred.kBestList[k-1];
+  float score = d.score - d.subderivation->score + newSub->score;
+  v.candidates.push(CreateDerivation(d.edge, d.tail, k-1, score));
+}
+
+}  // namespace Moses
@@ -0,0 +1,108 @@
+/***********************************************************************
+ Moses - statistical machine translation system
+ Copyright (C) 2006-2014 University of Edinburgh
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#pragma once
+
+#include "Hypothesis.h"
+#include "Phrase.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <deque>
+#include <queue>
+#include <vector>
+
+namespace Moses
+{
+
+// Phrase-based counterpart of ChartKBestExtractor: algorithm 3 from
+//
+//  Liang Huang and David Chiang
+//  "Better k-best parsing"
+//  In Proceedings of IWPT 2005
+//
+// applied to the recombined search graph.  Each vertex is a hypothesis that
+// survived recombination and its incoming edges are the hypothesis itself
+// plus everything in its arc list.  Every edge has at most one tail (the
+// previous hypothesis), so derivations are linked lists and, unlike in the
+// chart case, cannot be reached twice.  Only the derivations that are
+// actually popped are created.
+class KBestExtractor
+{
+public:
+  struct Vertex;
+
+  struct Derivation {
+    const Hypothesis *edge;   // NULL for the edges into the top vertex
+    Vertex *tail;             // NULL for the initial hypothesis
+    std::size_t backPointer;  // index into tail->kBestList
+    const Derivation *subderivation;
+    float score;
+  };
+
+  struct DerivationOrderer {
+    bool operator()(const Derivation *d1, const Derivation *d2) const {
+      return d1->score < d2->score;
+    }
+  };
+
+  struct Vertex {
+    typedef std::priority_queue<const Derivation *,
+                                std::vector<const Derivation *>,
+                                DerivationOrderer> DerivationQueue;
+
+    Vertex() : hypothesis(NULL), visited(false), expanded(0) {}
+
+    const Hypothesis *hypothesis;  // NULL for the top vertex
+    std::vector<const Derivation *> kBestList;
+    DerivationQueue candidates;
+    bool visited;
+    std::size_t expanded;  // number of kBestList entries whose neighbours exist
+  };
+
+  // finalHypos are the hypotheses in the last stack.
+  KBestExtractor(const std::vector<const Hypothesis*> &finalHypos);
+
+  // Return the i-th best derivation (counting from 0), or NULL if the search
+  // graph contains fewer derivations.  Extends the k-best list as needed.
+  const Derivation *Get(std::size_t i);
+
+  // The hypotheses and arcs that make up a complete derivation, from the
+  // initial hypothesis to the final one.
+  static void GetEdges(const Derivation &, std::vector<const Hypothesis*> &);
+
+  // The output-factor surface string of a complete derivation.
+  static Phrase GetOutputPhrase(const Derivation &);
+
+private:
+  typedef boost::unordered_map<const Hypothesis *, Vertex> VertexMap;
+
+  Vertex &FindOrCreateVertex(const Hypothesis &);
+  const Derivation *CreateDerivation(const Hypothesis *edge, Vertex *tail,
+                                     std::size_t backPointer, float score);
+  void GetCandidates(Vertex &);
+  void LazyKthBest(Vertex &, std::size_t);
+  void LazyNext(Vertex &, const Derivation &);
+
+  VertexMap m_vertexMap;
+  Vertex m_topVertex;
+  std::deque<Derivation> m_derivations;
+};
+
+}  // namespace Moses
@@ -0,0 +1,239 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "Hypothesis.h"
+#include "KBestExtractor.h"
+#include "Manager.h"
+#include "Sentence.h"
+#include "TranslationOption.h"
+#include "TrellisPath.h"
+#include "TrellisPathCollection.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+// The scores are set by hand rather than by feature functions
+struct ScoreSetter : public Hypothesis {
+  static void Set(Hypothesis &hypo, float totalScore) {
+    hypo.*(&ScoreSetter::m_totalScore) = totalScore;
+  }
+};
+
+// The path Manager::CalcLazyNBest makes from a derivation
+struct DerivationPath : public TrellisPath {
+  DerivationPath(const vector<const Hypothesis*> &edges) : TrellisPath(edges) {}
+};
+
+const InputType &ReadSentence(Sentence &sentence, const string &line)
+{
+  vector<FactorType> factors(1, 0);
+  istringstream in(line + "\n");
+  sentence.Read(in, factors);
+  return sentence;
+}
+
+/** A recombined search graph, as the search leaves it before n-best
+ * extraction, but built edge by edge.
+ */
+class SearchGraph
+{
+public:
+  SearchGraph(const string &source)
+    : m_manager(0, ReadSentence(m_sentence, source), Normal) {
+    m_manager.ResetSentenceStats(m_sentence);
+    m_initial = Hypothesis::Create(m_manager, m_sentence, m_initialTransOpt);
+    m_initial->SetWinningHypo(m_initial);
+    m_hypos.push_back(m_initial);
+  }
+
+  ~SearchGraph() {
+    // winners free their arcs
+    for (vector<Hypothesis*>::reverse_iterator it = m_hypos.rbegin(); it != m_hypos.rend(); ++it) {
+      if ((*it)->GetWinningHypo() == *it) {
+        FREEHYPO(*it);
+      }
+    }
+    RemoveAllInColl(m_transOpts);
+  }
+
+  Hypothesis *GetInitial() const {
+    return m_initial;
+  }
+
+  //! translate source words [start, end] as target, adding score to prevHypo's
+  Hypothesis *Extend(const Hypothesis &prevHypo, size_t start, size_t end,
+                     const string &target, float score) {
+    TargetPhrase targetPhrase;
+    targetPhrase.CreateFromString(Output, vector<FactorType>(1, 0), target, "|", NULL);
+    m_transOpts.push_back(new TranslationOption(WordsRange(start, end), targetPhrase));
+    Hypothesis *hypo = Hypothesis::Create(prevHypo, *m_transOpts.back());
+    ScoreSetter::Set(*hypo, prevHypo.GetTotalScore() + score);
+    hypo->SetWinningHypo(hypo);
+    m_hypos.push_back(hypo);
+    return hypo;
+  }
+
+  void Recombine(Hypothesis *winner, Hypothesis *loser) {
+    winner->AddArc(loser);
+    loser->SetWinningHypo(winner);
+  }
+
+private:
+  Sentence m_sentence;
+  TranslationOption m_initialTransOpt;
+  Manager m_manager;
+  Hypothesis *m_initial;
+  vector<Hypothesis*> m_hypos;
+  vector<TranslationOption*> m_transOpts;
+};
+
+/** Derivations that share a prefix are recombined at every stack.  Every
+ * surface string can be reached at least twice, and no two paths tie.
+ */
+void MakeGraph(SearchGraph &graph, vector<const Hypothesis*> &finalHypos)
+{
+  Hypothesis *x = graph.Extend(*graph.GetInitial(), 0, 0, "x", -1.0);
+  graph.Recombine(x, graph.Extend(*graph.GetInitial(), 0, 0, "y", -1.45));
+  Hypothesis *xz = graph.Extend(*x, 1, 1, "z", -1.0);
+  graph.Recombine(xz, graph.Extend(*graph.GetInitial(), 0, 1, "y z", -2.3));
+  Hypothesis *xzw = graph.Extend(*xz, 2, 2, "w", -1.0);
+  graph.Recombine(xzw, graph.Extend(*xz, 2, 2, "v", -1.2));
+  Hypothesis *xzw2 = graph.Extend(*x, 1, 2, "z w", -2.1);
+  graph.Recombine(xzw2, graph.Extend(*x, 1, 2, "z v", -2.6));
+  finalHypos.push_back(xzw);
+  finalHypos.push_back(xzw2);
+}
+
+struct Path {
+  float score;
+  vector<const Hypothesis*> edges;  // final hypothesis first
+  string target;
+};
+
+Path MakePath(const TrellisPath &trellisPath, float score)
+{
+  Path path;
+  path.score = score;
+  path.edges = trellisPath.GetEdges();
+  path.target = trellisPath.GetTargetPhrase().GetStringRep(vector<FactorType>(1, 0));
+  return path;
+}
+
+//! the paths in the order Manager::CalcNBest finds them
+vector<Path> GetTrellisPaths(const vector<const Hypothesis*> &finalHypos, bool distinct)
+{
+  vector<Path> paths;
+  set<string> targets;
+  TrellisPathCollection contenders;
+  for (size_t i = 0; i < finalHypos.size(); ++i) {
+    contenders.Add(new TrellisPath(finalHypos[i]));
+  }
+  while (contenders.GetSize() > 0) {
+    boost::scoped_ptr<TrellisPath> trellisPath(contenders.pop());
+    trellisPath->CreateDeviantPaths(contenders);
+    Path path = MakePath(*trellisPath, trellisPath->GetTotalScore());
+    if (!distinct || targets.insert(path.target).second) {
+      paths.push_back(path);
+    }
+  }
+  return paths;
+}
+
+//! the paths in the order Manager::CalcLazyNBest finds them
+vector<Path> GetKBestPaths(const vector<const Hypothesis*> &finalHypos, bool distinct)
+{
+  vector<Path> paths;
+  set<string> targets;
+  KBestExtractor extractor(finalHypos);
+  vector<const Hypothesis*> edges;
+  for (size_t i = 0; const KBestExtractor::Derivation *d = extractor.Get(i); ++i) {
+    KBestExtractor::GetEdges(*d, edges);
+    DerivationPath trellisPath(edges);
+    BOOST_CHECK_SMALL(d->score - trellisPath.GetTotalScore(), 1e-4f);
+    Path path = MakePath(trellisPath, d->score);
+    if (!distinct || targets.insert(path.target).second) {
+      paths.push_back(path);
+    }
+  }
+  return paths;
+}
+
+void CheckSamePaths(const vector<Path> &actual, const vector<Path> &expected)
+{
+  BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    BOOST_CHECK_SMALL(actual[i].score - expected[i].score, 1e-4f);
+    BOOST_CHECK(actual[i].edges == expected[i].edges);
+    BOOST_CHECK_EQUAL(actual[i].target, expected[i].target);
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(kbest_extractor)
+
+BOOST_AUTO_TEST_CASE(kbest_matches_trellis_paths)
+{
+  SearchGraph graph("a b c");
+  vector<const Hypothesis*> finalHypos;
+  MakeGraph(graph, finalHypos);
+
+  const vector<Path> expected = GetTrellisPaths(finalHypos, false);
+  BOOST_CHECK_EQUAL(expected.size(), 10u);
+  CheckSamePaths(GetKBestPaths(finalHypos, false), expected);
+}
+
+BOOST_AUTO_TEST_CASE(distinct_kbest_matches_trellis_paths)
+{
+  SearchGraph graph("a b c");
+  vector<const Hypothesis*> finalHypos;
+  MakeGraph(graph, finalHypos);
+
+  // "x z w" first comes from both final hypotheses, "y z w" from an arc of
+  // each of the first two stacks
+  const vector<Path> expected = GetTrellisPaths(finalHypos, true);
+  BOOST_CHECK_EQUAL(expected.size(), 4u);
+  CheckSamePaths(GetKBestPaths(finalHypos, true), expected);
+}
+
+BOOST_AUTO_TEST_CASE(exhausted_kbest_list)
+{
+  SearchGraph graph("a");
+  vector<const Hypothesis*> finalHypos;
+  finalHypos.push_back(graph.Extend(*graph.GetInitial(), 0, 0, "x", -1.0));
+
+  KBestExtractor extractor(finalHypos);
+  BOOST_REQUIRE(extractor.Get(0) != NULL);
+  BOOST_CHECK_SMALL(extractor.Get(0)->score + 1.0f, 1e-4f);
+  BOOST_CHECK(extractor.Get(1) == NULL);
+  BOOST_CHECK(extractor.Get(0) != NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -55,6 +55,10 @@ public:
 
   FFState *Evaluate(const Phrase &phrase, const FFState *ps, float &returnedScore) const;
 
+  //! scores right to left from a BackwardLMState, nothing to fetch ahead
+  virtual void PrefetchExpansions(const StatefulFeatureFunction::Expansions &) const {
+  }
+
 private:
 
   // These lines are required to make the parent class's protected members visible to this class
@@ -54,6 +54,7 @@ public:
     }
   */
   int Compare(const FFState &o) const;
+  size_t hash() const;
 
   // Allow BackwardLanguageModel to access the private members of this class
   template <class Model> friend class BackwardLanguageModel;
@@ -76,7 +76,8 @@ public:
           false)
       )
     ) {
-    // This space intentionally left blank
+    // the model file is read in Load(), not in the constructor
+    backwardLM->Load();
   }
 
   ~BackwardLanguageModelTest() {
@@ -165,6 +165,20 @@ public:
     }
     return 0;
   }
+
+  //! only the prefix length goes in: Compare() matches words on the factors both sides have
+  size_t hash() const {
+    size_t seed = 0;
+    if (m_hypo.GetCurrSourceRange().GetStartPos() > 0) {
+      boost::hash_combine(seed, GetPrefix().GetSize());
+    }
+
+    size_t inputSize = m_hypo.GetManager().GetSource().GetSize();
+    if (m_hypo.GetCurrSourceRange().GetEndPos() < inputSize - 1) {
+      boost::hash_combine(seed, m_lmRightContext->hash());
+    }
+    return seed;
+  }
 };
 
 } // namespace
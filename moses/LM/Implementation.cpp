@@ -215,6 +215,7 @@ FFState *LanguageModelImplementation::Evaluate(const Hypothesis &hypo, const FFS
   } else {
     out->PlusEquals(this, lmScore);
   }
+  hypo.GetManager().GetSentenceStats().AddLMLookups(endPos - startPos + 1 + hypo.IsSourceCompleted());
 
   IFVERBOSE(2) {
     hypo.GetManager().GetSentenceStats().StopTimeCalcLM();
@@ -235,6 +236,7 @@ FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo,
   // initial language model scores
   float prefixScore = 0.0;    // not yet final for initial words (lack context)
   float finalizedScore = 0.0; // finalized, has sufficient context
+  size_t lookups = 0;
 
   // get index map for underlying hypotheses
   const AlignmentInfo::NonTermIndexMap &nonTermIndexMap =
@@ -261,6 +263,7 @@ FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo,
       // score a regular word added by the rule
       else {
         updateChartScore( &prefixScore, &finalizedScore, GetValueGivenState(contextFactor, *lmState).score, ++wordPos );
+        ++lookups;
       }
     }
 
@@ -306,6 +309,7 @@ FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo,
           const Word &word = prevState->GetPrefix().GetWord(prefixPos);
           ShiftOrPush(contextFactor, word);
           updateChartScore( &prefixScore, &finalizedScore, GetValueGivenState(contextFactor, *lmState).score, ++wordPos );
+          ++lookups;
         }
 
         // check if we are dealing with a large sub-phrase
@@ -339,6 +343,7 @@ FFState* LanguageModelImplementation::EvaluateChart(const ChartHypothesis& hypo,
 
   // assign combined score to score breakdown
   out->Assign(this, prefixScore + finalizedScore);
+  hypo.GetManager().GetSentenceStats().AddLMLookups(lookups);
 
   ret->Set(prefixScore, lmState);
   return ret;
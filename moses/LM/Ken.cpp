@@ -23,6 +23,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <iostream>
 #include <memory>
 #include <stdlib.h>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "lm/binary_format.hh"
@@ -38,11 +40,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/Util.h"
 #include "moses/FactorCollection.h"
 #include "moses/Phrase.h"
+#include "moses/TargetPhrase.h"
 #include "moses/InputFileStream.h"
 #include "moses/StaticData.h"
 #include "moses/ChartHypothesis.h"
+#include "moses/ChartManager.h"
+#include "moses/Manager.h"
 #include "moses/Incremental.h"
 #include "moses/UserMessage.h"
+#include "moses/ResourceRegistry.h"
 
 using namespace std;
 
@@ -59,6 +65,9 @@ struct KenLMState : public FFState {
     if (state.length > other.state.length) return 1;
     return std::memcmp(state.words, other.state.words, sizeof(lm::WordIndex) * state.length);
   }
+  size_t hash() const {
+    return lm::ngram::hash_value(state, state.length);
+  }
 };
 
 ///*
@@ -82,7 +91,7 @@ struct KenLMState : public FFState {
 //  FFState *EvaluateChart(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection *accumulator) const;
 //
 //  void IncrementalCallback(Incremental::Manager &manager) const {
-//    manager.LMCallback(*m_ngram, m_lmIdLookup);
+//    manager.LMCallback(*m_ngram, *m_lmIdLookup);
 //  }
 //
 //  bool IsUseable(const FactorMask &mask) const;
@@ -138,11 +147,13 @@ private:
   std::vector<lm::WordIndex> &m_mapping;
 };
 
-} // namespace
+// what features that load the same file share
+template <class Model> struct LoadedModel {
+  boost::scoped_ptr<Model> model;
+  std::vector<lm::WordIndex> lmIdLookup;
+};
 
-template <class Model> LanguageModelKen<Model>::LanguageModelKen(const std::string &line, const std::string &file, FactorType factorType, bool lazy)
-  :LanguageModel(line)
-  ,m_factorType(factorType)
+template <class Model> LoadedModel<Model> *LoadModel(const std::string &file, bool lazy)
 {
   lm::ngram::Config config;
   IFVERBOSE(1) {
@@ -151,23 +162,44 @@ template <class Model> LanguageModelKen<Model>::LanguageModelKen(const std::stri
   else {
     config.messages = NULL;
   }
-  FactorCollection &collection = FactorCollection::Instance();
-  MappingBuilder builder(collection, m_lmIdLookup);
+  std::auto_ptr<LoadedModel<Model> > ret(new LoadedModel<Model>());
+  MappingBuilder builder(FactorCollection::Instance(), ret->lmIdLookup);
   config.enumerate_vocab = &builder;
   config.load_method = lazy ? util::LAZY : util::POPULATE_OR_READ;
 
-  m_ngram.reset(new Model(file.c_str(), config));
+  ret->model.reset(new Model(file.c_str(), config));
+  return ret.release();
+}
+
+} // namespace
 
+template <class Model> LanguageModelKen<Model>::LanguageModelKen(const std::string &line, const std::string &file, FactorType factorType, bool lazy)
+  :LanguageModel(line)
+  ,m_factorType(factorType)
+  ,m_filePath(file)
+  ,m_lazy(lazy)
+{
+  FactorCollection &collection = FactorCollection::Instance();
   m_beginSentenceFactor = collection.AddFactor(BOS_);
 }
 
+template <class Model> void LanguageModelKen<Model>::Load()
+{
+  boost::shared_ptr<LoadedModel<Model> > loaded = ResourceRegistry::Instance().Acquire<LoadedModel<Model> >(
+        (m_lazy ? "KENLM lazy " : "KENLM ") + m_filePath, boost::bind(&LoadModel<Model>, m_filePath, m_lazy));
+  // point into the shared copy and keep it alive
+  m_ngram = boost::shared_ptr<Model>(loaded, loaded->model.get());
+  m_lmIdLookup = boost::shared_ptr<const std::vector<lm::WordIndex> >(loaded, &loaded->lmIdLookup);
+}
+
 template <class Model> LanguageModelKen<Model>::LanguageModelKen(const LanguageModelKen<Model> &copy_from)
   :LanguageModel(copy_from.GetArgLine()),
    m_ngram(copy_from.m_ngram),
-// TODO: don't copy this.
    m_lmIdLookup(copy_from.m_lmIdLookup),
    m_factorType(copy_from.m_factorType),
-   m_beginSentenceFactor(copy_from.m_beginSentenceFactor)
+   m_beginSentenceFactor(copy_from.m_beginSentenceFactor),
+   m_filePath(copy_from.m_filePath),
+   m_lazy(copy_from.m_lazy)
 {
 }
 
@@ -270,6 +302,7 @@ template <class Model> FFState *LanguageModelKen<Model>::Evaluate(const Hypothes
     // Short enough phrase that we can just reuse the state.
     ret->state = *state0;
   }
+  hypo.GetManager().GetSentenceStats().AddLMLookups(adjust_end - begin + hypo.IsSourceCompleted());
 
   score = TransformLMScore(score);
 
@@ -285,6 +318,24 @@ template <class Model> FFState *LanguageModelKen<Model>::Evaluate(const Hypothes
   return ret.release();
 }
 
+template <class Model> void LanguageModelKen<Model>::PrefetchExpansions(const Expansions &expansions) const
+{
+  // Evaluate() scores the first Order() - 1 words of a phrase with the model,
+  // beyond that it only needs the state
+  const std::size_t maxWords = m_ngram->Order() - 1;
+  lm::WordIndex words[KENLM_MAX_ORDER - 1];
+  for (Expansions::const_iterator iter = expansions.begin(); iter != expansions.end(); ++iter) {
+    const TargetPhrase &phrase = *iter->second;
+    const std::size_t size = std::min(phrase.GetSize(), maxWords);
+    if (!size) continue;
+    for (std::size_t i = 0; i < size; ++i) {
+      words[i] = TranslateID(phrase.GetWord(i));
+    }
+    const lm::ngram::State &in_state = static_cast<const KenLMState&>(*iter->first).state;
+    m_ngram->Prefetch(in_state, words, words + size);
+  }
+}
+
 class LanguageModelChartStateKenLM : public FFState
 {
 public:
@@ -303,48 +354,106 @@ public:
     return ret;
   }
 
+  size_t hash() const {
+    return lm::ngram::hash_value(m_state);
+  }
+
 private:
   lm::ngram::ChartState m_state;
 };
 
-template <class Model> FFState *LanguageModelKen<Model>::EvaluateChart(const ChartHypothesis& hypo, int featureID, ScoreComponentCollection *accumulator) const
+template <class Model> bool LanguageModelKen<Model>::IsCached(const RuleFragments &fragments, const TargetPhrase &target) const
 {
-  LanguageModelChartStateKenLM *newState = new LanguageModelChartStateKenLM();
-  lm::ngram::RuleScore<Model> ruleScore(*m_ngram, newState->GetChartState());
-  const TargetPhrase &target = hypo.GetCurrTargetPhrase();
-  const AlignmentInfo::NonTermIndexMap &nonTermIndexMap =
-    target.GetAlignNonTerm().GetNonTermIndexMap();
+  if (fragments.words.size() != target.GetSize()) return false;
+  for (size_t pos = 0; pos < fragments.words.size(); ++pos) {
+    const Word &word = target.GetWord(pos);
+    const Factor *factor = word.IsNonTerminal() ? NULL : word.GetFactor(m_factorType);
+    if (factor != fragments.words[pos]) return false;
+  }
+  return true;
+}
 
-  const size_t size = hypo.GetCurrTargetPhrase().GetSize();
-  size_t phrasePos = 0;
-  // Special cases for first word.
-  if (size) {
-    const Word &word = hypo.GetCurrTargetPhrase().GetWord(0);
-    if (word.GetFactor(m_factorType) == m_beginSentenceFactor) {
-      // Begin of sentence
-      ruleScore.BeginSentence();
-      phrasePos++;
-    } else if (word.IsNonTerminal()) {
-      // Non-terminal is first so we can copy instead of rescoring.
-      const ChartHypothesis *prevHypo = hypo.GetPrevHypo(nonTermIndexMap[phrasePos]);
-      const lm::ngram::ChartState &prevState = static_cast<const LanguageModelChartStateKenLM*>(prevHypo->GetFFState(featureID))->GetChartState();
-      float prob = UntransformLMScore(prevHypo->GetScoreBreakdown().GetScoresForProducer(this)[0]);
-      ruleScore.BeginNonTerminal(prevState, prob);
-      phrasePos++;
+template <class Model> void LanguageModelKen<Model>::ScoreFragments(RuleFragments &fragments, const TargetPhrase &target) const
+{
+  const size_t size = target.GetSize();
+  fragments.words.resize(size);
+  fragments.nonTerms.clear();
+  for (size_t pos = 0; pos < size; ++pos) {
+    const Word &word = target.GetWord(pos);
+    if (word.IsNonTerminal()) {
+      fragments.words[pos] = NULL;
+      fragments.nonTerms.push_back(pos);
+    } else {
+      fragments.words[pos] = word.GetFactor(m_factorType);
     }
   }
 
-  for (; phrasePos < size; phrasePos++) {
-    const Word &word = hypo.GetCurrTargetPhrase().GetWord(phrasePos);
-    if (word.IsNonTerminal()) {
-      const ChartHypothesis *prevHypo = hypo.GetPrevHypo(nonTermIndexMap[phrasePos]);
-      const lm::ngram::ChartState &prevState = static_cast<const LanguageModelChartStateKenLM*>(prevHypo->GetFFState(featureID))->GetChartState();
-      float prob = UntransformLMScore(prevHypo->GetScoreBreakdown().GetScoresForProducer(this)[0]);
-      ruleScore.NonTerminal(prevState, prob);
+  // same as search::ScoreRule: every run of terminals is scored on its own
+  fragments.runs.resize(fragments.nonTerms.size() + 1);
+  fragments.prob = 0.0;
+  size_t run = 0;
+  lm::ngram::RuleScore<Model> scorer(*m_ngram, fragments.runs[run]);
+  size_t pos = 0;
+  if (size && fragments.words[0] == m_beginSentenceFactor) {
+    scorer.BeginSentence();
+    pos = 1;
+  }
+  for (; pos < size; ++pos) {
+    if (fragments.words[pos]) {
+      scorer.Terminal(TranslateID(target.GetWord(pos)));
     } else {
-      ruleScore.Terminal(TranslateID(word));
+      fragments.prob += scorer.Finish();
+      scorer.Reset(fragments.runs[++run]);
     }
   }
+  fragments.prob += scorer.Finish();
+}
+
+template <class Model> const typename LanguageModelKen<Model>::RuleFragments &LanguageModelKen<Model>::GetFragments(const TargetPhrase &target, std::size_t &lookups) const
+{
+  if (!m_ruleCache.get()) {
+    m_ruleCache.reset(new RuleCache());
+  }
+  RuleCache &cache = *m_ruleCache;
+  typename RuleCache::iterator found = cache.find(&target);
+  if (found != cache.end() && IsCached(found->second, target)) {
+    return found->second;
+  }
+  if (found == cache.end() && cache.size() >= MaxCachedRules) {
+    cache.clear();
+  }
+
+  RuleFragments &fragments = cache[&target];
+  ScoreFragments(fragments, target);
+  lookups += target.GetSize() - fragments.nonTerms.size();
+  return fragments;
+}
+
+template <class Model> FFState *LanguageModelKen<Model>::EvaluateChart(const ChartHypothesis& hypo, int featureID, ScoreComponentCollection *accumulator) const
+{
+  const TargetPhrase &target = hypo.GetCurrTargetPhrase();
+  const AlignmentInfo::NonTermIndexMap &nonTermIndexMap =
+    target.GetAlignNonTerm().GetNonTermIndexMap();
+
+  std::size_t lookups = 0;
+  const RuleFragments &fragments = GetFragments(target, lookups);
+
+  // The terminals are already scored, so only the n-grams that cross
+  // into or out of a non-terminal are looked up here.
+  LanguageModelChartStateKenLM *newState = new LanguageModelChartStateKenLM();
+  lm::ngram::RuleScore<Model> ruleScore(*m_ngram, newState->GetChartState());
+  ruleScore.BeginNonTerminal(fragments.runs[0], fragments.prob);
+  for (size_t i = 0; i < fragments.nonTerms.size(); ++i) {
+    const ChartHypothesis *prevHypo = hypo.GetPrevHypo(nonTermIndexMap[fragments.nonTerms[i]]);
+    const lm::ngram::ChartState &prevState = static_cast<const LanguageModelChartStateKenLM*>(prevHypo->GetFFState(featureID))->GetChartState();
+    float prob = UntransformLMScore(prevHypo->GetScoreBreakdown().GetScoresForProducer(this)[0]);
+    ruleScore.NonTerminal(prevState, prob);
+
+    const lm::ngram::ChartState &run = fragments.runs[i + 1];
+    ruleScore.NonTerminal(run);
+    lookups += run.left.length;
+  }
+  hypo.GetManager().GetSentenceStats().AddLMLookups(lookups);
 
   float score = ruleScore.Finish();
   score = TransformLMScore(score);
@@ -354,7 +463,7 @@ template <class Model> FFState *LanguageModelKen<Model>::EvaluateChart(const Cha
 
 template <class Model> void LanguageModelKen<Model>::IncrementalCallback(Incremental::Manager &manager) const
 {
-  manager.LMCallback(*m_ngram, m_lmIdLookup);
+  manager.LMCallback(*m_ngram, *m_lmIdLookup);
 }
 
 template <class Model> void LanguageModelKen<Model>::ReportHistoryOrder(std::ostream &out, const Phrase &phrase) const
@@ -23,8 +23,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #define moses_LanguageModelKen_h
 
 #include <string>
+#include <vector>
 #include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#ifdef WITH_THREADS
+#include <boost/thread/tss.hpp>
+#else
+#include <boost/scoped_ptr.hpp>
+#endif
 
+#include "lm/state.hh"
 #include "lm/word_index.hh"
 
 #include "moses/LM/Base.h"
@@ -37,10 +45,12 @@ namespace Moses
 
 //class LanguageModel;
 class FFState;
+class Factor;
+class TargetPhrase;
 
 LanguageModel *ConstructKenLM(const std::string &line);
 
-//! This will also load. Returns a templated KenLM class
+//! Returns a templated KenLM class, the model file is read by Load()
 LanguageModel *ConstructKenLM(const std::string &line, const std::string &file, FactorType factorType, bool lazy);
 
 /*
@@ -51,12 +61,16 @@ template <class Model> class LanguageModelKen : public LanguageModel
 public:
   LanguageModelKen(const std::string &line, const std::string &file, FactorType factorType, bool lazy);
 
+  void Load();
+
   virtual const FFState *EmptyHypothesisState(const InputType &/*input*/) const;
 
   virtual void CalcScore(const Phrase &phrase, float &fullScore, float &ngramScore, size_t &oovCount) const;
 
   virtual FFState *Evaluate(const Hypothesis &hypo, const FFState *ps, ScoreComponentCollection *out) const;
 
+  virtual void PrefetchExpansions(const Expansions &expansions) const;
+
   virtual FFState *EvaluateChart(const ChartHypothesis& cur_hypo, int featureID, ScoreComponentCollection *accumulator) const;
 
   virtual void IncrementalCallback(Incremental::Manager &manager) const;
@@ -73,7 +87,8 @@ protected:
 
   lm::WordIndex TranslateID(const Word &word) const {
     std::size_t factor = word.GetFactor(m_factorType)->GetId();
-    return (factor >= m_lmIdLookup.size() ? 0 : m_lmIdLookup[factor]);
+    const std::vector<lm::WordIndex> &lookup = *m_lmIdLookup;
+    return (factor >= lookup.size() ? 0 : lookup[factor]);
   }
 
 private:
@@ -94,8 +109,35 @@ private:
     }
   }
 
-  std::vector<lm::WordIndex> m_lmIdLookup;
+  //! owned by the registry entry, like m_ngram
+  boost::shared_ptr<const std::vector<lm::WordIndex> > m_lmIdLookup;
+
+  std::string m_filePath;
+  bool m_lazy;
+
+  /** LM score of the terminals of a rule that does not depend on the
+   *  children, scored once per target phrase in chart decoding.
+   */
+  struct RuleFragments {
+    std::vector<const Factor*> words; //!< NULL for non-terminals, checked on lookup because phrase addresses are reused
+    std::vector<size_t> nonTerms; //!< target positions of the non-terminals
+    std::vector<lm::ngram::ChartState> runs; //!< state of the terminals before each non-terminal and after the last one
+    float prob; //!< score of the n-grams within the runs
+  };
+
+  //! number of rules kept per thread before the cache is emptied
+  static const size_t MaxCachedRules = 100000;
+
+  typedef boost::unordered_map<const TargetPhrase*, RuleFragments> RuleCache;
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<RuleCache> m_ruleCache;
+#else
+  mutable boost::scoped_ptr<RuleCache> m_ruleCache;
+#endif
 
+  bool IsCached(const RuleFragments &fragments, const TargetPhrase &target) const;
+  void ScoreFragments(RuleFragments &fragments, const TargetPhrase &target) const;
+  const RuleFragments &GetFragments(const TargetPhrase &target, std::size_t &lookups) const;
 };
 
 } // namespace Moses
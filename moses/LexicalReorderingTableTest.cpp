@@ -0,0 +1,102 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <sstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "FactorCollection.h"
+#include "FF/LexicalReordering/LexicalReorderingTable.h"
+#include "MockTempFile.h"
+
+using namespace Moses;
+using namespace MosesTest;
+using namespace std;
+
+namespace
+{
+
+const char* const kTable =
+  "a b ||| x ||| ||| 0.1 0.2\n"
+  "a b ||| x ||| y ||| 0.3 0.4\n"
+  "a b ||| x ||| z y ||| 0.5 0.6\n"
+  "c ||| x y ||| ||| 0.7 0.8\n";
+
+Phrase MakePhrase(const string &str)
+{
+  Phrase phrase(0);
+  istringstream words(str);
+  string word;
+  while (words >> word) {
+    Word &added = phrase.AddWord();
+    added.SetFactor(0, FactorCollection::Instance().AddFactor(word));
+  }
+  return phrase;
+}
+
+// the mapped table next to the text one
+void CreateMapped(const string &path)
+{
+  istringstream in(kTable);
+  BOOST_REQUIRE(LexicalReorderingTableMapped::Create(in, path));
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(lexical_reordering_table)
+
+BOOST_AUTO_TEST_CASE(mapped_matches_memory)
+{
+  MockTempFileGuard file("lexical_reordering_test", kTable, ".mlexr");
+  CreateMapped(file.GetPath());
+  FactorList factors(1, 0);
+  LexicalReorderingTableMemory memory(file.GetPath(), factors, factors, factors);
+  LexicalReorderingTableMapped mapped(file.GetPath(), factors, factors, factors);
+
+  const char* const queries[][3] = {
+    {"a b", "x", ""},
+    {"a b", "x", "y"},
+    {"a b", "x", "z y"},
+    {"a b", "x", "w z y"},
+    {"a b", "x", "y w"},
+    {"c", "x y", "y"},
+    {"c", "x", ""},
+    {"a", "x", ""}
+  };
+  for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+    Phrase f = MakePhrase(queries[i][0]);
+    Phrase e = MakePhrase(queries[i][1]);
+    Phrase c = MakePhrase(queries[i][2]);
+    Scores expected = memory.GetScore(f, e, c);
+    Scores actual = mapped.GetScore(f, e, c);
+    BOOST_CHECK_EQUAL_COLLECTIONS(actual.begin(), actual.end(), expected.begin(), expected.end());
+  }
+  BOOST_CHECK_EQUAL(mapped.GetScore(MakePhrase("a b"), MakePhrase("x"), MakePhrase("w z y")).size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_checks_key_fields)
+{
+  MockTempFileGuard file("lexical_reordering_test", kTable, ".mlexr");
+  CreateMapped(file.GetPath());
+  FactorList factors(1, 0);
+  BOOST_CHECK_THROW(LexicalReorderingTableMapped(file.GetPath(), factors, factors, FactorList()), util::Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -30,12 +30,14 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <limits>
 #include <map>
 #include <set>
+#include <boost/unordered_set.hpp>
 #include "Manager.h"
 #include "TypeDef.h"
 #include "Util.h"
 #include "TargetPhrase.h"
 #include "TrellisPath.h"
 #include "TrellisPathCollection.h"
+#include "KBestExtractor.h"
 #include "TranslationOption.h"
 #include "TranslationOptionCollection.h"
 #include "Timer.h"
@@ -80,11 +82,15 @@ Manager::~Manager()
  */
 void Manager::ProcessSentence()
 {
+  // feature states created during search are placed in this sentence's arena
+  SentenceArena::Scope arenaScope(m_arena);
+
   // initialize statistics
   ResetSentenceStats(m_source);
   IFVERBOSE(2) {
     GetSentenceStats().StartTimeTotal();
   }
+  GetSentenceStats().StartCacheStats();
 
   // check if alternate weight setting is used
   // this is not thread safe! it changes StaticData
@@ -97,23 +103,21 @@ void Manager::ProcessSentence()
   }
 
   // get translation options
-  IFVERBOSE(1) {
-    GetSentenceStats().StartTimeCollectOpts();
-  }
+  GetSentenceStats().StartTimeCollectOpts();
   m_transOptColl->CreateTranslationOptions();
 
   // some reporting on how long this took
-  IFVERBOSE(1) {
-    GetSentenceStats().StopTimeCollectOpts();
-    TRACE_ERR("Line "<< m_lineNumber << ": Collecting options took " << GetSentenceStats().GetTimeCollectOpts() << " seconds" << endl);
-  }
+  GetSentenceStats().StopTimeCollectOpts();
+  VERBOSE(1, "Line "<< m_lineNumber << ": Collecting options took " << GetSentenceStats().GetTimeCollectOpts() << " seconds" << endl);
 
   // search for best translation with the specified algorithm
-  Timer searchTime;
-  searchTime.start();
+  GetSentenceStats().StartTimeSearch();
   m_search->ProcessSentence();
-  VERBOSE(1, "Line " << m_lineNumber << ": Search took " << searchTime << " seconds" << endl);
-    IFVERBOSE(2) {
+  GetSentenceStats().StopTimeSearch();
+  VERBOSE(1, "Line " << m_lineNumber << ": Search took " << GetSentenceStats().GetTimeSearch() << " seconds" << endl);
+  GetSentenceStats().StopCacheStats();
+  GetSentenceStats().SetPeakArenaBytes(m_arena.GetPeakBytesInUse());
+  IFVERBOSE(2) {
     GetSentenceStats().StopTimeTotal();
     TRACE_ERR(GetSentenceStats());
   }
@@ -227,6 +231,11 @@ void Manager::CalcNBest(size_t count, TrellisPathList &ret,bool onlyDistinct) co
   if (sortedPureHypo.size() == 0)
     return;
 
+  if (StaticData::Instance().UseLazyNBest()) {
+    CalcLazyNBest(sortedPureHypo, count, ret, onlyDistinct);
+    return;
+  }
+
   TrellisPathCollection contenders;
 
   set<Phrase> distinctHyps;
@@ -273,6 +282,36 @@ void Manager::CalcNBest(size_t count, TrellisPathList &ret,bool onlyDistinct) co
   }
 }
 
+/**
+ * Alternative to the trellis enumeration above: the k-best derivations are
+ * extracted lazily from the recombined search graph (see KBestExtractor),
+ * so only the paths that are returned are ever built.
+ * With onlyDistinct, translations are deduplicated on their hashed surface
+ * string and at most count * n-best-factor derivations are looked at.
+ */
+void Manager::CalcLazyNBest(const vector<const Hypothesis*> &finalHypos, size_t count, TrellisPathList &ret, bool onlyDistinct) const
+{
+  KBestExtractor extractor(finalHypos);
+
+  size_t nBestFactor = StaticData::Instance().GetNBestFactor();
+  if (nBestFactor < 1) nBestFactor = 1000; // 0 = unlimited
+  const size_t maxDerivations = onlyDistinct ? count * nBestFactor : count;
+
+  boost::unordered_set<Phrase> distinctHyps;
+  vector<const Hypothesis*> edges;
+  for (size_t i = 0 ; ret.GetSize() < count && i < maxDerivations ; ++i) {
+    const KBestExtractor::Derivation *derivation = extractor.Get(i);
+    if (derivation == NULL) {
+      break;
+    }
+    if (onlyDistinct && !distinctHyps.insert(KBestExtractor::GetOutputPhrase(*derivation)).second) {
+      continue;
+    }
+    KBestExtractor::GetEdges(*derivation, edges);
+    ret.Add(new TrellisPath(edges));
+  }
+}
+
 struct SGNReverseCompare {
   bool operator() (const SearchGraphNode& s1, const SearchGraphNode& s2) const {
     return s1.hypo->GetId() > s2.hypo->GetId();
@@ -469,7 +508,8 @@ void OutputWordGraph(std::ostream &outputWordGraphStream, const Hypothesis *hypo
 {
 
   const Hypothesis *prevHypo = hypo->GetPrevHypo();
-
+  ScoreComponentCollection scoreBreakdown;
+  hypo->AddScoreBreakdown(scoreBreakdown);
 
   outputWordGraphStream << "J=" << linkId++
                         << "\tS=" << prevHypo->GetId()
@@ -481,7 +521,7 @@ void OutputWordGraph(std::ostream &outputWordGraphStream, const Hypothesis *hypo
   std::vector<PhraseDictionary*>::const_iterator iterPhraseTable;
   for (iterPhraseTable = phraseTables.begin() ; iterPhraseTable != phraseTables.end() ; ++iterPhraseTable) {
     const PhraseDictionary *phraseTable = *iterPhraseTable;
-    vector<float> scores = hypo->GetScoreBreakdown().GetScoresForProducer(phraseTable);
+    vector<float> scores = scoreBreakdown.GetScoresForProducer(phraseTable);
 
     outputWordGraphStream << scores[0];
     vector<float>::const_iterator iterScore;
@@ -498,7 +538,7 @@ void OutputWordGraph(std::ostream &outputWordGraphStream, const Hypothesis *hypo
     const StatefulFeatureFunction *ff = statefulFFs[i];
     const LanguageModel *lm = dynamic_cast<const LanguageModel*>(ff);
 
-    vector<float> scores = hypo->GetScoreBreakdown().GetScoresForProducer(lm);
+    vector<float> scores = scoreBreakdown.GetScoresForProducer(lm);
 
     outputWordGraphStream << scores[0];
     vector<float>::const_iterator iterScore;
@@ -517,7 +557,7 @@ void OutputWordGraph(std::ostream &outputWordGraphStream, const Hypothesis *hypo
 
     const DistortionScoreProducer *model = dynamic_cast<const DistortionScoreProducer*>(ff);
     if (model) {
-      outputWordGraphStream << hypo->GetScoreBreakdown().GetScoreForProducer(model);
+      outputWordGraphStream << scoreBreakdown.GetScoreForProducer(model);
     }
   }
 
@@ -825,7 +865,8 @@ size_t Manager::OutputFeatureValuesForSLF(size_t index, bool zeros, const Hypoth
 
   // FVector featureValues = scoreCollection.GetVectorForProducer(ff);
   // outputSearchGraphStream << featureValues << endl;
-  const ScoreComponentCollection& scoreCollection = hypo->GetScoreBreakdown();
+  ScoreComponentCollection scoreCollection;
+  hypo->AddScoreBreakdown(scoreCollection);
 
   vector<float> featureValues = scoreCollection.GetScoresForProducer(ff);
   size_t numScoreComps = featureValues.size();//featureValues.coreSize();
@@ -844,11 +885,7 @@ size_t Manager::OutputFeatureValuesForSLF(size_t index, bool zeros, const Hypoth
 
 size_t Manager::OutputFeatureValuesForHypergraph(size_t index, const Hypothesis* hypo, const FeatureFunction* ff, std::ostream &outputSearchGraphStream) const
 {
-  ScoreComponentCollection scoreCollection = hypo->GetScoreBreakdown();
-  const Hypothesis *prevHypo = hypo->GetPrevHypo();
-  if (prevHypo) {
-    scoreCollection.MinusEquals( prevHypo->GetScoreBreakdown() );
-  }
+  const ScoreComponentCollection &scoreCollection = hypo->GetCurrScoreBreakdown();
   vector<float> featureValues = scoreCollection.GetScoresForProducer(ff);
   size_t numScoreComps = featureValues.size();
 
@@ -1160,8 +1197,7 @@ void OutputSearchNode(long translationId, std::ostream &outputSearchGraphStream,
                           << "-" << searchNode.hypo->GetCurrSourceWordsRange().GetEndPos();
 
   // Modified so that -osgx is a superset of -osg (GST Oct 2011)
-  ScoreComponentCollection scoreBreakdown = searchNode.hypo->GetScoreBreakdown();
-  scoreBreakdown.MinusEquals( prevHypo->GetScoreBreakdown() );
+  const ScoreComponentCollection &scoreBreakdown = searchNode.hypo->GetCurrScoreBreakdown();
   //outputSearchGraphStream << " scores = [ " << StaticData::Instance().GetAllWeights();
   outputSearchGraphStream << " scores=\"" << scoreBreakdown << "\"";
 
@@ -1269,10 +1305,9 @@ void SerializeEdgeInfo(const Hypothesis* hypo, hgmert::Hypergraph_Edge* edge)
   if (!prev) return;
   // score breakdown is an aggregate (forward) quantity, but the exported
   // graph object just wants the feature values on the edges
-  const ScoreComponentCollection& scores = hypo->GetScoreBreakdown();
-  const ScoreComponentCollection& pscores = prev->GetScoreBreakdown();
+  const ScoreComponentCollection& scores = hypo->GetCurrScoreBreakdown();
   for (unsigned int i = 0; i < scores.size(); ++i)
-    edge->add_feature_values((scores[i] - pscores[i]) * -1.0);
+    edge->add_feature_values(scores[i] * -1.0);
 }
 
 hgmert::Hypergraph_Node* GetHGNode(
@@ -1305,7 +1340,7 @@ void Manager::SerializeSearchGraphPB(
   connected[ 0 ] = true;
   Hypergraph hg;
   hg.set_is_sorted(false);
-  int num_feats = (*m_search->GetHypothesisStacks().back()->begin())->GetScoreBreakdown().size();
+  int num_feats = (*m_search->GetHypothesisStacks().back()->begin())->GetCurrScoreBreakdown().size();
   hg.set_num_features(num_feats);
   StaticData::Instance().GetScoreIndexManager().SerializeFeatureNamesToPB(&hg);
   Hypergraph_Node* goal = hg.add_nodes();  // idx=0 goal node must have idx 0
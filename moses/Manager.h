@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "WordsBitmap.h"
 #include "Search.h"
 #include "SearchCubePruning.h"
+#include "SentenceArena.h"
 
 namespace Moses
 {
@@ -112,6 +113,7 @@ private:
 protected:
   // data
 //	InputType const& m_source; /**< source sentence to be translated */
+  SentenceArena m_arena; /**< owns hypotheses and feature states of this sentence, must outlive m_search */
   TranslationOptionCollection *m_transOptColl; /**< pre-computed list of translation options for the phrases in this sentence */
   Search *m_search;
 
@@ -128,6 +130,7 @@ protected:
     std::map< int, bool >* pConnected,
     std::vector< const Hypothesis* >* pConnectedList) const;
 
+  void CalcLazyNBest(const std::vector<const Hypothesis*> &finalHypos, size_t count, TrellisPathList &ret, bool onlyDistinct) const;
 
 public:
   InputType const& m_source; /**< source sentence to be translated */
@@ -146,6 +149,10 @@ public:
   void GetOutputLanguageModelOrder( std::ostream &out, const Hypothesis *hypo );
   void GetWordGraph(long translationId, std::ostream &outputWordGraphStream) const;
   int GetNextHypoId();
+
+  SentenceArena &GetArena() {
+    return m_arena;
+  }
 #ifdef HAVE_PROTOBUF
   void SerializeSearchGraphPB(long translationId, std::ostream& outputStream) const;
 #endif
@@ -0,0 +1,57 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "MockTempFile.h"
+
+#include <fstream>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+namespace MosesTest
+{
+
+MockTempFileGuard::MockTempFileGuard(const string &name, const string &contents,
+                                     const string &derivedSuffix)
+  : m_derivedSuffix(derivedSuffix)
+{
+  const string pattern = "/tmp/" + name + "_XXXXXX";
+  vector<char> buffer(pattern.begin(), pattern.end());
+  buffer.push_back('\0');
+  int fd = mkstemp(&buffer[0]);
+  BOOST_REQUIRE(fd != -1);
+  close(fd);
+  m_path = &buffer[0];
+  ofstream(m_path.c_str()) << contents;
+}
+
+MockTempFileGuard::~MockTempFileGuard()
+{
+  unlink(m_path.c_str());
+  if (!m_derivedSuffix.empty()) {
+    unlink((m_path + m_derivedSuffix).c_str());
+  }
+}
+
+}
@@ -0,0 +1,53 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2014- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef _MOCK_TEMP_FILE_
+#define _MOCK_TEMP_FILE_
+
+#include <string>
+
+namespace MosesTest
+{
+
+/** A file under /tmp with the given contents, removed along with the one
+ *  whose name is its path plus derivedSuffix (e.g. a binarised table).
+ */
+class MockTempFileGuard
+{
+public:
+  MockTempFileGuard(const std::string &name, const std::string &contents,
+                    const std::string &derivedSuffix = "");
+
+  ~MockTempFileGuard();
+
+  const std::string &GetPath() const {
+    return m_path;
+  }
+
+private:
+  std::string m_path;
+  std::string m_derivedSuffix;
+
+  MockTempFileGuard(const MockTempFileGuard &);
+  MockTempFileGuard &operator=(const MockTempFileGuard &);
+};
+
+}
+
+#endif
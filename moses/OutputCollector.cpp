@@ -0,0 +1,193 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2011 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "OutputCollector.h"
+
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#endif
+
+namespace Moses
+{
+
+namespace
+{
+// ring size when the window is unbounded
+const size_t DefaultRingSize = 64;
+}
+
+OutputCollector::OutputCollector(std::ostream* outStream, std::ostream* debugStream)
+  : m_ring(DefaultRingSize)
+  , m_window(0)
+  , m_nextOutput(0)
+  , m_outStream(outStream)
+  , m_debugStream(debugStream)
+  , m_isHoldingOutputStream(false)
+  , m_isHoldingDebugStream(false)
+#ifdef WITH_THREADS
+  , m_stopping(false)
+#endif
+{
+}
+
+OutputCollector::~OutputCollector()
+{
+#ifdef WITH_THREADS
+  StopWriterThread();
+#endif
+  if (m_isHoldingOutputStream)
+    delete m_outStream;
+  if (m_isHoldingDebugStream)
+    delete m_debugStream;
+}
+
+void OutputCollector::SetReorderWindow(size_t size)
+{
+  m_window = size;
+  m_ring.assign(size ? size : DefaultRingSize, Slot());
+}
+
+void OutputCollector::Write(int sourceId,const std::string& output,const std::string& debug)
+{
+  // copy before locking, so that holding the lock only costs a swap. The
+  // empty strings swapped out of the slot are freed after unlocking
+  std::string outputCopy(output), debugCopy(debug);
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  Slot &slot = InRing(sourceId) ? m_ring[sourceId % m_ring.size()] : m_overflow[sourceId];
+  slot.output.swap(outputCopy);
+  slot.debug.swap(debugCopy);
+  slot.ready = true;
+
+#ifdef WITH_THREADS
+  if (m_writer) {
+    m_outputReady.notify_one();
+    return;
+  }
+#endif
+  WriteReady();
+}
+
+/** Take the next result in input order, if it has arrived. */
+bool OutputCollector::PopNext(std::string &output, std::string &debug)
+{
+  Slot &slot = m_ring[m_nextOutput % m_ring.size()];
+  if (slot.ready) {
+    output.swap(slot.output);
+    debug.swap(slot.debug);
+    slot.output.clear();
+    slot.debug.clear();
+    slot.ready = false;
+  } else {
+    std::map<int, Slot>::iterator iter = m_overflow.find(m_nextOutput);
+    if (iter == m_overflow.end()) {
+      return false;
+    }
+    output.swap(iter->second.output);
+    debug.swap(iter->second.debug);
+    m_overflow.erase(iter);
+  }
+
+  ++m_nextOutput;
+#ifdef WITH_THREADS
+  m_windowAvailable.notify_all();
+#endif
+  return true;
+}
+
+/** Write everything that is ready, in the calling thread. */
+void OutputCollector::WriteReady()
+{
+  std::string output, debug;
+  bool written = false;
+  while (PopNext(output, debug)) {
+    *m_outStream << output;
+    *m_debugStream << debug;
+    written = true;
+  }
+  if (written) {
+    *m_outStream << std::flush;
+    *m_debugStream << std::flush;
+  }
+}
+
+#ifdef WITH_THREADS
+
+void OutputCollector::WaitForWindow(int sourceId)
+{
+  if (m_window == 0) return;
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (sourceId >= m_nextOutput
+         && static_cast<size_t>(sourceId - m_nextOutput) >= m_window) {
+    m_windowAvailable.wait(lock);
+  }
+}
+
+void OutputCollector::StartWriterThread()
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (m_writer) return;
+  m_stopping = false;
+  m_writer.reset(new boost::thread(boost::bind(&OutputCollector::WriterLoop, this)));
+}
+
+void OutputCollector::StopWriterThread()
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (!m_writer) return;
+    m_stopping = true;
+    m_outputReady.notify_one();
+  }
+  m_writer->join();
+  m_writer.reset();
+}
+
+void OutputCollector::WriterLoop()
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  std::string output, debug;
+  bool written = false;
+  for (;;) {
+    if (PopNext(output, debug)) {
+      // the stream is only touched by this thread, so release the lock
+      lock.unlock();
+      *m_outStream << output;
+      *m_debugStream << debug;
+      written = true;
+      lock.lock();
+    } else if (written) {
+      // out of work: flush once for the whole batch, then check again
+      lock.unlock();
+      *m_outStream << std::flush;
+      *m_debugStream << std::flush;
+      written = false;
+      lock.lock();
+    } else if (m_stopping) {
+      break;
+    } else {
+      m_outputReady.wait(lock);
+    }
+  }
+}
+
+#endif
+
+}  // namespace Moses
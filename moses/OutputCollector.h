@@ -22,7 +22,10 @@
 #define moses_OutputCollector_h
 
 #ifdef WITH_THREADS
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #endif
 
 #ifdef BOOST_HAS_PTHREADS
@@ -33,25 +36,26 @@
 #include <map>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace Moses
 {
 /**
-* Makes sure output goes in the correct order when multi-threading
+* Makes sure output goes in the correct order when multi-threading.
+*
+* Results that arrive out of order wait in a ring buffer (the reorder window)
+* until all earlier results have been written. By default the thread that
+* completes the sequence writes it out. After StartWriterThread(), a
+* dedicated thread does all writing and flushes only when it runs out of
+* work, so decoding threads merely hand over their strings and never wait
+* for the stream.
 **/
 class OutputCollector
 {
 public:
-  OutputCollector(std::ostream* outStream= &std::cout, std::ostream* debugStream=&std::cerr) :
-    m_nextOutput(0),m_outStream(outStream),m_debugStream(debugStream),
-    m_isHoldingOutputStream(false), m_isHoldingDebugStream(false) {}
-
-  ~OutputCollector() {
-    if (m_isHoldingOutputStream)
-      delete m_outStream;
-    if (m_isHoldingDebugStream)
-      delete m_debugStream;
-  }
+  OutputCollector(std::ostream* outStream= &std::cout, std::ostream* debugStream=&std::cerr);
+
+  ~OutputCollector();
 
   void HoldOutputStream() {
     m_isHoldingOutputStream = true;
@@ -65,39 +69,59 @@ public:
     return (m_outStream == &std::cout);
   }
 
+  //! id of the first result, if the input is not numbered from 0
+  void SetFirstSourceId(int sourceId) {
+    m_nextOutput = sourceId;
+  }
+
+  /** Bound the number of results that may be buffered out of order, which
+   * is enforced by WaitForWindow(). 0 (the default) means no limit: results
+   * that do not fit into the ring buffer then go to an overflow map, which
+   * grows without bound while an early sentence is slow, as nothing holds
+   * back the reading of input. Must be called before the first Write().
+   */
+  void SetReorderWindow(size_t size);
+
   /**
     * Write or cache the output, as appropriate.
     **/
-  void Write(int sourceId,const std::string& output,const std::string& debug="") {
+  void Write(int sourceId,const std::string& output,const std::string& debug="");
+
 #ifdef WITH_THREADS
-    boost::mutex::scoped_lock lock(m_mutex);
+  /** Block until the result for sourceId fits into the reorder window.
+   * Call before submitting the task that produces it.
+   */
+  void WaitForWindow(int sourceId);
+
+  void StartWriterThread();
+
+  //! write all pending output in order, then stop the writer thread
+  void StopWriterThread();
 #endif
-    if (sourceId == m_nextOutput) {
-      //This is the one we were expecting
-      *m_outStream << output << std::flush;
-      *m_debugStream << debug << std::flush;
-      ++m_nextOutput;
-      //see if there's any more
-      std::map<int,std::string>::iterator iter;
-      while ((iter = m_outputs.find(m_nextOutput)) != m_outputs.end()) {
-        *m_outStream << iter->second << std::flush;
-        ++m_nextOutput;
-        std::map<int,std::string>::iterator debugIter = m_debugs.find(iter->first);
-        m_outputs.erase(iter);
-        if (debugIter != m_debugs.end()) {
-          *m_debugStream << debugIter->second << std::flush;
-          m_debugs.erase(debugIter);
-        }
-      }
-    } else {
-      //save for later
-      m_outputs[sourceId] = output;
-      m_debugs[sourceId] = debug;
-    }
-  }
+
 private:
-  std::map<int,std::string> m_outputs;
-  std::map<int,std::string> m_debugs;
+  struct Slot {
+    Slot() : ready(false) {}
+    bool ready;
+    std::string output;
+    std::string debug;
+  };
+
+  bool InRing(int sourceId) const {
+    return sourceId >= m_nextOutput
+           && static_cast<size_t>(sourceId - m_nextOutput) < m_ring.size();
+  }
+
+  bool PopNext(std::string &output, std::string &debug);
+  void WriteReady();
+
+#ifdef WITH_THREADS
+  void WriterLoop();
+#endif
+
+  std::vector<Slot> m_ring; /**< slot sourceId % size holds sourceId */
+  std::map<int, Slot> m_overflow; /**< results further ahead than the ring */
+  size_t m_window;
   int m_nextOutput;
   std::ostream* m_outStream;
   std::ostream* m_debugStream;
@@ -105,6 +129,10 @@ private:
   bool m_isHoldingDebugStream;
 #ifdef WITH_THREADS
   boost::mutex m_mutex;
+  boost::condition_variable m_outputReady;
+  boost::condition_variable m_windowAvailable;
+  boost::scoped_ptr<boost::thread> m_writer;
+  bool m_stopping;
 #endif
 };
 
@@ -58,6 +58,7 @@ Parameter::Parameter()
   AddParam("n-best-list", "file and size of n-best-list to be generated; specify - as the file in order to write to STDOUT");
   AddParam("lattice-samples", "generate samples from lattice, in same format as nbest list. Uses the file and size arguments, as in n-best-list");
   AddParam("n-best-factor", "factor to compute the maximum number of contenders (=factor*nbest-size). value 0 means infinity, i.e. no threshold. default is 0");
+  AddParam("lazy-n-best", "extract the phrase-based n-best list lazily from the recombined search graph (Huang and Chiang, 2005) instead of enumerating trellis paths. Default = false");
   AddParam("print-all-derivations", "to print all derivations in search graph");
   AddParam("output-factors", "list of factors in the output");
   AddParam("phrase-drop-allowed", "da", "if present, allow dropping of source words"); //da = drop any (word); see -du for comparison
@@ -119,6 +120,7 @@ Parameter::Parameter()
   AddParam("output-hypo-score", "Output the hypo score to stdout with the output string. For search error analysis. Default is false");
   AddParam("unknown-lhs", "file containing target lhs of unknown words. 1 per line: LHS prob");
   AddParam("cube-pruning-lazy-scoring", "cbls", "Don't fully score a hypothesis until it is popped");
+  AddParam("cube-growing", "cbg", "Chart decoding: like cube-pruning-lazy-scoring, but a popped hypothesis whose full score falls behind goes back into the queue, at most this many times per pop. (default = 0, 1 is a good choice)");
   AddParam("search-algorithm", "Which search algorithm to use. 0=normal stack, 1=cube pruning, 2=cube growing, 4=stack with batched lm requests (default = 0)");
   AddParam("link-param-count", "Number of parameters on word links when using confusion networks or lattices (default = 1)");
   AddParam("description", "Source language, target language, description");
@@ -130,7 +132,13 @@ Parameter::Parameter()
   AddParam("output-hypo-score", "Output the hypo score to stdout with the output string. For search error analysis. Default is false");
   AddParam("show-weights", "print feature weights and exit");
   AddParam("start-translation-id", "Id of 1st input. Default = 0");
+  AddParam("schedule-lookahead", "when multi-threading, read this many sentences ahead and translate the longest of them first. Default = 0 (input order)");
+  AddParam("chart-cell-threads", "number of threads that decode the chart cells of one span width concurrently, shared by all decoding threads. Default = 1 (cells one after the other)");
+  AddParam("load-threads", "number of threads that load feature functions and phrase tables concurrently at start-up, a feature waits for the ones it depends on. Default = 1 (one after the other)");
+  AddParam("transopt-threads", "number of threads that collect the translation options of one sentence, shared by all decoding threads. Default = 1 (no extra threads)");
+  AddParam("output-reorder-window", "when multi-threading, max number of translations that may wait for an earlier, unfinished one. Reading input pauses at the limit. Default = 0 (no limit, and no bound on the memory used by waiting translations)");
   AddParam("output-unknowns", "Output the unknown (OOV) words to the given file, one line per sentence");
+  AddParam("sentence-metrics-file", "Output timings, hypothesis counts, LM lookups and phrase-table cache hits of every sentence to the given file, one JSON object per line");
 
   // Compact phrase table and reordering table.
   AddParam("minlexr-memory", "Load lexical reordering table in minlexr format into memory");
@@ -0,0 +1,109 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <string>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "FactorCollection.h"
+#include "TranslationModel/PhraseDictionaryNodeMemory.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+Word MakeWord(const string &str, bool isNonTerminal = false)
+{
+  Word word(isNonTerminal);
+  word.SetFactor(0, FactorCollection::Instance().AddFactor(str, isNonTerminal));
+  return word;
+}
+
+string Terminal(size_t i)
+{
+  return "node_test_" + boost::lexical_cast<string>(i);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(phrase_dictionary_node_memory)
+
+BOOST_AUTO_TEST_CASE(freeze_keeps_children)
+{
+  PhraseDictionaryNodeMemory root;
+  for (size_t i = 0; i < 100; ++i) {
+    PhraseDictionaryNodeMemory *child = root.GetOrCreateChild(MakeWord(Terminal(i)));
+    child->GetOrCreateChild(MakeWord(Terminal(i + 1)));
+  }
+  BOOST_CHECK(!root.IsLeaf());
+  BOOST_CHECK(root.GetTerminalMap().empty());
+
+  root.Freeze();
+  BOOST_CHECK_EQUAL(root.GetTerminalMap().size(), 100);
+  for (size_t i = 0; i < 100; ++i) {
+    const PhraseDictionaryNodeMemory *child = root.GetChild(MakeWord(Terminal(i)));
+    BOOST_REQUIRE(child != NULL);
+    BOOST_CHECK_EQUAL(child->GetTerminalMap().size(), 1);
+    BOOST_CHECK(child->GetChild(MakeWord(Terminal(i + 1))) != NULL);
+    BOOST_CHECK(child->GetChild(MakeWord(Terminal(i + 2))) == NULL);
+  }
+  BOOST_CHECK(root.GetChild(MakeWord(Terminal(100))) == NULL);
+}
+
+BOOST_AUTO_TEST_CASE(freeze_merges_new_children)
+{
+  PhraseDictionaryNodeMemory root;
+  PhraseDictionaryNodeMemory *first = root.GetOrCreateChild(MakeWord(Terminal(0)));
+  first->GetOrCreateChild(MakeWord(Terminal(1)));
+  root.Freeze();
+
+  // existing children are found again, new ones are merged on the next freeze
+  BOOST_CHECK_EQUAL(root.GetOrCreateChild(MakeWord(Terminal(0))), root.GetChild(MakeWord(Terminal(0))));
+  root.GetOrCreateChild(MakeWord(Terminal(2)));
+  BOOST_CHECK(root.GetChild(MakeWord(Terminal(2))) != NULL);
+  root.Freeze();
+
+  BOOST_CHECK_EQUAL(root.GetTerminalMap().size(), 2);
+  const PhraseDictionaryNodeMemory *child = root.GetChild(MakeWord(Terminal(0)));
+  BOOST_REQUIRE(child != NULL);
+  BOOST_CHECK(child->GetChild(MakeWord(Terminal(1))) != NULL);
+}
+
+#if !defined(UNLABELLED_SOURCE)
+BOOST_AUTO_TEST_CASE(non_terminal_children)
+{
+  PhraseDictionaryNodeMemory root;
+  root.GetOrCreateChild(MakeWord("X", true), MakeWord("NP", true));
+  root.GetOrCreateChild(MakeWord("X", true), MakeWord("VP", true));
+  root.GetOrCreateChild(MakeWord("X", true), MakeWord("NP", true));
+  root.Freeze();
+
+  BOOST_CHECK_EQUAL(root.GetNonTerminalMap().size(), 2);
+  BOOST_CHECK(root.GetChild(MakeWord("X", true), MakeWord("VP", true)) != NULL);
+  BOOST_CHECK(root.GetChild(MakeWord("X", true), MakeWord("PP", true)) == NULL);
+
+  root.Remove();
+  BOOST_CHECK(root.IsLeaf());
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
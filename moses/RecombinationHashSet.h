@@ -0,0 +1,252 @@
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_RecombinationHashSet_h
+#define moses_RecombinationHashSet_h
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace Moses
+{
+
+/** Unique set of hypothesis pointers, where two hypotheses are the same if
+ * they can be recombined.
+ *
+ * The items are kept in insertion order, and iteration follows that order,
+ * so that expanding, pruning and printing a stack does not depend on hash
+ * values (some of which are pointers). They are found through open
+ * addressing with linear probing over a flat array of indices. Every slot
+ * keeps the recombination hash of its item (T::GetRecombinationHash()), so
+ * the full, expensive Equal test is only run when two hashes are identical.
+ *
+ * Erasing leaves a hole in the item order and a tombstone in the index, so
+ * erase() never invalidates iterators to other elements and it is safe to
+ * erase while iterating. insert() may compact the items and invalidates
+ * all iterators.
+ */
+template <class T, class Equal>
+class RecombinationHashSet
+{
+  struct Slot {
+    std::size_t index;
+    std::size_t hash;
+  };
+
+  static std::size_t Empty() {
+    return static_cast<std::size_t>(-1);
+  }
+  static std::size_t Tombstone() {
+    return static_cast<std::size_t>(-2);
+  }
+
+public:
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T* value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* const* pointer;
+    typedef T* const& reference;
+
+    const_iterator() : m_item(NULL), m_end(NULL) {}
+
+    reference operator*() const {
+      return *m_item;
+    }
+    pointer operator->() const {
+      return m_item;
+    }
+    const_iterator &operator++() {
+      ++m_item;
+      SkipErased();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator ret(*this);
+      ++*this;
+      return ret;
+    }
+    bool operator==(const const_iterator &other) const {
+      return m_item == other.m_item;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return m_item != other.m_item;
+    }
+
+  private:
+    friend class RecombinationHashSet;
+
+    const_iterator(T* const *item, T* const *end) : m_item(item), m_end(end) {
+      SkipErased();
+    }
+    void SkipErased() {
+      while (m_item != m_end && *m_item == NULL) {
+        ++m_item;
+      }
+    }
+
+    T* const *m_item, * const *m_end;
+  };
+  typedef const_iterator iterator;
+
+  RecombinationHashSet() : m_size(0) {}
+
+  const_iterator begin() const {
+    return const_iterator(Begin(), End());
+  }
+  const_iterator end() const {
+    return const_iterator(End(), End());
+  }
+  std::size_t size() const {
+    return m_size;
+  }
+  bool empty() const {
+    return m_size == 0;
+  }
+
+  /** add item, unless an equal item is already present.
+   * Returns the position of the item in the set and whether it was added
+   */
+  std::pair<iterator, bool> insert(T *item) {
+    // grow early, so that probe sequences stay short. Erased items still
+    // count, so holes and tombstones are cleared out before they pile up
+    if ((m_items.size() + 1) * 2 > m_slots.size()) {
+      Rehash();
+    }
+
+    const std::size_t hash = item->GetRecombinationHash();
+    const std::size_t mask = m_slots.size() - 1;
+    Slot *reuse = NULL;
+    for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+      Slot &slot = m_slots[i];
+      if (slot.index == Empty()) {
+        if (reuse == NULL) reuse = &slot;
+        break;
+      } else if (slot.index == Tombstone()) {
+        if (reuse == NULL) reuse = &slot;
+      } else if (slot.hash == hash && m_equal(m_items[slot.index], item)) {
+        return std::make_pair(At(slot.index), false);
+      }
+    }
+
+    reuse->index = m_items.size();
+    reuse->hash = hash;
+    m_items.push_back(item);
+    ++m_size;
+    return std::make_pair(At(reuse->index), true);
+  }
+
+  //! position of the item equal to the given one, or end()
+  iterator find(const T *item) const {
+    if (m_size == 0) return end();
+
+    const Slot *slot = FindSlot(item);
+    return slot ? At(slot->index) : end();
+  }
+
+  void erase(const iterator &iter) {
+    const std::size_t index = iter.m_item - Begin();
+    const std::size_t mask = m_slots.size() - 1;
+    std::size_t i = m_items[index]->GetRecombinationHash() & mask;
+    while (m_slots[i].index != index) {
+      i = (i + 1) & mask;
+    }
+    m_slots[i].index = Tombstone();
+    m_items[index] = NULL;
+    --m_size;
+  }
+
+  void clear() {
+    m_items.clear();
+    m_slots.clear();
+    m_size = 0;
+  }
+
+private:
+  std::vector<T*> m_items; /**< in insertion order, NULL where erased */
+  std::vector<Slot> m_slots; /**< size is always 0 or a power of 2 */
+  std::size_t m_size;
+  Equal m_equal;
+
+  T* const *Begin() const {
+    return m_items.empty() ? NULL : &m_items[0];
+  }
+  T* const *End() const {
+    return m_items.empty() ? NULL : &m_items[0] + m_items.size();
+  }
+  iterator At(std::size_t index) const {
+    return iterator(&m_items[index], End());
+  }
+
+  //! the slot of the item equal to the given one, or NULL
+  const Slot *FindSlot(const T *item) const {
+    const std::size_t hash = item->GetRecombinationHash();
+    const std::size_t mask = m_slots.size() - 1;
+    for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+      const Slot &slot = m_slots[i];
+      if (slot.index == Empty()) {
+        return NULL;
+      } else if (slot.index != Tombstone()
+                 && slot.hash == hash && m_equal(m_items[slot.index], item)) {
+        return &slot;
+      }
+    }
+  }
+
+  //! drop the erased items, and rebuild the index at most half full
+  void Rehash() {
+    std::size_t capacity = 16;
+    while (capacity < (m_size + 1) * 4) {
+      capacity *= 2;
+    }
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < m_items.size(); ++i) {
+      if (m_items[i] != NULL) {
+        m_items[kept++] = m_items[i];
+      }
+    }
+    m_items.resize(kept);
+
+    Slot empty;
+    empty.index = Empty();
+    empty.hash = 0;
+    m_slots.assign(capacity, empty);
+
+    const std::size_t mask = capacity - 1;
+    for (std::size_t index = 0; index < m_items.size(); ++index) {
+      const std::size_t hash = m_items[index]->GetRecombinationHash();
+      std::size_t i = hash & mask;
+      while (m_slots[i].index != Empty()) {
+        i = (i + 1) & mask;
+      }
+      m_slots[i].index = index;
+      m_slots[i].hash = hash;
+    }
+  }
+};
+
+}
+
+#endif
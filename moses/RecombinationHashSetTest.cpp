@@ -0,0 +1,113 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+#include "RecombinationHashSet.h"
+
+using namespace Moses;
+
+namespace
+{
+// hash deliberately collides, so that the equality test is exercised
+struct Item {
+  int key;
+  explicit Item(int k) : key(k) {}
+  size_t GetRecombinationHash() const {
+    return key % 3;
+  }
+};
+
+struct ItemEqual {
+  bool operator()(const Item *a, const Item *b) const {
+    return a->key == b->key;
+  }
+};
+
+typedef RecombinationHashSet<Item, ItemEqual> ItemSet;
+}
+
+BOOST_AUTO_TEST_SUITE(recombination_hash_set)
+
+BOOST_AUTO_TEST_CASE(insert_find_erase)
+{
+  std::vector<Item> items;
+  for (int i = 0; i < 100; ++i) {
+    items.push_back(Item(i));
+  }
+
+  ItemSet set;
+  for (size_t i = 0; i < items.size(); ++i) {
+    BOOST_CHECK(set.insert(&items[i]).second);
+  }
+  BOOST_CHECK_EQUAL(set.size(), 100u);
+
+  Item duplicate(42);
+  std::pair<ItemSet::iterator, bool> ret = set.insert(&duplicate);
+  BOOST_CHECK(!ret.second);
+  BOOST_CHECK(*ret.first == &items[42]);
+
+  // erase every other item while iterating
+  size_t visited = 0;
+  for (ItemSet::iterator iter = set.begin(); iter != set.end(); ) {
+    ItemSet::iterator current = iter++;
+    if ((*current)->key % 2) {
+      set.erase(current);
+    }
+    ++visited;
+  }
+  BOOST_CHECK_EQUAL(visited, 100u);
+  BOOST_CHECK_EQUAL(set.size(), 50u);
+
+  BOOST_CHECK(set.find(&items[41]) == set.end());
+  BOOST_CHECK(*set.find(&items[40]) == &items[40]);
+
+  // erased slots are reused
+  BOOST_CHECK(set.insert(&items[41]).second);
+  BOOST_CHECK_EQUAL(set.size(), 51u);
+}
+
+BOOST_AUTO_TEST_CASE(iterates_in_insertion_order)
+{
+  std::vector<Item> items;
+  for (int i = 0; i < 40; ++i) {
+    items.push_back(Item(39 - i));
+  }
+
+  ItemSet set;
+  for (size_t i = 0; i < items.size(); ++i) {
+    set.insert(&items[i]);
+  }
+  set.erase(set.find(&items[0]));
+  set.insert(&items[0]);
+
+  // holes are skipped, and a re-inserted item goes to the back
+  std::vector<int> keys;
+  for (ItemSet::iterator iter = set.begin(); iter != set.end(); ++iter) {
+    keys.push_back((*iter)->key);
+  }
+  BOOST_REQUIRE_EQUAL(keys.size(), 40u);
+  for (size_t i = 0; i < 39; ++i) {
+    BOOST_CHECK_EQUAL(keys[i], items[i + 1].key);
+  }
+  BOOST_CHECK_EQUAL(keys.back(), items[0].key);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -28,6 +28,9 @@ private:
 public:
 
   int Compare(const ReorderingStack& o) const;
+  size_t hash() const {
+    return boost::hash_range(m_stack.begin(), m_stack.end());
+  }
   int ShiftReduce(WordsRange input_span);
 
 private:
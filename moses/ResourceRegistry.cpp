@@ -0,0 +1,54 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include "ResourceRegistry.h"
+
+namespace Moses
+{
+
+ResourceRegistry ResourceRegistry::s_instance;
+
+boost::shared_ptr<ResourceRegistry::Entry> ResourceRegistry::GetEntry(const std::string &key)
+{
+#ifdef WITH_THREADS
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+#endif
+  boost::shared_ptr<Entry> &entry = m_entries[key];
+  if (!entry) {
+    entry.reset(new Entry());
+  }
+  return entry;
+}
+
+size_t ResourceRegistry::GetNumLoaded() const
+{
+#ifdef WITH_THREADS
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+#endif
+  size_t ret = 0;
+  std::map<std::string, boost::shared_ptr<Entry> >::const_iterator iter;
+  for (iter = m_entries.begin(); iter != m_entries.end(); ++iter) {
+    if (!iter->second->resource.expired()) {
+      ++ret;
+    }
+  }
+  return ret;
+}
+
+}
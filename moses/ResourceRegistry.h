@@ -0,0 +1,93 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_ResourceRegistry_h
+#define moses_ResourceRegistry_h
+
+#include <map>
+#include <string>
+#include <typeinfo>
+
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#endif
+
+namespace Moses
+{
+
+/** Process-wide registry of loaded models. Feature functions that load the
+ *  same file with the same options get handles to one shared copy, which is
+ *  freed when the last handle goes. Keys are the file path plus whatever
+ *  load options change the loaded data; the resource type is added to the
+ *  key, so different kinds of models never collide.
+ */
+class ResourceRegistry
+{
+public:
+  static ResourceRegistry& Instance() {
+    return s_instance;
+  }
+
+  /** Return the resource registered under key, or call load() to create it.
+   *  Concurrent calls for the same key load once; the others wait for it.
+   */
+  template <class T>
+  boost::shared_ptr<T> Acquire(const std::string &key, const boost::function<T*()> &load) {
+    boost::shared_ptr<Entry> entry = GetEntry(key + " " + typeid(T).name());
+#ifdef WITH_THREADS
+    boost::lock_guard<boost::mutex> lock(entry->mutex);
+#endif
+    boost::shared_ptr<void> resource = entry->resource.lock();
+    if (resource) {
+      return boost::static_pointer_cast<T>(resource);
+    }
+    boost::shared_ptr<T> loaded(load());
+    entry->resource = loaded;
+    return loaded;
+  }
+
+  //! number of resources that are still held by someone
+  size_t GetNumLoaded() const;
+
+private:
+  struct Entry {
+#ifdef WITH_THREADS
+    boost::mutex mutex;
+#endif
+    boost::weak_ptr<void> resource;
+  };
+
+  static ResourceRegistry s_instance;
+
+  boost::shared_ptr<Entry> GetEntry(const std::string &key);
+
+  std::map<std::string, boost::shared_ptr<Entry> > m_entries;
+#ifdef WITH_THREADS
+  mutable boost::mutex m_mutex;
+#endif
+};
+
+}
+
+#endif
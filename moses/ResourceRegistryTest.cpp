@@ -0,0 +1,75 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <string>
+
+#include <boost/bind.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "ResourceRegistry.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+size_t loads = 0;
+
+string *LoadString(const string &value)
+{
+  ++loads;
+  return new string(value);
+}
+
+int *LoadInt(int value)
+{
+  ++loads;
+  return new int(value);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(resource_registry)
+
+BOOST_AUTO_TEST_CASE(shares_until_released)
+{
+  ResourceRegistry &registry = ResourceRegistry::Instance();
+  loads = 0;
+  boost::shared_ptr<string> first = registry.Acquire<string>("test a", boost::bind(&LoadString, "a"));
+  boost::shared_ptr<string> second = registry.Acquire<string>("test a", boost::bind(&LoadString, "other"));
+  BOOST_CHECK_EQUAL(first.get(), second.get());
+  BOOST_CHECK_EQUAL(*second, "a");
+  BOOST_CHECK_EQUAL(loads, 1);
+
+  // other keys and other types are separate resources
+  boost::shared_ptr<string> other = registry.Acquire<string>("test b", boost::bind(&LoadString, "b"));
+  boost::shared_ptr<int> number = registry.Acquire<int>("test a", boost::bind(&LoadInt, 3));
+  BOOST_CHECK_EQUAL(*other, "b");
+  BOOST_CHECK_EQUAL(*number, 3);
+  BOOST_CHECK_EQUAL(loads, 3);
+
+  // the last handle frees the resource, the next acquire loads it again
+  first.reset();
+  second.reset();
+  BOOST_CHECK_EQUAL(*registry.Acquire<string>("test a", boost::bind(&LoadString, "again")), "again");
+  BOOST_CHECK_EQUAL(loads, 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
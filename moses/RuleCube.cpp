@@ -61,7 +61,11 @@ RuleCubeItem *RuleCube::Pop(ChartManager &manager)
 {
   RuleCubeItem *item = m_queue.top();
   m_queue.pop();
-  CreateNeighbors(*item, manager);
+  // a lazily scored item that already has its hypothesis was pushed back
+  // after full scoring, its neighbours exist since its first pop
+  if (!StaticData::Instance().GetCubePruningLazyScoring() || !item->HasHypothesis()) {
+    CreateNeighbors(*item, manager);
+  }
   return item;
 }
 
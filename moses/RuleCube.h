@@ -99,6 +99,11 @@ public:
 
   RuleCubeItem *Pop(ChartManager &);
 
+  //! put a popped item back, after it was fully scored (cube growing)
+  void Push(RuleCubeItem *item) {
+    m_queue.push(item);
+  }
+
   bool IsEmpty() const {
     return m_queue.empty();
   }
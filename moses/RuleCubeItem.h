@@ -133,6 +133,10 @@ public:
 
   void CreateHypothesis(const ChartTranslationOptions &, ChartManager &);
 
+  bool HasHypothesis() const {
+    return m_hypothesis != NULL;
+  }
+
   ChartHypothesis *ReleaseHypothesis();
 
   bool operator<(const RuleCubeItem &) const;
@@ -43,6 +43,8 @@ void RuleCubeQueue::Add(RuleCube *ruleCube)
 
 ChartHypothesis *RuleCubeQueue::Pop()
 {
+  const StaticData &staticData = StaticData::Instance();
+
   // pop the most promising rule cube
   RuleCube *cube = m_queue.top();
   m_queue.pop();
@@ -50,8 +52,24 @@ ChartHypothesis *RuleCubeQueue::Pop()
   // pop the most promising item from the cube and get the corresponding
   // hypothesis
   RuleCubeItem *item = cube->Pop(m_manager);
-  if (StaticData::Instance().GetCubePruningLazyScoring()) {
-    item->CreateHypothesis(cube->GetTranslationOption(), m_manager);
+  if (staticData.GetCubePruningLazyScoring()) {
+    // cube growing: the full score may be worse than the estimates of other
+    // items. Queue the item again with its full score and pop the best one
+    // instead, up to the given number of times. Only popped items are ever
+    // fully scored.
+    size_t requeues = staticData.GetCubeGrowing();
+    while (!item->HasHypothesis()) {
+      item->CreateHypothesis(cube->GetTranslationOption(), m_manager);
+      if (requeues == 0) {
+        break;
+      }
+      --requeues;
+      cube->Push(item);
+      m_queue.push(cube);
+      cube = m_queue.top();
+      m_queue.pop();
+      item = cube->Pop(m_manager);
+    }
   }
   ChartHypothesis *hypo = item->ReleaseHypothesis();
 
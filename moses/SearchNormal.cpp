@@ -261,6 +261,14 @@ void SearchNormal::ExpandAllHypotheses(const Hypothesis &hypothesis, size_t star
   // loop through all translation options
   const TranslationOptionList &transOptList = m_transOptColl.GetTranslationOptionList(WordsRange(startPos, endPos));
   TranslationOptionList::const_iterator iter;
+  if (transOptList.size() > 1) {
+    std::vector<std::pair<const Hypothesis*, const TranslationOption*> > expansions;
+    expansions.reserve(transOptList.size());
+    for (iter = transOptList.begin() ; iter != transOptList.end() ; ++iter) {
+      expansions.push_back(std::make_pair(&hypothesis, *iter));
+    }
+    Hypothesis::PrefetchExpansions(expansions);
+  }
   for (iter = transOptList.begin() ; iter != transOptList.end() ; ++iter) {
     ExpandHypothesis(hypothesis, **iter, expectedScore);
   }
@@ -0,0 +1,94 @@
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+#include <boost/thread/tss.hpp>
+
+#include "SentenceArena.h"
+#include "util/scoped.hh"
+
+namespace Moses
+{
+
+namespace
+{
+// the arena is owned by its Manager, never by the thread
+void NoCleanup(SentenceArena *) {}
+
+boost::thread_specific_ptr<SentenceArena> s_current(&NoCleanup);
+}
+
+const std::size_t SentenceArena::Alignment;
+const std::size_t SentenceArena::MaxRecycledSize;
+const std::size_t SentenceArena::MinChunkSize;
+const std::size_t SentenceArena::MaxChunkSize;
+
+SentenceArena::SentenceArena()
+  : m_freeLists(MaxRecycledSize / Alignment + 1, NULL)
+  , m_current(NULL)
+  , m_currentEnd(NULL)
+  , m_reserved(0)
+  , m_inUse(0)
+  , m_peakInUse(0)
+{
+}
+
+SentenceArena::~SentenceArena()
+{
+  for (size_t i = 0; i < m_chunks.size(); ++i) {
+    std::free(m_chunks[i]);
+  }
+}
+
+void *SentenceArena::More(std::size_t size)
+{
+  // chunks double in size up to a limit, so short sentences stay cheap
+  std::size_t amount = std::min(MinChunkSize << m_chunks.size(), MaxChunkSize);
+  amount = std::max(amount, size);
+
+  // malloc returns memory aligned for any fundamental type, which is
+  // at least as strict as Alignment on the platforms we build on
+  uint8_t *ret = static_cast<uint8_t*>(util::MallocOrThrow(amount));
+  m_chunks.push_back(ret);
+  m_reserved += amount;
+
+  m_current = ret + size;
+  m_currentEnd = ret + amount;
+  return ret;
+}
+
+SentenceArena *SentenceArena::GetCurrent()
+{
+  return s_current.get();
+}
+
+SentenceArena::Scope::Scope(SentenceArena &arena)
+  : m_previous(s_current.get())
+{
+  s_current.reset(&arena);
+}
+
+SentenceArena::Scope::~Scope()
+{
+  s_current.reset(m_previous);
+}
+
+}
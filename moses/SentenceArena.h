@@ -0,0 +1,140 @@
+// vim:tabstop=2
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2006 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#ifndef moses_SentenceArena_h
+#define moses_SentenceArena_h
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace Moses
+{
+
+/** Bump allocator owning the search objects of one sentence.
+ *
+ * Each Manager has its own arena, so it is only ever touched by the thread
+ * decoding that sentence and needs no locking. Memory is handed out from
+ * large chunks; blocks given back with Free() are kept on per-size free lists
+ * and reused, so pruned hypotheses and their states do not grow the arena.
+ * All chunks are released together when the arena is destroyed.
+ *
+ * While a Scope is alive the arena is also the 'current' arena of the
+ * calling thread. FFState allocates itself from the current arena, so
+ * feature functions get arena allocation without any change to their code.
+ */
+class SentenceArena
+{
+public:
+  //! alignment of every block returned by Allocate()
+  static const std::size_t Alignment = 16;
+
+  SentenceArena();
+  ~SentenceArena();
+
+  void *Allocate(std::size_t size) {
+    size = RoundUp(size);
+    m_inUse += size;
+    if (m_inUse > m_peakInUse) {
+      m_peakInUse = m_inUse;
+    }
+
+    if (size <= MaxRecycledSize) {
+      void *&head = m_freeLists[size / Alignment];
+      if (head) {
+        void *ret = head;
+        head = *static_cast<void**>(ret);
+        return ret;
+      }
+    }
+
+    if (m_current + size > m_currentEnd) {
+      return More(size);
+    }
+    void *ret = m_current;
+    m_current += size;
+    return ret;
+  }
+
+  //! give a block back for reuse. size must be the size passed to Allocate()
+  void Free(void *ptr, std::size_t size) {
+    size = RoundUp(size);
+    m_inUse -= size;
+    if (size <= MaxRecycledSize) {
+      void *&head = m_freeLists[size / Alignment];
+      *static_cast<void**>(ptr) = head;
+      head = ptr;
+    }
+  }
+
+  //! total size of the chunks obtained from the system
+  std::size_t GetBytesReserved() const {
+    return m_reserved;
+  }
+  //! bytes currently handed out and not yet given back
+  std::size_t GetBytesInUse() const {
+    return m_inUse;
+  }
+  std::size_t GetPeakBytesInUse() const {
+    return m_peakInUse;
+  }
+
+  //! arena of the active Scope in this thread, NULL if there is none
+  static SentenceArena *GetCurrent();
+
+  /** Makes an arena the current arena of this thread for the lifetime of the
+   *  scope. Scopes nest, the previous arena is restored on destruction.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(SentenceArena &arena);
+    ~Scope();
+  private:
+    SentenceArena *m_previous;
+
+    Scope(const Scope &);
+    Scope &operator=(const Scope &);
+  };
+
+private:
+  static const std::size_t MaxRecycledSize = 1024;
+  static const std::size_t MinChunkSize = 64 * 1024;
+  static const std::size_t MaxChunkSize = 4 * 1024 * 1024;
+
+  static std::size_t RoundUp(std::size_t size) {
+    return (size + Alignment - 1) & ~(Alignment - 1);
+  }
+
+  void *More(std::size_t size);
+
+  std::vector<void*> m_chunks;
+  std::vector<void*> m_freeLists;
+  uint8_t *m_current, *m_currentEnd;
+  std::size_t m_reserved, m_inUse, m_peakInUse;
+
+  // no copying
+  SentenceArena(const SentenceArena &);
+  SentenceArena &operator=(const SentenceArena &);
+};
+
+}
+
+#endif
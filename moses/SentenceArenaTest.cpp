@@ -0,0 +1,79 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include "SentenceArena.h"
+#include "moses/FF/FFState.h"
+
+using namespace Moses;
+
+BOOST_AUTO_TEST_SUITE(sentence_arena)
+
+BOOST_AUTO_TEST_CASE(alignment_and_reuse)
+{
+  SentenceArena arena;
+  void *a = arena.Allocate(3);
+  void *b = arena.Allocate(40);
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(a) % SentenceArena::Alignment, 0);
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(b) % SentenceArena::Alignment, 0);
+  BOOST_CHECK_EQUAL(arena.GetBytesInUse(), 64);
+
+  arena.Free(b, 40);
+  BOOST_CHECK_EQUAL(arena.GetBytesInUse(), 16);
+  BOOST_CHECK_EQUAL(arena.GetPeakBytesInUse(), 64);
+  // same size class comes back from the free list
+  BOOST_CHECK_EQUAL(arena.Allocate(33), b);
+}
+
+BOOST_AUTO_TEST_CASE(large_blocks)
+{
+  SentenceArena arena;
+  void *big = arena.Allocate(10 * 1024 * 1024);
+  BOOST_CHECK(big != NULL);
+  BOOST_CHECK(arena.GetBytesReserved() >= 10 * 1024 * 1024);
+}
+
+BOOST_AUTO_TEST_CASE(scope_and_states)
+{
+  BOOST_CHECK(SentenceArena::GetCurrent() == NULL);
+  FFState *heapState = new DummyState();
+
+  SentenceArena outer, inner;
+  {
+    SentenceArena::Scope outerScope(outer);
+    BOOST_CHECK(SentenceArena::GetCurrent() == &outer);
+    {
+      SentenceArena::Scope innerScope(inner);
+      BOOST_CHECK(SentenceArena::GetCurrent() == &inner);
+    }
+    BOOST_CHECK(SentenceArena::GetCurrent() == &outer);
+
+    FFState *arenaState = new DummyState();
+    BOOST_CHECK(outer.GetBytesInUse() > 0);
+    delete arenaState;
+    BOOST_CHECK_EQUAL(outer.GetBytesInUse(), 0);
+
+    // heap states can be deleted while an arena is active
+    delete heapState;
+  }
+  BOOST_CHECK(SentenceArena::GetCurrent() == NULL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
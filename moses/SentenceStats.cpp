@@ -24,6 +24,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "SentenceStats.h"
 #include "InputPath.h"
 #include "TranslationOption.h"
+#include "TranslationModel/PhraseDictionary.h"
 
 using std::cout;
 using std::endl;
@@ -40,6 +41,37 @@ void SentenceStats::CalcFinalStats(const Hypothesis& bestHypo)
   //inserted words--not implemented yet 8/1 TODO
 }
 
+void SentenceStats::StartCacheStats()
+{
+  PhraseDictionary::GetThreadCacheStats(m_numCacheHits, m_numCacheMisses);
+}
+
+void SentenceStats::StopCacheStats()
+{
+  size_t hits, misses;
+  PhraseDictionary::GetThreadCacheStats(hits, misses);
+  m_numCacheHits = hits - m_numCacheHits;
+  m_numCacheMisses = misses - m_numCacheMisses;
+}
+
+void SentenceStats::OutputMetrics(std::ostream &out, long translationId) const
+{
+  out << "{\"id\":" << translationId
+      << ",\"source_words\":" << GetTotalSourceWords()
+      << ",\"time_collect_opts\":" << GetTimeCollectOpts()
+      << ",\"time_search\":" << GetTimeSearch()
+      << ",\"time_nbest\":" << GetTimeNBest()
+      << ",\"hypos_created\":" << GetTotalHypos()
+      << ",\"hypos_recombined\":" << GetNumHyposRecombined()
+      << ",\"hypos_pruned\":" << GetNumHyposPruned()
+      << ",\"hypos_discarded\":" << GetNumHyposDiscarded()
+      << ",\"peak_arena_bytes\":" << GetPeakArenaBytes()
+      << ",\"lm_lookups\":" << GetNumLMLookups()
+      << ",\"cache_hits\":" << GetNumCacheHits()
+      << ",\"cache_misses\":" << GetNumCacheMisses()
+      << "}" << endl;
+}
+
 void SentenceStats::AddDeletedWords(const Hypothesis& hypo)
 {
   //don't check either a null pointer or the empty initial hypothesis (if we were given the empty hypo, the null check will save us)
@@ -66,6 +66,11 @@ public:
     m_numHyposDiscarded = 0;
     m_numHyposEarlyDiscarded = 0;
     m_numHyposNotBuilt = 0;
+    m_numHyposRecombined = 0;
+    m_numLMLookups = 0;
+    m_peakArenaBytes = 0;
+    m_numCacheHits = 0;
+    m_numCacheMisses = 0;
     m_totalSourceWords = source.GetSize();
     m_recombinationInfos.clear();
     m_deletedWords.clear();
@@ -84,7 +89,7 @@ public:
     return m_numHyposPopped;
   }
   size_t GetNumHyposRecombined() const {
-    return m_recombinationInfos.size();
+    return m_numHyposRecombined;
   }
   unsigned int GetNumHyposPruned() const {
     return m_numHyposPruned;
@@ -125,6 +130,24 @@ public:
   double GetTimeTotal() const {
     return m_timeTotal.get_elapsed_time();
   }
+  double GetTimeSearch() const {
+    return m_timeSearch.get_elapsed_time();
+  }
+  double GetTimeNBest() const {
+    return m_timeNBest.get_elapsed_time();
+  }
+  size_t GetNumLMLookups() const {
+    return m_numLMLookups;
+  }
+  size_t GetPeakArenaBytes() const {
+    return m_peakArenaBytes;
+  }
+  size_t GetNumCacheHits() const {
+    return m_numCacheHits;
+  }
+  size_t GetNumCacheMisses() const {
+    return m_numCacheMisses;
+  }
   size_t GetTotalSourceWords() const {
     return m_totalSourceWords;
   }
@@ -144,6 +167,11 @@ public:
   void AddRecombination(const Hypothesis& worseHypo, const Hypothesis& betterHypo) {
     m_recombinationInfos.push_back(RecombinationInfo(worseHypo.GetWordsBitmap().GetNumWordsCovered(),
                                    betterHypo.GetTotalScore(), worseHypo.GetTotalScore()));
+    m_numHyposRecombined++;
+  }
+  //! recombination of hypotheses without phrase-based details (chart decoding)
+  void AddRecombination() {
+    m_numHyposRecombined++;
   }
   void AddCreated() {
     m_numHyposCreated++;
@@ -163,6 +191,23 @@ public:
   void AddDiscarded() {
     m_numHyposDiscarded++;
   }
+  void AddLMLookups(size_t count) {
+    m_numLMLookups += count;
+  }
+  //! add the hypothesis and LM lookup counts of other, e.g. collected on another thread
+  void AddCounts(const SentenceStats &other) {
+    m_numHyposCreated += other.m_numHyposCreated;
+    m_numHyposPopped += other.m_numHyposPopped;
+    m_numHyposPruned += other.m_numHyposPruned;
+    m_numHyposDiscarded += other.m_numHyposDiscarded;
+    m_numHyposEarlyDiscarded += other.m_numHyposEarlyDiscarded;
+    m_numHyposNotBuilt += other.m_numHyposNotBuilt;
+    m_numHyposRecombined += other.m_numHyposRecombined;
+    m_numLMLookups += other.m_numLMLookups;
+  }
+  void SetPeakArenaBytes(size_t bytes) {
+    m_peakArenaBytes = bytes;
+  }
 
   void StartTimeCollectOpts() {
     m_timeCollectOpts.start();
@@ -218,6 +263,31 @@ public:
   void StopTimeTotal() {
     m_timeTotal.stop();
   }
+  void StartTimeSearch() {
+    m_timeSearch.start();
+  }
+  void StopTimeSearch() {
+    m_timeSearch.stop();
+  }
+  void StartTimeNBest() {
+    m_timeNBest.start();
+  }
+  void StopTimeNBest() {
+    m_timeNBest.stop();
+  }
+
+  /***
+   * count translation option cache lookups made by this thread between
+   * the two calls
+   */
+  void StartCacheStats();
+  void StopCacheStats();
+
+  /***
+   * one line JSON record with the numbers that are always collected,
+   * for the file given by -sentence-metrics-file
+   */
+  void OutputMetrics(std::ostream &out, long translationId) const;
 
 protected:
 
@@ -237,6 +307,11 @@ protected:
   unsigned int m_numHyposDiscarded;
   unsigned int m_numHyposEarlyDiscarded;
   unsigned int m_numHyposNotBuilt;
+  size_t m_numHyposRecombined;
+  size_t m_numLMLookups;
+  size_t m_peakArenaBytes;
+  size_t m_numCacheHits;
+  size_t m_numCacheMisses;
   Timer m_timeCollectOpts;
   Timer m_timeBuildHyp;
   Timer m_timeEstimateScore;
@@ -246,6 +321,8 @@ protected:
   Timer m_timeSetupCubes;
   Timer m_timeManageCubes;
   Timer m_timeTotal;
+  Timer m_timeSearch;
+  Timer m_timeNBest;
 
   //words
   size_t m_totalSourceWords;
@@ -20,7 +20,10 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <unistd.h>
 
 #include "TypeDef.h"
 #include "moses/FF/WordPenaltyProducer.h"
@@ -44,13 +47,125 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "TranslationModel/PhraseDictionaryTreeAdaptor.h"
 
 #ifdef WITH_THREADS
+#include <boost/bind.hpp>
 #include <boost/thread.hpp>
+#include "ThreadPool.h"
 #endif
 
+#include "util/exception.hh"
+
 using namespace std;
 
 namespace Moses
 {
+namespace
+{
+
+//! resident memory of the process in MB, 0 where it is not known
+size_t GetResidentMB()
+{
+  ifstream statm("/proc/self/statm");
+  size_t size, resident;
+  if (statm >> size >> resident) {
+    return resident * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+  }
+  return 0;
+}
+
+void LoadFeatureFunction(FeatureFunction &ff)
+{
+  VERBOSE(1, "Loading " << ff.GetScoreProducerDescription() << endl);
+  Timer timer;
+  timer.start();
+  ff.Load();
+
+  // one write, so that reports of features loaded concurrently do not mix
+  ostringstream report;
+  report << "Loaded " << ff.GetScoreProducerDescription() << " in " << timer.get_elapsed_time()
+         << " seconds, resident memory " << GetResidentMB() << " MB" << endl;
+  VERBOSE(1, report.str());
+}
+
+#ifdef WITH_THREADS
+/** Loads feature functions on a thread pool. A feature is submitted as soon
+ *  as the features it depends on, as far as they are in the list, are loaded.
+ */
+class FeatureLoader
+{
+public:
+  FeatureLoader(const vector<FeatureFunction*> &features, size_t threads)
+    : m_features(features)
+    , m_waitingFor(features.size(), 0)
+    , m_dependents(features.size())
+    , m_pool(threads)
+    , m_group(m_pool)
+    , m_loaded(0) {
+    map<const FeatureFunction*, size_t> index;
+    for (size_t i = 0; i < features.size(); ++i) {
+      index[features[i]] = i;
+    }
+    for (size_t i = 0; i < features.size(); ++i) {
+      const vector<const FeatureFunction*> dependencies = features[i]->GetLoadDependencies();
+      for (size_t d = 0; d < dependencies.size(); ++d) {
+        map<const FeatureFunction*, size_t>::const_iterator found = index.find(dependencies[d]);
+        if (found != index.end() && found->second != i) {
+          ++m_waitingFor[i];
+          m_dependents[found->second].push_back(i);
+        }
+      }
+    }
+  }
+
+  //! throws if a feature failed to load
+  void Run() {
+    vector<size_t> ready;
+    for (size_t i = 0; i < m_features.size(); ++i) {
+      if (!m_waitingFor[i]) {
+        ready.push_back(i);
+      }
+    }
+    Submit(ready);
+    m_group.Wait();
+    UTIL_THROW_IF2(m_loaded != m_features.size(),
+                   "Feature functions wait for each other to load, "
+                   << m_features.size() - m_loaded << " of them were not loaded");
+  }
+
+private:
+  void Submit(const vector<size_t> &ready) {
+    for (size_t i = 0; i < ready.size(); ++i) {
+      m_group.Submit(boost::bind(&FeatureLoader::Load, this, ready[i]));
+    }
+  }
+
+  void Load(size_t feature) {
+    LoadFeatureFunction(*m_features[feature]);
+    vector<size_t> ready;
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      ++m_loaded;
+      const vector<size_t> &dependents = m_dependents[feature];
+      for (size_t i = 0; i < dependents.size(); ++i) {
+        if (--m_waitingFor[dependents[i]] == 0) {
+          ready.push_back(dependents[i]);
+        }
+      }
+    }
+    Submit(ready);
+  }
+
+  const vector<FeatureFunction*> &m_features;
+  vector<size_t> m_waitingFor; //!< number of dependencies of each feature that are not loaded yet
+  vector<vector<size_t> > m_dependents;
+  ThreadPool m_pool;
+  TaskGroup m_group; //!< waits for the jobs before the pool goes
+  boost::mutex m_mutex;
+  size_t m_loaded;
+};
+#endif
+
+}
+
 bool g_mosesDebug = false;
 
 StaticData StaticData::s_instance;
@@ -61,6 +176,7 @@ StaticData::StaticData()
   ,m_detailedTranslationReportingFilePath()
   ,m_detailedTreeFragmentsTranslationReportingFilePath()
   ,m_onlyDistinctNBest(false)
+  ,m_lazyNBest(false)
   ,m_needAlignmentInfo(false)
   ,m_factorDelimiter("|") // default delimiter between factors
   ,m_lmEnableOOVFeature(false)
@@ -176,6 +292,7 @@ bool StaticData::LoadData(Parameter *parameter)
   } else {
     m_nBestSize = 0;
   }
+  SetBooleanParameter( &m_lazyNBest, "lazy-n-best", false );
   if (m_parameter->GetParam("n-best-factor").size() > 0) {
     m_nBestFactor = Scan<size_t>( m_parameter->GetParam("n-best-factor")[0]);
   } else {
@@ -251,6 +368,15 @@ bool StaticData::LoadData(Parameter *parameter)
     }
   }
 
+  if (m_parameter->isParamSpecified("sentence-metrics-file")) {
+    if (m_parameter->GetParam("sentence-metrics-file").size() == 1) {
+      m_sentenceMetricsFile = m_parameter->GetParam("sentence-metrics-file")[0];
+    } else {
+      UserMessage::Add(string("need to specify exactly one file name for sentence metrics"));
+      return false;
+    }
+  }
+
   // include feature names in the n-best list
   SetBooleanParameter( &m_labeledNBestList, "labeled-n-best-list", true );
 
@@ -376,6 +502,11 @@ bool StaticData::LoadData(Parameter *parameter)
                            ? Scan<size_t>(m_parameter->GetParam("cube-pruning-diversity")[0]) : DEFAULT_CUBE_PRUNING_DIVERSITY;
 
   SetBooleanParameter(&m_cubePruningLazyScoring, "cube-pruning-lazy-scoring", false);
+  m_cubeGrowing = (m_parameter->GetParam("cube-growing").size() > 0)
+                  ? Scan<size_t>(m_parameter->GetParam("cube-growing")[0]) : 0;
+  if (m_cubeGrowing) {
+    m_cubePruningLazyScoring = true;
+  }
 
   // early distortion cost
   SetBooleanParameter( &m_useEarlyDistortionCost, "early-distortion-cost", false );
@@ -470,6 +601,41 @@ bool StaticData::LoadData(Parameter *parameter)
 
   m_startTranslationId = (m_parameter->GetParam("start-translation-id").size() > 0) ?
                          Scan<long>(m_parameter->GetParam("start-translation-id")[0]) : 0;
+  m_outputReorderWindow = (m_parameter->GetParam("output-reorder-window").size() > 0) ?
+                          Scan<size_t>(m_parameter->GetParam("output-reorder-window")[0]) : 0;
+  m_scheduleLookahead = (m_parameter->GetParam("schedule-lookahead").size() > 0) ?
+                        Scan<size_t>(m_parameter->GetParam("schedule-lookahead")[0]) : 0;
+  if (m_outputReorderWindow > 0 && m_scheduleLookahead > m_outputReorderWindow) {
+    // a batch that does not fit into the window would never be submitted
+    m_scheduleLookahead = m_outputReorderWindow;
+  }
+
+  m_transOptThreads = (m_parameter->GetParam("transopt-threads").size() > 0) ?
+                      Scan<size_t>(m_parameter->GetParam("transopt-threads")[0]) : 1;
+#ifndef WITH_THREADS
+  if (m_transOptThreads > 1) {
+    UserMessage::Add("Error: transopt-threads > 1 but moses not built with thread support");
+    return false;
+  }
+#endif
+
+  m_chartCellThreads = (m_parameter->GetParam("chart-cell-threads").size() > 0) ?
+                       Scan<size_t>(m_parameter->GetParam("chart-cell-threads")[0]) : 1;
+#ifndef WITH_THREADS
+  if (m_chartCellThreads > 1) {
+    UserMessage::Add("Error: chart-cell-threads > 1 but moses not built with thread support");
+    return false;
+  }
+#endif
+
+  m_loadThreads = (m_parameter->GetParam("load-threads").size() > 0) ?
+                  Scan<size_t>(m_parameter->GetParam("load-threads")[0]) : 1;
+#ifndef WITH_THREADS
+  if (m_loadThreads > 1) {
+    UserMessage::Add("Error: load-threads > 1 but moses not built with thread support");
+    return false;
+  }
+#endif
 
   // use of xml in input
   if (m_parameter->GetParam("xml-input").size() == 0) m_xmlInputType = XmlPassThrough;
@@ -911,6 +1077,8 @@ void StaticData::CleanUpAfterSentenceProcessing(const InputType& source) const
 
 void StaticData::LoadFeatureFunctions()
 {
+  // phrase tables last, they may score their phrases with the other features
+  std::vector<FeatureFunction*> features;
   const std::vector<FeatureFunction*> &ffs
   = FeatureFunction::GetFeatureFunctions();
   std::vector<FeatureFunction*>::const_iterator iter;
@@ -923,17 +1091,27 @@ void StaticData::LoadFeatureFunctions()
     }
 
     if (doLoad) {
-      VERBOSE(1, "Loading " << ff->GetScoreProducerDescription() << endl);
-      ff->Load();
+      features.push_back(ff);
     }
   }
 
   const std::vector<PhraseDictionary*> &pts = PhraseDictionary::GetColl();
-  for (size_t i = 0; i < pts.size(); ++i) {
-    PhraseDictionary *pt = pts[i];
-    VERBOSE(1, "Loading " << pt->GetScoreProducerDescription() << endl);
-    pt->Load();
+  features.insert(features.end(), pts.begin(), pts.end());
+
+  Timer timer;
+  timer.start();
+#ifdef WITH_THREADS
+  if (m_loadThreads > 1) {
+    FeatureLoader(features, m_loadThreads).Run();
+  } else
+#endif
+  {
+    for (size_t i = 0; i < features.size(); ++i) {
+      LoadFeatureFunction(*features[i]);
+    }
   }
+  VERBOSE(1, "Loaded " << features.size() << " feature functions in " << timer.get_elapsed_time()
+          << " seconds with " << m_loadThreads << " thread(s)" << endl);
 
   CheckLEGACYPT();
 }
@@ -125,6 +125,7 @@ protected:
   std::string m_detailedAllTranslationReportingFilePath;
 
   bool m_onlyDistinctNBest;
+  bool m_lazyNBest;
   bool m_PrintAlignmentInfo;
   bool m_needAlignmentInfo;
   bool m_PrintAlignmentInfoNbest;
@@ -169,10 +170,12 @@ protected:
   bool m_unprunedSearchGraph; //! do not exclude dead ends (chart decoder only)
   bool m_includeLHSInSearchGraph; //! include LHS of rules in search graph
   std::string m_outputUnknownsFile; //! output unknowns in this file
+  std::string m_sentenceMetricsFile; //! output per-sentence metrics in this file
 
   size_t m_cubePruningPopLimit;
   size_t m_cubePruningDiversity;
   bool m_cubePruningLazyScoring;
+  size_t m_cubeGrowing;
   size_t m_ruleLimit;
 
   // Whether to load compact phrase table and reordering table into memory
@@ -188,6 +191,11 @@ protected:
 
   int m_threadCount;
   long m_startTranslationId;
+  size_t m_outputReorderWindow;
+  size_t m_scheduleLookahead;
+  size_t m_transOptThreads;
+  size_t m_chartCellThreads;
+  size_t m_loadThreads;
 
   // alternate weight settings
   mutable std::string m_currentWeightSetting;
@@ -309,6 +317,10 @@ public:
   bool GetCubePruningLazyScoring() const {
     return m_cubePruningLazyScoring;
   }
+  //! how often a pop may queue a fully scored rule cube item again, 0 = never
+  size_t GetCubeGrowing() const {
+    return m_cubeGrowing;
+  }
   size_t IsPathRecoveryEnabled() const {
     return m_recoverPath;
   }
@@ -456,6 +468,9 @@ public:
   bool GetDistinctNBest() const {
     return m_onlyDistinctNBest;
   }
+  bool UseLazyNBest() const {
+    return m_lazyNBest;
+  }
   const std::string& GetFactorDelimiter() const {
     return m_factorDelimiter;
   }
@@ -547,6 +562,9 @@ public:
   const std::string& GetOutputUnknownsFile() const {
     return m_outputUnknownsFile;
   }
+  const std::string& GetSentenceMetricsFile() const {
+    return m_sentenceMetricsFile;
+  }
 
   bool GetUnprunedSearchGraph() const {
     return m_unprunedSearchGraph;
@@ -612,6 +630,26 @@ public:
     return m_startTranslationId;
   }
 
+  //! max number of translations held back waiting for an earlier one, 0 = no limit
+  size_t GetOutputReorderWindow() const {
+    return m_outputReorderWindow;
+  }
+
+  //! number of sentences to read ahead and submit longest first, 0 = input order
+  size_t GetScheduleLookahead() const {
+    return m_scheduleLookahead;
+  }
+  size_t GetTransOptThreads() const {
+    return m_transOptThreads;
+  }
+  size_t GetChartCellThreads() const {
+    return m_chartCellThreads;
+  }
+  //! number of threads that load the feature functions at start-up
+  size_t GetLoadThreads() const {
+    return m_loadThreads;
+  }
+
   void SetExecPath(const std::string &path);
   const std::string &GetBinDirectory() const;
 
@@ -95,6 +95,10 @@ public:
   void Detach() {
     m_collection.clear();
   }
+  //! exchange phrases with another collection without copying them
+  void Swap(TargetPhraseCollection &other) {
+    m_collection.swap(other.m_collection);
+  }
 
 };
 
@@ -22,6 +22,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "ThreadPool.h"
 
+#include <algorithm>
+
 #ifdef WITH_THREADS
 
 using namespace std;
@@ -30,53 +32,107 @@ using namespace Moses;
 namespace Moses
 {
 
+namespace
+{
+struct MoreExpensive {
+  bool operator()(const std::pair<size_t, Task*> &a, const std::pair<size_t, Task*> &b) const {
+    return a.first > b.first;
+  }
+};
+}
+
 ThreadPool::ThreadPool( size_t numThreads )
-  : m_stopped(false), m_stopping(false), m_queueLimit(0)
+  : m_queues(new WorkQueue[std::max<size_t>(numThreads, 1)])
+  , m_numQueues(std::max<size_t>(numThreads, 1))
+  , m_nextQueue(0), m_pending(0)
+  , m_stopped(false), m_stopping(false), m_queueLimit(0)
 {
   for (size_t i = 0; i < numThreads; ++i) {
-    m_threads.create_thread(boost::bind(&ThreadPool::Execute,this));
+    m_threads.create_thread(boost::bind(&ThreadPool::Execute,this,i));
   }
 }
 
-void ThreadPool::Execute()
+void ThreadPool::Execute(size_t queue)
 {
-  do {
-    Task* task = NULL;
+  while (Task* task = Take(queue)) {
+    //Execute job
+    task->Run();
+    if (task->DeleteAfterExecution()) {
+      delete task;
+    }
+    m_threadAvailable.notify_all();
+  }
+}
+
+Task *ThreadPool::Take(size_t queue)
+{
+  for (;;) {
     {
-      // Find a job to perform
       boost::mutex::scoped_lock lock(m_mutex);
-      if (m_tasks.empty() && !m_stopped) {
+      while (m_pending == 0 && !m_stopped) {
         m_threadNeeded.wait(lock);
       }
-      if (!m_stopped && !m_tasks.empty()) {
-        task = m_tasks.front();
-        m_tasks.pop();
+      if (m_stopped) return NULL;
+    }
+
+    // own queue from the front, then the other queues from the back
+    Task* task = NULL;
+    for (size_t i = 0; i < m_numQueues && !task; ++i) {
+      WorkQueue &victim = m_queues[(queue + i) % m_numQueues];
+      boost::mutex::scoped_lock lock(victim.mutex);
+      if (victim.tasks.empty()) continue;
+      if (i == 0) {
+        task = victim.tasks.front();
+        victim.tasks.pop_front();
+      } else {
+        task = victim.tasks.back();
+        victim.tasks.pop_back();
       }
     }
-    //Execute job
+
     if (task) {
-      task->Run();
-      if (task->DeleteAfterExecution()) {
-        delete task;
-      }
+      boost::mutex::scoped_lock lock(m_mutex);
+      --m_pending;
+      m_threadAvailable.notify_all();
+      return task;
     }
-    m_threadAvailable.notify_all();
-  } while (!m_stopped);
+    // another thread got there first, or the task is not queued yet
+    boost::this_thread::yield();
+  }
 }
 
 void ThreadPool::Submit( Task* task )
 {
-  boost::mutex::scoped_lock lock(m_mutex);
-  if (m_stopping) {
-    throw runtime_error("ThreadPool stopping - unable to accept new jobs");
+  size_t queue;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (m_stopping) {
+      throw runtime_error("ThreadPool stopping - unable to accept new jobs");
+    }
+    while (m_queueLimit > 0 && m_pending >= m_queueLimit) {
+      m_threadAvailable.wait(lock);
+    }
+    // counted before it is queued, so that m_pending never runs short
+    ++m_pending;
+    queue = m_nextQueue;
+    m_nextQueue = (m_nextQueue + 1) % m_numQueues;
   }
-  while (m_queueLimit > 0 && m_tasks.size() >= m_queueLimit) {
-    m_threadAvailable.wait(lock);
+  {
+    boost::mutex::scoped_lock lock(m_queues[queue].mutex);
+    m_queues[queue].tasks.push_back(task);
   }
-  m_tasks.push(task);
   m_threadNeeded.notify_all();
 }
 
+void ThreadPool::SubmitBatch(std::vector<std::pair<size_t, Task*> > &tasks)
+{
+  std::stable_sort(tasks.begin(), tasks.end(), MoreExpensive());
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    Submit(tasks[i].second);
+  }
+  tasks.clear();
+}
+
 void ThreadPool::Stop(bool processRemainingJobs)
 {
   {
@@ -87,8 +143,8 @@ void ThreadPool::Stop(bool processRemainingJobs)
   }
   if (processRemainingJobs) {
     boost::mutex::scoped_lock lock(m_mutex);
-    //wait for queue to drain.
-    while (!m_tasks.empty() && !m_stopped) {
+    //wait for queues to drain.
+    while (m_pending > 0 && !m_stopped) {
       m_threadAvailable.wait(lock);
     }
   }
@@ -102,6 +158,78 @@ void ThreadPool::Stop(bool processRemainingJobs)
   m_threads.join_all();
 }
 
+class TaskGroup::Job : public Task
+{
+public:
+  Job(TaskGroup &group, const boost::function<void()> &job)
+    : m_group(group), m_job(job) {}
+
+  void Run() {
+    try {
+      m_job();
+    } catch (...) {
+      m_group.Done(boost::current_exception());
+      return;
+    }
+    m_group.Done(boost::exception_ptr());
+  }
+
+private:
+  TaskGroup &m_group;
+  boost::function<void()> m_job;
+};
+
+TaskGroup::TaskGroup(ThreadPool &pool)
+  : m_pool(pool), m_running(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+  WaitForJobs();
+}
+
+void TaskGroup::Submit(const boost::function<void()> &job)
+{
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    ++m_running;
+  }
+  m_pool.Submit(new Job(*this, job));
+}
+
+void TaskGroup::Done(const boost::exception_ptr &error)
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  if (error && !m_error) {
+    m_error = error;
+  }
+  if (--m_running == 0) {
+    m_allDone.notify_all();
+  }
+}
+
+void TaskGroup::WaitForJobs()
+{
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (m_running > 0) {
+    m_allDone.wait(lock);
+  }
+}
+
+void TaskGroup::Wait()
+{
+  WaitForJobs();
+  boost::exception_ptr error;
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    swap(error, m_error);
+  }
+  if (error) {
+    boost::rethrow_exception(error);
+  }
+}
+
 }
 #endif //WITH_THREADS
 
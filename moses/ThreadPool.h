@@ -22,12 +22,16 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_ThreadPool_h
 #define moses_ThreadPool_h
 
+#include <deque>
 #include <iostream>
-#include <queue>
+#include <utility>
 #include <vector>
 
 #ifdef WITH_THREADS
 #include <boost/bind.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_array.hpp>
 #include <boost/thread.hpp>
 #endif
 
@@ -59,6 +63,12 @@ public:
 
 #ifdef WITH_THREADS
 
+/** A work-stealing thread pool.
+ *
+ * Every thread has its own queue of tasks. Submit() deals tasks out round
+ * robin, each thread works through its own queue in order, and a thread
+ * whose queue is empty steals from the back of another thread's queue.
+ */
 class ThreadPool
 {
 public:
@@ -76,6 +86,13 @@ public:
    **/
   void Submit(Task* task);
 
+  /**
+   * Submit a batch of (cost, task) pairs, most expensive first, so that
+   * e.g. the longest sentences of a read-ahead batch start early. Equal
+   * costs keep their order. The batch is cleared.
+   **/
+  void SubmitBatch(std::vector<std::pair<size_t, Task*> > &tasks);
+
   /**
    * Wait until all queued jobs have completed, and shut down
    * the ThreadPool.
@@ -90,12 +107,23 @@ public:
   }
 
 private:
+  struct WorkQueue {
+    boost::mutex mutex;
+    std::deque<Task*> tasks;
+  };
+
   /**
    * The main loop executed by each thread.
    **/
-  void Execute();
+  void Execute(size_t queue);
+
+  //! next task for the thread owning the queue, NULL once the pool stops
+  Task *Take(size_t queue);
 
-  std::queue<Task*> m_tasks;
+  boost::scoped_array<WorkQueue> m_queues;
+  size_t m_numQueues;
+  size_t m_nextQueue; /**< where Submit puts the next task */
+  size_t m_pending; /**< tasks in all queues */
   boost::thread_group m_threads;
   boost::mutex m_mutex;
   boost::condition_variable m_threadNeeded;
@@ -105,6 +133,44 @@ private:
   size_t m_queueLimit;
 };
 
+/** Runs jobs on a ThreadPool and waits for all of them.
+ *
+ * Lets one sentence spread independent pieces of work over the threads of
+ * a pool. The jobs of a group must not wait for anything else on the same
+ * pool, and the pool must not be the one running the caller.
+ */
+class TaskGroup
+{
+public:
+  explicit TaskGroup(ThreadPool &pool);
+
+  //! waits for outstanding jobs, but does not throw
+  ~TaskGroup();
+
+  void Submit(const boost::function<void()> &job);
+
+  /**
+   * Block until every job submitted so far has run. If a job threw, the
+   * first exception is thrown again, with its original type.
+   **/
+  void Wait();
+
+private:
+  class Job;
+
+  void Done(const boost::exception_ptr &error);
+  void WaitForJobs();
+
+  ThreadPool &m_pool;
+  boost::mutex m_mutex;
+  boost::condition_variable m_allDone;
+  size_t m_running;
+  boost::exception_ptr m_error; //!< first exception since the last Wait()
+
+  TaskGroup(const TaskGroup &);
+  TaskGroup &operator=(const TaskGroup &);
+};
+
 class TestTask : public Task
 {
 public:
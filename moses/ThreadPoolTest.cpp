@@ -0,0 +1,127 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include "ThreadPool.h"
+#include "util/exception.hh"
+
+using namespace Moses;
+using namespace std;
+
+#ifdef WITH_THREADS
+
+namespace
+{
+
+class RecordingTask : public Task
+{
+public:
+  RecordingTask(size_t id, vector<size_t> &order, boost::mutex &mutex)
+    : m_id(id), m_order(order), m_mutex(mutex) {}
+
+  virtual void Run() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_order.push_back(m_id);
+  }
+
+private:
+  size_t m_id;
+  vector<size_t> &m_order;
+  boost::mutex &m_mutex;
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(thread_pool)
+
+BOOST_AUTO_TEST_CASE(runs_every_task)
+{
+  vector<size_t> order;
+  boost::mutex mutex;
+  ThreadPool pool(4);
+  pool.SetQueueLimit(8);
+  for (size_t i = 0; i < 1000; ++i) {
+    pool.Submit(new RecordingTask(i, order, mutex));
+  }
+  pool.Stop(true);
+
+  BOOST_REQUIRE_EQUAL(order.size(), 1000);
+  sort(order.begin(), order.end());
+  for (size_t i = 0; i < order.size(); ++i) {
+    BOOST_CHECK_EQUAL(order[i], i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(batch_runs_most_expensive_first)
+{
+  vector<size_t> order;
+  boost::mutex mutex;
+  ThreadPool pool(1);
+
+  vector<pair<size_t, Task*> > batch;
+  batch.push_back(make_pair(3, static_cast<Task*>(new RecordingTask(0, order, mutex))));
+  batch.push_back(make_pair(9, static_cast<Task*>(new RecordingTask(1, order, mutex))));
+  batch.push_back(make_pair(3, static_cast<Task*>(new RecordingTask(2, order, mutex))));
+  batch.push_back(make_pair(5, static_cast<Task*>(new RecordingTask(3, order, mutex))));
+  pool.SubmitBatch(batch);
+  BOOST_CHECK(batch.empty());
+  pool.Stop(true);
+
+  BOOST_REQUIRE_EQUAL(order.size(), 4);
+  BOOST_CHECK_EQUAL(order[0], 1);
+  BOOST_CHECK_EQUAL(order[1], 3);
+  BOOST_CHECK_EQUAL(order[2], 0);
+  BOOST_CHECK_EQUAL(order[3], 2);
+}
+
+void Record(size_t id, vector<size_t> *order, boost::mutex *mutex)
+{
+  boost::mutex::scoped_lock lock(*mutex);
+  order->push_back(id);
+}
+
+void Fail()
+{
+  UTIL_THROW(util::Exception, "job failed");
+}
+
+BOOST_AUTO_TEST_CASE(task_group_waits_for_its_jobs)
+{
+  vector<size_t> order;
+  boost::mutex mutex;
+  ThreadPool pool(3);
+  TaskGroup group(pool);
+  for (size_t i = 0; i < 100; ++i) {
+    group.Submit(boost::bind(Record, i, &order, &mutex));
+  }
+  group.Wait();
+  BOOST_CHECK_EQUAL(order.size(), 100);
+
+  // the group can be reused, and passes on a failure as it was thrown
+  group.Submit(Fail);
+  group.Submit(boost::bind(Record, 100, &order, &mutex));
+  BOOST_CHECK_THROW(group.Wait(), util::Exception);
+  BOOST_CHECK_EQUAL(order.size(), 101);
+  group.Wait();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
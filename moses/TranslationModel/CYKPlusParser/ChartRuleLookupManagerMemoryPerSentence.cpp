@@ -40,6 +40,7 @@ ChartRuleLookupManagerMemoryPerSentence::ChartRuleLookupManagerMemoryPerSentence
   : ChartRuleLookupManagerCYKPlus(parser, cellColl)
   , m_ruleTable(ruleTable)
   , m_softMatchingMap(StaticData::Instance().GetSoftMatches())
+  , m_spanLocal(false)
 {
 
   size_t sourceSize = parser.GetSize();
@@ -57,7 +58,7 @@ void ChartRuleLookupManagerMemoryPerSentence::GetChartRuleCollection(
   size_t startPos = range.GetStartPos();
   size_t absEndPos = range.GetEndPos();
 
-  m_lastPos = lastPos;
+  m_lastPos = m_spanLocal ? absEndPos : lastPos;
   m_stackVec.clear();
   m_outColl = &outColl;
   m_unaryPos = absEndPos-1; // rules ending in this position are unary and should not be added to collection
@@ -75,6 +76,16 @@ void ChartRuleLookupManagerMemoryPerSentence::GetChartRuleCollection(
         outColl.Add(tpc, m_stackVec, range);
     }
   }
+  // span-local: extend every first symbol, but only up to the end of this span.
+  // Prefixes are visited in the same order as below, so are the rules.
+  else if (m_spanLocal) {
+    for (size_t firstEndPos = startPos; firstEndPos < absEndPos; ++firstEndPos) {
+      GetNonTerminalExtension(&rootNode, startPos, firstEndPos);
+      if (firstEndPos == startPos) {
+        GetTerminalExtension(&rootNode, startPos);
+      }
+    }
+  }
   // all rules starting with nonterminal
   else if (absEndPos > startPos) {
     GetNonTerminalExtension(&rootNode, startPos, absEndPos-1);
@@ -107,7 +118,7 @@ void ChartRuleLookupManagerMemoryPerSentence::AddAndExtend(
 
     const TargetPhraseCollection &tpc = node->GetTargetPhraseCollection();
     // add target phrase collection (except if rule is empty or unary)
-    if (!tpc.IsEmpty() && endPos != m_unaryPos) {
+    if (!tpc.IsEmpty() && endPos != m_unaryPos && (!m_spanLocal || endPos == m_lastPos)) {
       m_completedRules[endPos].Add(tpc, m_stackVec, *m_outColl);
     }
 
@@ -148,7 +159,7 @@ void ChartRuleLookupManagerMemoryPerSentence::GetTerminalExtension(
         }
       }
     }
-    // else, do hash lookup
+    // else, bisect the sorted children
     else {
       const PhraseDictionaryNodeMemory *child = node->GetChild(sourceWord);
       if (child != NULL) {
@@ -51,6 +51,11 @@ public:
     size_t lastPos, // last position to consider if using lookahead
     ChartParserCallback &outColl);
 
+  virtual bool SetSpanLocal() {
+    m_spanLocal = true;
+    return true;
+  }
+
 private:
 
 void GetTerminalExtension(
@@ -79,6 +84,9 @@ void GetNonTerminalExtension(
   size_t m_lastPos;
   size_t m_unaryPos;
 
+  // if true, each call finds exactly the rules of its span, see SetSpanLocal()
+  bool m_spanLocal;
+
   StackVec m_stackVec;
   ChartParserCallback* m_outColl;
 
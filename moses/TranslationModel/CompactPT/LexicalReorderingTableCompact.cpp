@@ -19,7 +19,10 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <boost/bind.hpp>
+
 #include "LexicalReorderingTableCompact.h"
+#include "moses/ResourceRegistry.h"
 
 namespace Moses
 {
@@ -30,9 +33,7 @@ LexicalReorderingTableCompact::LexicalReorderingTableCompact(
   const std::vector<FactorType>& e_factors,
   const std::vector<FactorType>& c_factors)
   : LexicalReorderingTable(f_factors, e_factors, c_factors),
-    m_inMemory(StaticData::Instance().UseMinlexrInMemory()),
-    m_numScoreComponent(6), m_multipleScoreTrees(true),
-    m_hash(10, 16), m_scoreTrees(1)
+    m_inMemory(StaticData::Instance().UseMinlexrInMemory())
 {
   Load(filePath);
 }
@@ -43,11 +44,14 @@ LexicalReorderingTableCompact::LexicalReorderingTableCompact(
   const std::vector<FactorType>& c_factors)
   : LexicalReorderingTable(f_factors, e_factors, c_factors),
     m_inMemory(StaticData::Instance().UseMinlexrInMemory()),
-    m_numScoreComponent(6), m_multipleScoreTrees(true),
-    m_hash(10, 16), m_scoreTrees(1)
+    m_table(new SharedTable())
 { }
 
 LexicalReorderingTableCompact::~LexicalReorderingTableCompact()
+{
+}
+
+LexicalReorderingTableCompact::SharedTable::~SharedTable()
 {
   for(size_t i = 0; i < m_scoreTrees.size(); i++)
     delete m_scoreTrees[i];
@@ -68,17 +72,18 @@ std::vector<float> LexicalReorderingTableCompact::GetScore(const Phrase& f,
       key = MakeKey(f,e,sub_c);
     }
 
-  size_t index = m_hash[key];
-  if(m_hash.GetSize() != index) {
+  SharedTable &table = *m_table;
+  size_t index = table.m_hash[key];
+  if(table.m_hash.GetSize() != index) {
     std::string scoresString;
     if(m_inMemory)
-      scoresString = m_scoresMemory[index];
+      scoresString = table.m_scoresMemory[index];
     else
-      scoresString = m_scoresMapped[index];
+      scoresString = table.m_scoresMapped[index];
 
     BitWrapper<> bitStream(scoresString);
-    for(size_t i = 0; i < m_numScoreComponent; i++)
-      scores.push_back(m_scoreTrees[m_multipleScoreTrees ? i : 0]->Read(bitStream));
+    for(size_t i = 0; i < table.m_numScoreComponent; i++)
+      scores.push_back(table.m_scoreTrees[table.m_multipleScoreTrees ? i : 0]->Read(bitStream));
 
     return scores;
   }
@@ -146,29 +151,39 @@ LexicalReorderingTable* LexicalReorderingTableCompact::CheckAndLoad(
 
 void LexicalReorderingTableCompact::Load(std::string filePath)
 {
+  m_table = ResourceRegistry::Instance().Acquire<SharedTable>(
+              (m_inMemory ? "LexicalReorderingTableCompact in-memory " : "LexicalReorderingTableCompact mapped ") + filePath,
+              boost::bind(&LexicalReorderingTableCompact::LoadSharedTable, filePath, m_inMemory));
+}
+
+LexicalReorderingTableCompact::SharedTable *LexicalReorderingTableCompact::LoadSharedTable(const std::string &filePath, bool inMemory)
+{
+  std::auto_ptr<SharedTable> table(new SharedTable());
   std::FILE* pFile = std::fopen(filePath.c_str(), "r");
-  if(m_inMemory)
-    m_hash.Load(pFile);
+  if(inMemory)
+    table->m_hash.Load(pFile);
   else
-    m_hash.LoadIndex(pFile);
+    table->m_hash.LoadIndex(pFile);
 
   size_t read = 0;
-  read += std::fread(&m_numScoreComponent, sizeof(m_numScoreComponent), 1, pFile);
-  read += std::fread(&m_multipleScoreTrees, sizeof(m_multipleScoreTrees), 1, pFile);
+  read += std::fread(&table->m_numScoreComponent, sizeof(table->m_numScoreComponent), 1, pFile);
+  read += std::fread(&table->m_multipleScoreTrees, sizeof(table->m_multipleScoreTrees), 1, pFile);
 
-  if(m_multipleScoreTrees) {
-    m_scoreTrees.resize(m_numScoreComponent);
-    for(size_t i = 0; i < m_numScoreComponent; i++)
-      m_scoreTrees[i] = new CanonicalHuffman<float>(pFile);
+  if(table->m_multipleScoreTrees) {
+    table->m_scoreTrees.resize(table->m_numScoreComponent);
+    for(size_t i = 0; i < table->m_numScoreComponent; i++)
+      table->m_scoreTrees[i] = new CanonicalHuffman<float>(pFile);
   } else {
-    m_scoreTrees.resize(1);
-    m_scoreTrees[0] = new CanonicalHuffman<float>(pFile);
+    table->m_scoreTrees.resize(1);
+    table->m_scoreTrees[0] = new CanonicalHuffman<float>(pFile);
   }
 
-  if(m_inMemory)
-    m_scoresMemory.load(pFile, false);
+  if(inMemory)
+    table->m_scoresMemory.load(pFile, false);
   else
-    m_scoresMapped.load(pFile, true);
+    table->m_scoresMapped.load(pFile, true);
+
+  return table.release();
 }
 
 }
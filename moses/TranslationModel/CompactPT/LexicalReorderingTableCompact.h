@@ -29,6 +29,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/TargetPhrase.h"
 #include "moses/TargetPhraseCollection.h"
 
+#include <boost/shared_ptr.hpp>
+
 #include "BlockHashIndex.h"
 #include "CanonicalHuffman.h"
 #include "StringVector.h"
@@ -41,16 +43,26 @@ class LexicalReorderingTableCompact: public LexicalReorderingTable
 private:
   bool m_inMemory;
 
-  size_t m_numScoreComponent;
-  bool m_multipleScoreTrees;
+  typedef CanonicalHuffman<float> ScoreTree;
 
-  BlockHashIndex m_hash;
+  //! everything read from the file, shared by all tables loaded from it
+  struct SharedTable {
+    SharedTable() : m_numScoreComponent(6), m_multipleScoreTrees(true), m_hash(10, 16) {}
+    ~SharedTable();
 
-  typedef CanonicalHuffman<float> ScoreTree;
-  std::vector<ScoreTree*> m_scoreTrees;
+    size_t m_numScoreComponent;
+    bool m_multipleScoreTrees;
+
+    BlockHashIndex m_hash;
+
+    std::vector<ScoreTree*> m_scoreTrees;
+
+    StringVector<unsigned char, unsigned long, MmapAllocator>  m_scoresMapped;
+    StringVector<unsigned char, unsigned long, std::allocator> m_scoresMemory;
+  };
+  boost::shared_ptr<SharedTable> m_table;
 
-  StringVector<unsigned char, unsigned long, MmapAllocator>  m_scoresMapped;
-  StringVector<unsigned char, unsigned long, std::allocator> m_scoresMemory;
+  static SharedTable *LoadSharedTable(const std::string &filePath, bool inMemory);
 
   std::string MakeKey(const Phrase& f, const Phrase& e, const Phrase& c) const;
   std::string MakeKey(const std::string& f, const std::string& e, const std::string& c) const;
@@ -218,15 +218,15 @@ TargetPhraseVectorPtr PhraseDecoder::CreateTargetPhraseCollection(const Phrase &
 
   // Retrieve source phrase identifier
   std::string sourcePhraseString = sourcePhrase.GetStringRep(*m_input);
-  size_t sourcePhraseId = m_phraseDictionary.m_hash[MakeSourceKey(sourcePhraseString)];
+  size_t sourcePhraseId = m_phraseDictionary.m_table->m_hash[MakeSourceKey(sourcePhraseString)];
 
-  if(sourcePhraseId != m_phraseDictionary.m_hash.GetSize()) {
+  if(sourcePhraseId != m_phraseDictionary.m_table->m_hash.GetSize()) {
     // Retrieve compressed and encoded target phrase collection
     std::string encodedPhraseCollection;
     if(m_phraseDictionary.m_inMemory)
-      encodedPhraseCollection = m_phraseDictionary.m_targetPhrasesMemory[sourcePhraseId];
+      encodedPhraseCollection = m_phraseDictionary.m_table->m_targetPhrasesMemory[sourcePhraseId];
     else
-      encodedPhraseCollection = m_phraseDictionary.m_targetPhrasesMapped[sourcePhraseId];
+      encodedPhraseCollection = m_phraseDictionary.m_table->m_targetPhrasesMapped[sourcePhraseId];
 
     BitWrapper<> encodedBitStream(encodedPhraseCollection);
     if(m_coding == PREnc && bitsLeft)
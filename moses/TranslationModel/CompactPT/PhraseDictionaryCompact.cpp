@@ -26,6 +26,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <algorithm>
 #include <sys/stat.h>
 
+#include <boost/bind.hpp>
+
 #include "PhraseDictionaryCompact.h"
 #include "moses/FactorCollection.h"
 #include "moses/Word.h"
@@ -35,6 +37,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/WordsRange.h"
 #include "moses/UserMessage.h"
 #include "moses/ThreadPool.h"
+#include "moses/ResourceRegistry.h"
 #include "util/exception.hh"
 
 using namespace std;
@@ -46,8 +49,8 @@ PhraseDictionaryCompact::PhraseDictionaryCompact(const std::string &line)
   :PhraseDictionary(line)
   ,m_inMemory(true)
   ,m_useAlignmentInfo(true)
-  ,m_hash(10, 16)
   ,m_phraseDecoder(0)
+  ,m_coderLoaded(false)
   ,m_weight(0)
 {
   ReadParameters();
@@ -78,28 +81,48 @@ void PhraseDictionaryCompact::Load()
   m_phraseDecoder = new PhraseDecoder(*this, &m_input, &m_output,
                                       m_numScoreComponents, &m_weight);
 
-  std::FILE* pFile = std::fopen(tFilePath.c_str() , "r");
+  m_table = ResourceRegistry::Instance().Acquire<SharedTable>(
+              (m_inMemory ? "PhraseDictionaryCompact in-memory " : "PhraseDictionaryCompact mapped ") + tFilePath,
+              boost::bind(&PhraseDictionaryCompact::LoadSharedTable, this, tFilePath));
+
+  if(!m_coderLoaded) {
+    // another table loaded the file, only read the phrase coder
+    std::FILE* pFile = std::fopen(tFilePath.c_str() , "r");
+    std::fseek(pFile, m_table->m_coderOffset, SEEK_SET);
+    size_t coderSize = m_phraseDecoder->Load(pFile);
+    std::fclose(pFile);
+    UTIL_THROW_IF2(coderSize == 0, "Not successfully loaded");
+  }
+}
+
+PhraseDictionaryCompact::SharedTable *PhraseDictionaryCompact::LoadSharedTable(const std::string &filePath)
+{
+  std::auto_ptr<SharedTable> table(new SharedTable());
+  std::FILE* pFile = std::fopen(filePath.c_str() , "r");
 
   size_t indexSize;
   if(m_inMemory)
     // Load source phrase index into memory
-    indexSize = m_hash.Load(pFile);
+    indexSize = table->m_hash.Load(pFile);
   else
     // Keep source phrase index on disk
-    indexSize = m_hash.LoadIndex(pFile);
+    indexSize = table->m_hash.LoadIndex(pFile);
 
+  table->m_coderOffset = std::ftell(pFile);
   size_t coderSize = m_phraseDecoder->Load(pFile);
+  m_coderLoaded = true;
 
   size_t phraseSize;
   if(m_inMemory)
     // Load target phrase collections into memory
-    phraseSize = m_targetPhrasesMemory.load(pFile, false);
+    phraseSize = table->m_targetPhrasesMemory.load(pFile, false);
   else
     // Keep target phrase collections on disk
-    phraseSize = m_targetPhrasesMapped.load(pFile, true);
+    phraseSize = table->m_targetPhrasesMapped.load(pFile, true);
 
   UTIL_THROW_IF2(indexSize == 0 || coderSize == 0 || phraseSize == 0,
 		  "Not successfully loaded");
+  return table.release();
 }
 
 // now properly declared in TargetPhraseCollection.h
@@ -183,7 +206,7 @@ void PhraseDictionaryCompact::AddEquivPhrase(const Phrase &source,
 void PhraseDictionaryCompact::CleanUpAfterSentenceProcessing(const InputType &source)
 {
   if(!m_inMemory)
-    m_hash.KeepNLastRanges(0.01, 0.2);
+    m_table->m_hash.KeepNLastRanges(0.01, 0.2);
 
   m_phraseDecoder->PruneCache();
 
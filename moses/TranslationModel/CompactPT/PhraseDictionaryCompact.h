@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_PhraseDictionaryCompact_h
 #define moses_PhraseDictionaryCompact_h
 
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
 #ifdef WITH_THREADS
@@ -60,13 +61,22 @@ protected:
 #endif
   SentenceCache m_sentenceCache;
 
-  BlockHashIndex m_hash;
-  PhraseDecoder* m_phraseDecoder;
+  //! source phrase index and target phrases, shared by all tables loaded from the same file
+  struct SharedTable {
+    SharedTable() : m_hash(10, 16), m_coderOffset(0) {}
 
-  StringVector<unsigned char, size_t, MmapAllocator>  m_targetPhrasesMapped;
-  StringVector<unsigned char, size_t, std::allocator> m_targetPhrasesMemory;
+    BlockHashIndex m_hash;
+    StringVector<unsigned char, size_t, MmapAllocator>  m_targetPhrasesMapped;
+    StringVector<unsigned char, size_t, std::allocator> m_targetPhrasesMemory;
+    long m_coderOffset; // the phrase coder is not shared, each table reads it from here
+  };
+  boost::shared_ptr<SharedTable> m_table;
+  PhraseDecoder* m_phraseDecoder;
+  bool m_coderLoaded;
 
   std::vector<float> m_weight;
+
+  SharedTable *LoadSharedTable(const std::string &filePath);
 public:
   PhraseDictionaryCompact(const std::string &line);
 
@@ -74,6 +84,11 @@ public:
 
   void Load();
 
+  //! nothing, phrases are only scored when they are decoded
+  std::vector<const FeatureFunction*> GetLoadDependencies() const {
+    return std::vector<const FeatureFunction*>();
+  }
+
   const TargetPhraseCollection* GetTargetPhraseCollectionNonCacheLEGACY(const Phrase &source) const;
   TargetPhraseVectorPtr GetTargetPhraseCollectionRaw(const Phrase &source) const;
 
@@ -33,13 +33,154 @@ namespace Moses
 {
 std::vector<PhraseDictionary*> PhraseDictionary::s_staticColl;
 
-CacheColl::~CacheColl()
+CacheColl::CacheColl()
 {
-	for (iterator iter = begin(); iter != end(); ++iter) {
-		std::pair<const TargetPhraseCollection*, clock_t> &key = iter->second;
-		const TargetPhraseCollection *tps = key.first;
-		delete tps;
-	}
+}
+
+bool CacheColl::Find(size_t hash, const TargetPhraseCollection *&ret)
+{
+  Shard &shard = GetShard(hash);
+  CollPtr coll;
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    boost::unordered_map<size_t, Entry>::iterator iter = shard.entries.find(hash);
+    if (iter == shard.entries.end()) {
+      ++shard.misses;
+      ++GetThreadData().misses;
+      return false;
+    }
+    ++shard.hits;
+    iter->second.referenced = true;
+    coll = iter->second.coll;
+  }
+  ThreadData &threadData = GetThreadData();
+  ++threadData.hits;
+  if (coll.get()) {
+    threadData.pins.push_back(coll);
+  }
+  ret = coll.get();
+  return true;
+}
+
+const TargetPhraseCollection *CacheColl::Insert(size_t hash, const TargetPhraseCollection *coll)
+{
+  Shard &shard = GetShard(hash);
+  CollPtr ptr(coll);
+  {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    std::pair<boost::unordered_map<size_t, Entry>::iterator, bool> ins
+      = shard.entries.insert(std::make_pair(hash, Entry()));
+    Entry &entry = ins.first->second;
+    if (ins.second) {
+      entry.coll = ptr;
+      entry.referenced = false;
+    } else {
+      // lost the race, ptr deletes our copy
+      ptr = entry.coll;
+    }
+  }
+  if (ptr.get()) {
+    GetThreadData().pins.push_back(ptr);
+  }
+  return ptr.get();
+}
+
+CacheColl::ThreadData &CacheColl::GetThreadData() const
+{
+#ifdef WITH_THREADS
+  ThreadData *ret = m_threadData.get();
+  if (ret == NULL) {
+    ret = new ThreadData;
+    m_threadData.reset(ret);
+  }
+  return *ret;
+#else
+  return m_threadData;
+#endif
+}
+
+void CacheColl::ReleasePins()
+{
+  GetThreadData().pins.clear();
+}
+
+void CacheColl::Reduce(size_t maxSize)
+{
+  // every shard gets an even share of the limit
+  const size_t shardMax = (maxSize + NumShards - 1) / NumShards;
+  const size_t shardTarget = shardMax / 2;
+  for (size_t i = 0; i < NumShards; ++i) {
+    Shard &shard = m_shards[i];
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(shard.mutex);
+#endif
+    boost::unordered_map<size_t, Entry> &entries = shard.entries;
+    if (entries.size() <= shardMax) continue;
+
+    // 1st sweep: unmark the recently used, drop the rest. If that's not
+    // enough, the 2nd sweep drops whatever it meets
+    for (size_t sweep = 0; sweep < 2 && entries.size() > shardTarget; ++sweep) {
+      boost::unordered_map<size_t, Entry>::iterator iter = entries.begin();
+      while (iter != entries.end() && entries.size() > shardTarget) {
+        if (iter->second.referenced) {
+          iter->second.referenced = false;
+          ++iter;
+        } else {
+          iter = entries.erase(iter);
+        }
+      }
+    }
+  }
+}
+
+size_t CacheColl::GetSize() const
+{
+  size_t ret = 0;
+  for (size_t i = 0; i < NumShards; ++i) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_shards[i].mutex);
+#endif
+    ret += m_shards[i].entries.size();
+  }
+  return ret;
+}
+
+size_t CacheColl::GetHits() const
+{
+  size_t ret = 0;
+  for (size_t i = 0; i < NumShards; ++i) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_shards[i].mutex);
+#endif
+    ret += m_shards[i].hits;
+  }
+  return ret;
+}
+
+size_t CacheColl::GetMisses() const
+{
+  size_t ret = 0;
+  for (size_t i = 0; i < NumShards; ++i) {
+#ifdef WITH_THREADS
+    boost::mutex::scoped_lock lock(m_shards[i].mutex);
+#endif
+    ret += m_shards[i].misses;
+  }
+  return ret;
+}
+
+size_t CacheColl::GetThreadHits() const
+{
+  return GetThreadData().hits;
+}
+
+size_t CacheColl::GetThreadMisses() const
+{
+  return GetThreadData().misses;
 }
 
 PhraseDictionary::PhraseDictionary(const std::string &line)
@@ -58,24 +199,13 @@ const TargetPhraseCollection *PhraseDictionary::GetTargetPhraseCollectionLEGACY(
 
     size_t hash = hash_value(src);
 
-    CacheColl::iterator iter;
-    iter = cache.find(hash);
-
-    if (iter == cache.end()) {
+    if (!cache.Find(hash, ret)) {
       // not in cache, need to look up from phrase table
       ret = GetTargetPhraseCollectionNonCacheLEGACY(src);
       if (ret) {
         ret = new TargetPhraseCollection(*ret);
       }
-
-      std::pair<const TargetPhraseCollection*, clock_t> value(ret, clock());
-      cache[hash] = value;
-    } else {
-      // in cache. just use it
-      std::pair<const TargetPhraseCollection*, clock_t> &value = iter->second;
-      value.second = clock();
-
-      ret = value.first;
+      ret = cache.Insert(hash, ret);
     }
   } else {
     // don't use cache. look up from phrase table
@@ -115,6 +245,21 @@ SetParameter(const std::string& key, const std::string& value)
   }
 }
 
+std::vector<const FeatureFunction*>
+PhraseDictionary::
+GetLoadDependencies() const
+{
+  std::vector<const FeatureFunction*> ret;
+  const std::vector<FeatureFunction*> &allFeatures = FeatureFunction::GetFeatureFunctions();
+  for (size_t i = 0; i < allFeatures.size(); ++i) {
+    const FeatureFunction *feature = allFeatures[i];
+    if (!dynamic_cast<const PhraseDictionary*>(feature)) {
+      ret.push_back(feature);
+    }
+  }
+  return ret;
+}
+
 void
 PhraseDictionary::
 SetFeaturesToApply()
@@ -168,48 +313,39 @@ GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
 //  }
 //}
 
+void PhraseDictionary::PrintCacheStats(std::ostream &out)
+{
+  for (size_t i = 0; i < s_staticColl.size(); ++i) {
+    const PhraseDictionary &pt = *s_staticColl[i];
+    size_t hits = pt.GetCacheHits();
+    size_t misses = pt.GetCacheMisses();
+    if (hits + misses) {
+      out << pt.GetScoreProducerDescription() << " translation option cache: "
+          << hits << " hits, " << misses << " misses" << std::endl;
+    }
+  }
+}
+
+void PhraseDictionary::GetThreadCacheStats(size_t &hits, size_t &misses)
+{
+  hits = misses = 0;
+  for (size_t i = 0; i < s_staticColl.size(); ++i) {
+    const CacheColl &cache = s_staticColl[i]->GetCache();
+    hits += cache.GetThreadHits();
+    misses += cache.GetThreadMisses();
+  }
+}
+
 // reduce presistent cache by half of maximum size
 void PhraseDictionary::ReduceCache() const
 {
   Timer reduceCacheTime;
   reduceCacheTime.start();
-  CacheColl &cache = GetCache();
-  if (cache.size() <= m_maxCacheSize) return; // not full
-
-  // find cutoff for last used time
-  priority_queue< clock_t > lastUsedTimes;
-  CacheColl::iterator iter;
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    lastUsedTimes.push( iter->second.second );
-    iter++;
-  }
-  for( size_t i=0; i < lastUsedTimes.size()-m_maxCacheSize/2; i++ )
-    lastUsedTimes.pop();
-  clock_t cutoffLastUsedTime = lastUsedTimes.top();
-
-  // remove all old entries
-  iter = cache.begin();
-  while( iter != cache.end() ) {
-    if (iter->second.second < cutoffLastUsedTime) {
-      CacheColl::iterator iterRemove = iter++;
-      delete iterRemove->second.first;
-      cache.erase(iterRemove);
-    } else iter++;
-  }
-  VERBOSE(2,"Reduced persistent translation option cache in " << reduceCacheTime << " seconds." << std::endl);
-}
-
-CacheColl &PhraseDictionary::GetCache() const
-{
-  CacheColl *cache;
-  cache = m_cache.get();
-  if (cache == NULL) {
-    cache = new CacheColl;
-    m_cache.reset(cache);
-  }
-  assert(cache);
-  return *cache;
+  m_cache.ReleasePins();
+  m_cache.Reduce(m_maxCacheSize);
+  VERBOSE(2,"Reduced persistent translation option cache in " << reduceCacheTime << " seconds. "
+          << GetScoreProducerDescription() << " cache: " << m_cache.GetHits() << " hits, "
+          << m_cache.GetMisses() << " misses" << std::endl);
 }
 
 } // namespace
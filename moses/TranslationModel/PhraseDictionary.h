@@ -30,13 +30,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <stdexcept>
 #include <vector>
 #include <string>
+#include <boost/shared_ptr.hpp>
 #include <boost/unordered_map.hpp>
 
 #ifdef WITH_THREADS
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/tss.hpp>
-#else
-#include <boost/scoped_ptr.hpp>
-#include <time.h>
 #endif
 
 #include "moses/Phrase.h"
@@ -55,14 +54,89 @@ class ChartCellCollectionBase;
 class ChartRuleLookupManager;
 class ChartParser;
 
-class CacheColl : public boost::unordered_map<size_t, std::pair<const TargetPhraseCollection*, clock_t> >
+/** Translation option cache of a phrase table, shared by all threads.
+ *
+ * Maps the hash of a source phrase (or the address of a phrase-table node)
+ * to all its translations. The entries are spread over shards with a lock
+ * each. Collections are reference counted: every lookup pins its
+ * collection for the calling thread until that thread calls ReleasePins(),
+ * so a collection evicted by one thread stays alive while another thread's
+ * sentence still uses it.
+ *
+ * Eviction is CLOCK-style. A hit marks the entry, and Reduce() gives marked
+ * entries a second chance while it drops the others.
+ */
+class CacheColl
 {
-// 1st = hash of source phrase/ address of phrase-table node
-// 2nd = all translations
-// 3rd = time of last access
-
 public:
-	~CacheColl();
+  CacheColl();
+
+  /** Look up the translations cached under hash. NULL is a valid entry
+   * (no translations), so the return value says whether there was one.
+   */
+  bool Find(size_t hash, const TargetPhraseCollection *&ret);
+
+  /** Cache coll, which is taken over. If another thread got there first,
+   * coll is deleted and the existing entry returned instead.
+   */
+  const TargetPhraseCollection *Insert(size_t hash, const TargetPhraseCollection *coll);
+
+  //! collections looked up by this thread may be freed from now on
+  void ReleasePins();
+
+  //! if there are more than maxSize entries, evict down to half of that
+  void Reduce(size_t maxSize);
+
+  size_t GetSize() const;
+  size_t GetHits() const;
+  size_t GetMisses() const;
+
+  //! lookups made by the calling thread so far
+  size_t GetThreadHits() const;
+  size_t GetThreadMisses() const;
+
+private:
+  typedef boost::shared_ptr<const TargetPhraseCollection> CollPtr;
+
+  struct Entry {
+    CollPtr coll;
+    bool referenced; /**< used since the last sweep */
+  };
+
+  struct Shard {
+    Shard() : hits(0), misses(0) {}
+    boost::unordered_map<size_t, Entry> entries;
+    size_t hits;
+    size_t misses;
+#ifdef WITH_THREADS
+    mutable boost::mutex mutex;
+#endif
+  };
+
+  static const size_t NumShards = 16;
+
+  Shard &GetShard(size_t hash) {
+    // spread out node addresses, which are aligned. The top 4 bits pick
+    // one of the 16 shards
+    return m_shards[(static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL) >> 60];
+  }
+
+  //! collections pinned by one thread, and what its lookups found
+  struct ThreadData {
+    ThreadData() : hits(0), misses(0) {}
+    std::vector<CollPtr> pins;
+    size_t hits;
+    size_t misses;
+  };
+
+  ThreadData &GetThreadData() const;
+
+  Shard m_shards[NumShards];
+#ifdef WITH_THREADS
+  mutable boost::thread_specific_ptr<ThreadData> m_threadData;
+#else
+  mutable ThreadData m_threadData;
+#endif
 };
 
 /**
@@ -80,6 +154,9 @@ public:
   virtual ~PhraseDictionary() {
   }
 
+  //! the features that are not phrase tables, as loading may score target phrases with them
+  virtual std::vector<const FeatureFunction*> GetLoadDependencies() const;
+
   //! table limit number.
   size_t GetTableLimit() const {
     return m_tableLimit;
@@ -122,6 +199,20 @@ public:
   void SetParameter(const std::string& key, const std::string& value);
 
 
+  //! translation option cache lookups, summed over all threads
+  size_t GetCacheHits() const {
+    return m_cache.GetHits();
+  }
+  size_t GetCacheMisses() const {
+    return m_cache.GetMisses();
+  }
+
+  //! hits and misses of every phrase table that used its cache
+  static void PrintCacheStats(std::ostream &out);
+
+  //! cache lookups of the calling thread, summed over all phrase tables
+  static void GetThreadCacheStats(size_t &hits, size_t &misses);
+
   // LEGACY
   //! find list of translations that can translates a portion of src. Used by confusion network decoding
   virtual const TargetPhraseCollectionWithSourcePhrase* GetTargetPhraseCollectionLEGACY(InputType const& src,WordsRange const& range) const;
@@ -142,18 +233,17 @@ protected:
   // cache
   size_t m_maxCacheSize; // 0 = no caching
 
-#ifdef WITH_THREADS
-  //reader-writer lock
-  mutable boost::thread_specific_ptr<CacheColl> m_cache;
-#else
-  mutable boost::scoped_ptr<CacheColl> m_cache;
-#endif
+  mutable CacheColl m_cache;
 
   virtual const TargetPhraseCollection *GetTargetPhraseCollectionNonCacheLEGACY(const Phrase& src) const;
+
+  //! call between sentences, in the thread that decoded the last one
   void ReduceCache() const;
 
 protected:
-  CacheColl &GetCache() const;
+  CacheColl &GetCache() const {
+    return m_cache;
+  }
 
 };
 
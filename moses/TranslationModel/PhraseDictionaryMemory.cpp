@@ -137,6 +137,7 @@ void PhraseDictionaryMemory::SortAndPrune()
   if (GetTableLimit()) {
     m_collection.Sort(GetTableLimit());
   }
+  m_collection.Freeze();
 }
 
 void
@@ -19,6 +19,8 @@ License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 
+#include <algorithm>
+#include <functional>
 #include "PhraseDictionaryNodeMemory.h"
 #include "moses/TargetPhrase.h"
 #include "moses/TranslationModel/PhraseDictionary.h"
@@ -28,6 +30,173 @@ using namespace std;
 namespace Moses
 {
 
+namespace
+{
+
+//! order of the terminal children, by factor pointer as in TerminalEqualityPred
+struct TerminalLess {
+  bool operator()(const Word &w1, const Word &w2) const {
+    for (size_t i = 0; i < MAX_NUM_FACTORS; ++i) {
+      const Factor *f1 = w1[i];
+      const Factor *f2 = w2[i];
+      if (f1 != f2) {
+        return std::less<const Factor*>()(f1, f2);
+      }
+    }
+    return false;
+  }
+};
+
+//! order of the non-terminal children, only the first factor is relevant
+struct NonTerminalLess {
+  bool operator()(const Word &w1, const Word &w2) const {
+    return std::less<const Factor*>()(w1[0], w2[0]);
+  }
+  bool operator()(const PhraseDictionaryNodeMemory::NonTerminalMapKey &k1,
+                  const PhraseDictionaryNodeMemory::NonTerminalMapKey &k2) const {
+    if (k1.first[0] != k2.first[0]) {
+      return std::less<const Factor*>()(k1.first[0], k2.first[0]);
+    }
+    return std::less<const Factor*>()(k1.second[0], k2.second[0]);
+  }
+};
+
+//! compares (key, child) pairs by key
+template <class Less>
+struct ChildLess {
+  template <class Pair>
+  bool operator()(const Pair &p1, const Pair &p2) const {
+    return Less()(*p1.first, *p2.first);
+  }
+  template <class Child, class Key>
+  bool operator()(const Child &child, const Key &key) const {
+    return Less()(child.first, key);
+  }
+};
+
+//! bisect the sorted children for key, NULL if there is no such child
+template <class Less, class Children, class Key>
+typename Children::value_type::second_type *FindChild(Children &children, const Key &key)
+{
+  typename Children::iterator p = std::lower_bound(children.begin(), children.end(), key, ChildLess<Less>());
+  if (p == children.end() || Less()(key, p->first)) {
+    return NULL;
+  }
+  return &p->second;
+}
+
+template <class Less, class Children, class Key>
+const typename Children::value_type::second_type *FindChild(const Children &children, const Key &key)
+{
+  typename Children::const_iterator p = std::lower_bound(children.begin(), children.end(), key, ChildLess<Less>());
+  if (p == children.end() || Less()(key, p->first)) {
+    return NULL;
+  }
+  return &p->second;
+}
+
+/** merge the children in added into the sorted array children. Every node
+ *  is swapped into its final slot exactly once, subtrees are never copied.
+ */
+template <class Less, class Key, class Map>
+void MergeChildren(Map &added, std::vector<std::pair<Key, PhraseDictionaryNodeMemory> > &children)
+{
+  typedef std::pair<Key, PhraseDictionaryNodeMemory> Child;
+  typedef std::pair<const Key*, PhraseDictionaryNodeMemory*> Entry;
+
+  std::vector<Entry> order;
+  order.reserve(children.size() + added.size());
+  for (typename std::vector<Child>::iterator p = children.begin(); p != children.end(); ++p) {
+    order.push_back(Entry(&p->first, &p->second));
+  }
+  for (typename Map::iterator p = added.begin(); p != added.end(); ++p) {
+    order.push_back(Entry(&p->first, &p->second));
+  }
+  std::sort(order.begin(), order.end(), ChildLess<Less>());
+
+  std::vector<Child> merged;
+  merged.reserve(order.size());
+  for (typename std::vector<Entry>::const_iterator p = order.begin(); p != order.end(); ++p) {
+    merged.push_back(Child(*p->first, PhraseDictionaryNodeMemory()));
+    merged.back().second.Swap(*p->second);
+  }
+  children.swap(merged);
+}
+
+}
+
+//! hash maps that collect new children until the next Freeze()
+struct PhraseDictionaryNodeMemory::Builder {
+#if defined(BOOST_VERSION) && (BOOST_VERSION >= 104200)
+  typedef boost::unordered_map<Word,
+          PhraseDictionaryNodeMemory,
+          TerminalHasher,
+          TerminalEqualityPred> TerminalMap;
+#else
+  typedef std::map<Word, PhraseDictionaryNodeMemory> TerminalMap;
+#endif
+
+#if defined(UNLABELLED_SOURCE)
+  // same equivalence as NonTerminalLess: the first factor only
+#if defined(BOOST_VERSION) && (BOOST_VERSION >= 104200)
+  typedef boost::unordered_map<Word,
+          PhraseDictionaryNodeMemory,
+          NonTerminalHasher,
+          NonTerminalEqualityPred> NonTerminalMap;
+#else
+  typedef std::map<Word, PhraseDictionaryNodeMemory, NonTerminalLess> NonTerminalMap;
+#endif
+#elif defined(BOOST_VERSION) && (BOOST_VERSION >= 104200)
+  typedef boost::unordered_map<NonTerminalMapKey,
+          PhraseDictionaryNodeMemory,
+          NonTerminalMapKeyHasher,
+          NonTerminalMapKeyEqualityPred> NonTerminalMap;
+#else
+  typedef std::map<NonTerminalMapKey, PhraseDictionaryNodeMemory> NonTerminalMap;
+#endif
+
+  TerminalMap m_sourceTermMap;
+  NonTerminalMap m_nonTermMap;
+};
+
+PhraseDictionaryNodeMemory::PhraseDictionaryNodeMemory(const PhraseDictionaryNodeMemory &copy)
+  :m_builder(copy.m_builder ? new Builder(*copy.m_builder) : NULL)
+  ,m_sourceTermMap(copy.m_sourceTermMap)
+  ,m_nonTermMap(copy.m_nonTermMap)
+  ,m_targetPhraseCollection(copy.m_targetPhraseCollection)
+{
+}
+
+PhraseDictionaryNodeMemory::~PhraseDictionaryNodeMemory()
+{
+  delete m_builder;
+}
+
+PhraseDictionaryNodeMemory &PhraseDictionaryNodeMemory::operator=(const PhraseDictionaryNodeMemory &copy)
+{
+  if (this != &copy) {
+    PhraseDictionaryNodeMemory tmp(copy);
+    Swap(tmp);
+  }
+  return *this;
+}
+
+void PhraseDictionaryNodeMemory::Swap(PhraseDictionaryNodeMemory &other)
+{
+  std::swap(m_builder, other.m_builder);
+  m_sourceTermMap.swap(other.m_sourceTermMap);
+  m_nonTermMap.swap(other.m_nonTermMap);
+  m_targetPhraseCollection.Swap(other.m_targetPhraseCollection);
+}
+
+PhraseDictionaryNodeMemory::Builder &PhraseDictionaryNodeMemory::GetBuilder()
+{
+  if (m_builder == NULL) {
+    m_builder = new Builder;
+  }
+  return *m_builder;
+}
+
 void PhraseDictionaryNodeMemory::Prune(size_t tableLimit)
 {
   // recusively prune
@@ -37,6 +206,14 @@ void PhraseDictionaryNodeMemory::Prune(size_t tableLimit)
   for (NonTerminalMap::iterator p = m_nonTermMap.begin(); p != m_nonTermMap.end(); ++p) {
     p->second.Prune(tableLimit);
   }
+  if (m_builder) {
+    for (Builder::TerminalMap::iterator p = m_builder->m_sourceTermMap.begin(); p != m_builder->m_sourceTermMap.end(); ++p) {
+      p->second.Prune(tableLimit);
+    }
+    for (Builder::NonTerminalMap::iterator p = m_builder->m_nonTermMap.begin(); p != m_builder->m_nonTermMap.end(); ++p) {
+      p->second.Prune(tableLimit);
+    }
+  }
 
   // prune TargetPhraseCollection in this node
   m_targetPhraseCollection.Prune(true, tableLimit);
@@ -51,14 +228,41 @@ void PhraseDictionaryNodeMemory::Sort(size_t tableLimit)
   for (NonTerminalMap::iterator p = m_nonTermMap.begin(); p != m_nonTermMap.end(); ++p) {
     p->second.Sort(tableLimit);
   }
+  if (m_builder) {
+    for (Builder::TerminalMap::iterator p = m_builder->m_sourceTermMap.begin(); p != m_builder->m_sourceTermMap.end(); ++p) {
+      p->second.Sort(tableLimit);
+    }
+    for (Builder::NonTerminalMap::iterator p = m_builder->m_nonTermMap.begin(); p != m_builder->m_nonTermMap.end(); ++p) {
+      p->second.Sort(tableLimit);
+    }
+  }
 
   // prune TargetPhraseCollection in this node
   m_targetPhraseCollection.Sort(true, tableLimit);
 }
 
+void PhraseDictionaryNodeMemory::Freeze()
+{
+  if (m_builder) {
+    MergeChildren<TerminalLess>(m_builder->m_sourceTermMap, m_sourceTermMap);
+    MergeChildren<NonTerminalLess>(m_builder->m_nonTermMap, m_nonTermMap);
+    delete m_builder;
+    m_builder = NULL;
+  }
+
+  // recursively freeze
+  for (TerminalMap::iterator p = m_sourceTermMap.begin(); p != m_sourceTermMap.end(); ++p) {
+    p->second.Freeze();
+  }
+  for (NonTerminalMap::iterator p = m_nonTermMap.begin(); p != m_nonTermMap.end(); ++p) {
+    p->second.Freeze();
+  }
+}
+
 PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetOrCreateChild(const Word &sourceTerm)
 {
-  return &m_sourceTermMap[sourceTerm];
+  PhraseDictionaryNodeMemory *child = FindChild<TerminalLess>(m_sourceTermMap, sourceTerm);
+  return child ? child : &GetBuilder().m_sourceTermMap[sourceTerm];
 }
 
 #if defined(UNLABELLED_SOURCE)
@@ -67,7 +271,8 @@ PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetOrCreateNonTerminalCh
   UTIL_THROW_IF2(!targetNonTerm.IsNonTerminal(),
                   "Not a non-terminal: " << targetNonTerm);
 
-  return &m_nonTermMap[targetNonTerm];
+  PhraseDictionaryNodeMemory *child = FindChild<NonTerminalLess>(m_nonTermMap, targetNonTerm);
+  return child ? child : &GetBuilder().m_nonTermMap[targetNonTerm];
 }
 #else
 PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetOrCreateChild(const Word &sourceNonTerm, const Word &targetNonTerm)
@@ -78,7 +283,8 @@ PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetOrCreateChild(const W
 		  "Not a non-terminal: " << targetNonTerm);
 
   NonTerminalMapKey key(sourceNonTerm, targetNonTerm);
-  return &m_nonTermMap[NonTerminalMapKey(sourceNonTerm, targetNonTerm)];
+  PhraseDictionaryNodeMemory *child = FindChild<NonTerminalLess>(m_nonTermMap, key);
+  return child ? child : &GetBuilder().m_nonTermMap[key];
 }
 #endif
 
@@ -87,8 +293,12 @@ const PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetChild(const Wor
   UTIL_THROW_IF2(sourceTerm.IsNonTerminal(),
 		  "Not a terminal: " << sourceTerm);
 
-  TerminalMap::const_iterator p = m_sourceTermMap.find(sourceTerm);
-  return (p == m_sourceTermMap.end()) ? NULL : &p->second;
+  const PhraseDictionaryNodeMemory *child = FindChild<TerminalLess>(m_sourceTermMap, sourceTerm);
+  if (child == NULL && m_builder) {
+    Builder::TerminalMap::const_iterator p = m_builder->m_sourceTermMap.find(sourceTerm);
+    child = (p == m_builder->m_sourceTermMap.end()) ? NULL : &p->second;
+  }
+  return child;
 }
 
 #if defined(UNLABELLED_SOURCE)
@@ -97,8 +307,12 @@ const PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetNonTerminalChil
   UTIL_THROW_IF2(!targetNonTerm.IsNonTerminal(),
                   "Not a non-terminal: " << targetNonTerm);
 
-  NonTerminalMap::const_iterator p = m_nonTermMap.find(targetNonTerm);
-  return (p == m_nonTermMap.end()) ? NULL : &p->second;
+  const PhraseDictionaryNodeMemory *child = FindChild<NonTerminalLess>(m_nonTermMap, targetNonTerm);
+  if (child == NULL && m_builder) {
+    Builder::NonTerminalMap::const_iterator p = m_builder->m_nonTermMap.find(targetNonTerm);
+    child = (p == m_builder->m_nonTermMap.end()) ? NULL : &p->second;
+  }
+  return child;
 }
 #else
 const PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetChild(const Word &sourceNonTerm, const Word &targetNonTerm) const
@@ -109,13 +323,19 @@ const PhraseDictionaryNodeMemory *PhraseDictionaryNodeMemory::GetChild(const Wor
 		  "Not a non-terminal: " << targetNonTerm);
 
   NonTerminalMapKey key(sourceNonTerm, targetNonTerm);
-  NonTerminalMap::const_iterator p = m_nonTermMap.find(key);
-  return (p == m_nonTermMap.end()) ? NULL : &p->second;
+  const PhraseDictionaryNodeMemory *child = FindChild<NonTerminalLess>(m_nonTermMap, key);
+  if (child == NULL && m_builder) {
+    Builder::NonTerminalMap::const_iterator p = m_builder->m_nonTermMap.find(key);
+    child = (p == m_builder->m_nonTermMap.end()) ? NULL : &p->second;
+  }
+  return child;
 }
 #endif
 
 void PhraseDictionaryNodeMemory::Remove()
 {
+  delete m_builder;
+  m_builder = NULL;
   m_sourceTermMap.clear();
   m_nonTermMap.clear();
   m_targetPhraseCollection.Remove();
@@ -91,36 +91,22 @@ public:
 };
 
 /** One node of the PhraseDictionaryMemory structure
+ *
+ * While a table is loaded, new children go into hash maps. Freeze() then
+ * moves them, without copying any subtree, into contiguous arrays sorted
+ * by label. Those need no per-child allocations or hash buckets and are
+ * searched by bisection. The lookup managers walk frozen tables only.
 */
 class PhraseDictionaryNodeMemory
 {
 public:
   typedef std::pair<Word, Word> NonTerminalMapKey;
 
-#if defined(BOOST_VERSION) && (BOOST_VERSION >= 104200)
-  typedef boost::unordered_map<Word,
-          PhraseDictionaryNodeMemory,
-          TerminalHasher,
-          TerminalEqualityPred> TerminalMap;
-
-#if defined(UNLABELLED_SOURCE)
-  typedef boost::unordered_map<Word,
-          PhraseDictionaryNodeMemory,
-          NonTerminalHasher,
-          NonTerminalEqualityPred> NonTerminalMap;
-#else
-  typedef boost::unordered_map<NonTerminalMapKey,
-          PhraseDictionaryNodeMemory,
-          NonTerminalMapKeyHasher,
-          NonTerminalMapKeyEqualityPred> NonTerminalMap;
-#endif
-#else
-  typedef std::map<Word, PhraseDictionaryNodeMemory> TerminalMap;
+  typedef std::vector<std::pair<Word, PhraseDictionaryNodeMemory> > TerminalMap;
 #if defined(UNLABELLED_SOURCE)
-  typedef std::map<Word, PhraseDictionaryNodeMemory> NonTerminalMap;
+  typedef std::vector<std::pair<Word, PhraseDictionaryNodeMemory> > NonTerminalMap;
 #else
-  typedef std::map<NonTerminalMapKey, PhraseDictionaryNodeMemory> NonTerminalMap;
-#endif
+  typedef std::vector<std::pair<NonTerminalMapKey, PhraseDictionaryNodeMemory> > NonTerminalMap;
 #endif
 
 private:
@@ -128,20 +114,34 @@ private:
   friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryScope3&);
   friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryFuzzyMatch&);
 
-  TerminalMap m_sourceTermMap;
-  NonTerminalMap m_nonTermMap;
+  struct Builder;
+
+  Builder *m_builder; /**< children added since the last Freeze(), NULL if there are none */
+  TerminalMap m_sourceTermMap; /**< sorted by TerminalLess */
+  NonTerminalMap m_nonTermMap; /**< sorted by NonTerminalLess */
   TargetPhraseCollection m_targetPhraseCollection;
 
+  Builder &GetBuilder();
 
 public:
-  PhraseDictionaryNodeMemory() {}
+  PhraseDictionaryNodeMemory()
+    :m_builder(NULL) {
+  }
+  PhraseDictionaryNodeMemory(const PhraseDictionaryNodeMemory &copy);
+  ~PhraseDictionaryNodeMemory();
+  PhraseDictionaryNodeMemory &operator=(const PhraseDictionaryNodeMemory &copy);
+
+  //! exchange the whole subtree with other without copying it
+  void Swap(PhraseDictionaryNodeMemory &other);
 
   bool IsLeaf() const {
-    return m_sourceTermMap.empty() && m_nonTermMap.empty();
+    return m_sourceTermMap.empty() && m_nonTermMap.empty() && m_builder == NULL;
   }
 
   void Prune(size_t tableLimit);
   void Sort(size_t tableLimit);
+  //! move the children of this subtree into sorted arrays, call once the table is loaded
+  void Freeze();
   PhraseDictionaryNodeMemory *GetOrCreateChild(const Word &sourceTerm);
   const PhraseDictionaryNodeMemory *GetChild(const Word &sourceTerm) const;
 #if defined(UNLABELLED_SOURCE)
@@ -159,10 +159,12 @@ public:
     return m_targetPhraseCollection;
   }
 
+  //! children with a terminal label, only complete after Freeze()
   const TerminalMap & GetTerminalMap() const {
     return m_sourceTermMap;
   }
 
+  //! children with a non-terminal label, only complete after Freeze()
   const NonTerminalMap & GetNonTerminalMap() const {
     return m_nonTermMap;
   }
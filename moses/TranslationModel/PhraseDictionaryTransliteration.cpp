@@ -59,13 +59,10 @@ void PhraseDictionaryTransliteration::GetTargetPhraseCollection(InputPath &input
 
     CacheColl &cache = GetCache();
 
-    CacheColl::iterator iter;
-    iter = cache.find(hash);
-
-    if (iter != cache.end()) {
+    const TargetPhraseCollection *cached;
+    if (cache.Find(hash, cached)) {
     	// already in cache
-    	const TargetPhraseCollection *tpColl = iter->second.first;
-    	inputPath.SetTargetPhrases(*this, tpColl, NULL);
+    	inputPath.SetTargetPhrases(*this, cached, NULL);
     }
     else {
         // TRANSLITERATE
@@ -98,10 +95,7 @@ void PhraseDictionaryTransliteration::GetTargetPhraseCollection(InputPath &input
     		tpColl->Add(tp);
     	}
 
-    	std::pair<const TargetPhraseCollection*, clock_t> value(tpColl, clock());
-    	cache[hash] = value;
-
-    	inputPath.SetTargetPhrases(*this, tpColl, NULL);
+    	inputPath.SetTargetPhrases(*this, cache.Insert(hash, tpColl), NULL);
 
     	// clean up temporary files
     	remove(inFile.c_str());
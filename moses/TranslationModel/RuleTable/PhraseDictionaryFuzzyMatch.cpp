@@ -365,6 +365,7 @@ void PhraseDictionaryFuzzyMatch::SortAndPrune(PhraseDictionaryNodeMemory &rootNo
   if (GetTableLimit()) {
     rootNode.Sort(GetTableLimit());
   }
+  rootNode.Freeze();
 }
 
 void PhraseDictionaryFuzzyMatch::CleanUpAfterSentenceProcessing(const InputType &source)
@@ -47,6 +47,26 @@ PhraseDictionaryOnDisk::~PhraseDictionaryOnDisk()
 void PhraseDictionaryOnDisk::Load()
 {
   SetFeaturesToApply();
+
+  OnDiskPt::OnDiskWrapper *obj = new OnDiskPt::OnDiskWrapper();
+  m_implementation.reset(obj);
+  obj->BeginLoad(m_filePath);
+
+  UTIL_THROW_IF2(obj->GetMisc("Version") != static_cast<UINT64>(OnDiskPt::OnDiskWrapper::VERSION_NUM),
+		  "On-disk phrase table is version " <<  obj->GetMisc("Version")
+		  << ". It is not compatible with version " << OnDiskPt::OnDiskWrapper::VERSION_NUM);
+
+  UTIL_THROW_IF2(obj->GetMisc("NumSourceFactors") != m_input.size(),
+		  "On-disk phrase table has " <<  obj->GetMisc("NumSourceFactors") << " source factors."
+		  		  << ". The ini file specified " << m_input.size() << " source factors");
+
+  UTIL_THROW_IF2(obj->GetMisc("NumTargetFactors") != m_output.size(),
+		  "On-disk phrase table has " <<  obj->GetMisc("NumTargetFactors") << " target factors."
+		  		  << ". The ini file specified " << m_output.size() << " target factors");
+
+  UTIL_THROW_IF2(obj->GetMisc("NumScores") != m_numScoreComponents,
+		  "On-disk phrase table has " <<  obj->GetMisc("NumScores") << " scores."
+		  		  << ". The ini file specified " << m_numScoreComponents << " scores");
 }
 
 ChartRuleLookupManager *PhraseDictionaryOnDisk::CreateRuleLookupManager(
@@ -64,7 +84,7 @@ OnDiskPt::OnDiskWrapper &PhraseDictionaryOnDisk::GetImplementation()
 {
   OnDiskPt::OnDiskWrapper* dict;
   dict = m_implementation.get();
-  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet created for this thread");
+  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet loaded");
   return *dict;
 }
 
@@ -72,36 +92,13 @@ const OnDiskPt::OnDiskWrapper &PhraseDictionaryOnDisk::GetImplementation() const
 {
   OnDiskPt::OnDiskWrapper* dict;
   dict = m_implementation.get();
-  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet created for this thread");
+  UTIL_THROW_IF2(dict == NULL, "Dictionary object not yet loaded");
   return *dict;
 }
 
 void PhraseDictionaryOnDisk::InitializeForInput(InputType const& source)
 {
-  const StaticData &staticData = StaticData::Instance();
-
   ReduceCache();
-
-  OnDiskPt::OnDiskWrapper *obj = new OnDiskPt::OnDiskWrapper();
-  obj->BeginLoad(m_filePath);
-
-  UTIL_THROW_IF2(obj->GetMisc("Version") != OnDiskPt::OnDiskWrapper::VERSION_NUM,
-		  "On-disk phrase table is version " <<  obj->GetMisc("Version")
-		  << ". It is not compatible with version " << OnDiskPt::OnDiskWrapper::VERSION_NUM);
-
-  UTIL_THROW_IF2(obj->GetMisc("NumSourceFactors") != m_input.size(),
-		  "On-disk phrase table has " <<  obj->GetMisc("NumSourceFactors") << " source factors."
-		  		  << ". The ini file specified " << m_input.size() << " source factors");
-
-  UTIL_THROW_IF2(obj->GetMisc("NumTargetFactors") != m_output.size(),
-		  "On-disk phrase table has " <<  obj->GetMisc("NumTargetFactors") << " target factors."
-		  		  << ". The ini file specified " << m_output.size() << " target factors");
-
-  UTIL_THROW_IF2(obj->GetMisc("NumScores") != m_numScoreComponents,
-		  "On-disk phrase table has " <<  obj->GetMisc("NumScores") << " scores."
-		  		  << ". The ini file specified " << m_numScoreComponents << " scores");
-
-  m_implementation.reset(obj);
 }
 
 void PhraseDictionaryOnDisk::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQueue) const
@@ -166,22 +163,9 @@ const TargetPhraseCollection *PhraseDictionaryOnDisk::GetTargetPhraseCollection(
   CacheColl &cache = GetCache();
   size_t hash = (size_t) ptNode->GetFilePos();
 
-  CacheColl::iterator iter;
-
-  iter = cache.find(hash);
-
-  if (iter == cache.end()) {
+  if (!cache.Find(hash, ret)) {
     // not in cache, need to look up from phrase table
-    ret = GetTargetPhraseCollectionNonCache(ptNode);
-
-    std::pair<const TargetPhraseCollection*, clock_t> value(ret, clock());
-    cache[hash] = value;
-  } else {
-    // in cache. just use it
-    std::pair<const TargetPhraseCollection*, clock_t> &value = iter->second;
-    value.second = clock();
-
-    ret = value.first;
+    ret = cache.Insert(hash, GetTargetPhraseCollectionNonCache(ptNode));
   }
 
   return ret;
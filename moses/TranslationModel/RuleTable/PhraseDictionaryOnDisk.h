@@ -29,11 +29,7 @@
 #include "OnDiskPt/Word.h"
 #include "OnDiskPt/PhraseNode.h"
 
-#ifdef WITH_THREADS
-#include <boost/thread/tss.hpp>
-#else
 #include <boost/scoped_ptr.hpp>
-#endif
 
 namespace Moses
 {
@@ -50,11 +46,8 @@ class PhraseDictionaryOnDisk : public PhraseDictionary
   friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryOnDisk&);
 
 protected:
-#ifdef WITH_THREADS
-  boost::thread_specific_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#else
+  //! loaded once and shared by all threads, lookups only read the mapped files
   boost::scoped_ptr<OnDiskPt::OnDiskWrapper> m_implementation;
-#endif
 
   OnDiskPt::OnDiskWrapper &GetImplementation();
   const OnDiskPt::OnDiskWrapper &GetImplementation() const;
@@ -66,6 +59,11 @@ public:
   ~PhraseDictionaryOnDisk();
   void Load();
 
+  //! nothing, rules are only scored when they are looked up
+  std::vector<const FeatureFunction*> GetLoadDependencies() const {
+    return std::vector<const FeatureFunction*>();
+  }
+
   PhraseTableImplementation GetPhraseTableImplementation() const {
     return OnDisk;
   }
@@ -37,10 +37,7 @@ void SkeletonPT::GetTargetPhraseCollectionBatch(const InputPathList &inputPathQu
 
     // add target phrase to phrase-table cache
     size_t hash = hash_value(sourcePhrase);
-	std::pair<const TargetPhraseCollection*, clock_t> value(tpColl, clock());
-	cache[hash] = value;
-
-    inputPath.SetTargetPhrases(*this, tpColl, NULL);
+    inputPath.SetTargetPhrases(*this, cache.Insert(hash, tpColl), NULL);
   }
 }
 
@@ -40,11 +40,41 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "moses/FF/InputFeature.h"
 #include "util/exception.hh"
 
+#ifdef WITH_THREADS
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/once.hpp>
+#include "ThreadPool.h"
+#endif
+
 using namespace std;
 
 namespace Moses
 {
 
+#ifdef WITH_THREADS
+namespace
+{
+boost::once_flag s_spanPoolOnce = BOOST_ONCE_INIT;
+boost::scoped_ptr<ThreadPool> s_spanPool;
+
+void CreateSpanPool()
+{
+  const size_t threads = StaticData::Instance().GetTransOptThreads();
+  if (threads > 1) {
+    s_spanPool.reset(new ThreadPool(threads));
+  }
+}
+
+//! threads that all sentences share to collect options span by span, NULL if there are none
+ThreadPool *GetSpanPool()
+{
+  boost::call_once(CreateSpanPool, s_spanPoolOnce);
+  return s_spanPool.get();
+}
+}
+#endif
+
 /** helper for pruning */
 bool CompareTranslationOption(const TranslationOption *a, const TranslationOption *b)
 {
@@ -375,6 +405,12 @@ void TranslationOptionCollection::CreateTranslationOptions()
   // length of the sentence
   const size_t size = m_source.GetSize();
 
+  // every span is filled by one job, so the options come out in the same
+  // order as when they are created one span after the other
+#ifdef WITH_THREADS
+  ThreadPool *pool = CanCreateSpansInParallel() ? GetSpanPool() : NULL;
+#endif
+
   // loop over all decoding graphs, each generates translation options
   for (size_t graphInd = 0 ; graphInd < decodeGraphList.size() ; graphInd++) {
     if (decodeGraphList.size() > 1) {
@@ -382,27 +418,21 @@ void TranslationOptionCollection::CreateTranslationOptions()
     }
 
     const DecodeGraph &decodeGraph = *decodeGraphList[graphInd];
-    size_t backoff = decodeGraph.GetBackoff();
     // generate phrases that start at startPos ...
-    for (size_t startPos = 0 ; startPos < size; startPos++) {
-      size_t maxSize = size - startPos; // don't go over end of sentence
-      size_t maxSizePhrase = StaticData::Instance().GetMaxPhraseLength();
-      maxSize = std::min(maxSize, maxSizePhrase);
-
-      // ... and that end at endPos
-      for (size_t endPos = startPos ; endPos < startPos + maxSize ; endPos++) {
-        if (graphInd > 0 && // only skip subsequent graphs
-        	backoff != 0 && // use of backoff specified
-            (endPos-startPos+1 >= backoff || // size exceeds backoff limit or ...
-             m_collection[startPos][endPos-startPos].size() > 0)) { // no phrases found so far
-          VERBOSE(3,"No backoff to graph " << graphInd << " for span [" << startPos << ";" << endPos << "]" << endl);
-          // do not create more options
-          continue;
-        }
-
-        // create translation options for that range
-        CreateTranslationOptionsForRange( decodeGraph, startPos, endPos, true, graphInd);
+#ifdef WITH_THREADS
+    if (pool) {
+      // backoff looks at the options of earlier graphs, so each graph waits for the one before
+      TaskGroup group(*pool);
+      for (size_t startPos = 0 ; startPos < size; startPos++) {
+        group.Submit(boost::bind(&TranslationOptionCollection::CreateTranslationOptionsForStartPos
+                                 , this, boost::cref(decodeGraph), graphInd, startPos));
       }
+      group.Wait();
+      continue;
+    }
+#endif
+    for (size_t startPos = 0 ; startPos < size; startPos++) {
+      CreateTranslationOptionsForStartPos(decodeGraph, graphInd, startPos);
     }
   }
 
@@ -410,7 +440,19 @@ void TranslationOptionCollection::CreateTranslationOptions()
 
   ProcessUnknownWord();
 
-  EvaluateWithSource();
+#ifdef WITH_THREADS
+  if (pool) {
+    TaskGroup group(*pool);
+    for (size_t startPos = 0 ; startPos < size; startPos++) {
+      group.Submit(boost::bind(&TranslationOptionCollection::EvaluateWithSourceForStartPos
+                               , this, startPos));
+    }
+    group.Wait();
+  } else
+#endif
+  {
+    EvaluateWithSource();
+  }
 
   // Prune
   Prune();
@@ -424,6 +466,32 @@ void TranslationOptionCollection::CreateTranslationOptions()
   CacheLexReordering();
 }
 
+void TranslationOptionCollection::CreateTranslationOptionsForStartPos(
+  const DecodeGraph &decodeGraph
+  , size_t graphInd
+  , size_t startPos)
+{
+  size_t backoff = decodeGraph.GetBackoff();
+  size_t maxSize = m_source.GetSize() - startPos; // don't go over end of sentence
+  size_t maxSizePhrase = StaticData::Instance().GetMaxPhraseLength();
+  maxSize = std::min(maxSize, maxSizePhrase);
+
+  // ... and that end at endPos
+  for (size_t endPos = startPos ; endPos < startPos + maxSize ; endPos++) {
+    if (graphInd > 0 && // only skip subsequent graphs
+        backoff != 0 && // use of backoff specified
+        (endPos-startPos+1 >= backoff || // size exceeds backoff limit or ...
+         m_collection[startPos][endPos-startPos].size() > 0)) { // no phrases found so far
+      VERBOSE(3,"No backoff to graph " << graphInd << " for span [" << startPos << ";" << endPos << "]" << endl);
+      // do not create more options
+      continue;
+    }
+
+    // create translation options for that range
+    CreateTranslationOptionsForRange( decodeGraph, startPos, endPos, true, graphInd);
+  }
+}
+
 void TranslationOptionCollection::CreateTranslationOptionsForRange(
   const DecodeGraph &decodeGraph
   , size_t startPos
@@ -539,18 +607,23 @@ void TranslationOptionCollection::EvaluateWithSource()
 {
   const size_t size = m_source.GetSize();
   for (size_t startPos = 0 ; startPos < size ; ++startPos) {
-    size_t maxSize = m_source.GetSize() - startPos;
-    size_t maxSizePhrase = StaticData::Instance().GetMaxPhraseLength();
-    maxSize = std::min(maxSize, maxSizePhrase);
+    EvaluateWithSourceForStartPos(startPos);
+  }
+}
 
-    for (size_t endPos = startPos ; endPos < startPos + maxSize ; ++endPos) {
-      TranslationOptionList &transOptList = GetTranslationOptionList(startPos, endPos);
+void TranslationOptionCollection::EvaluateWithSourceForStartPos(size_t startPos)
+{
+  size_t maxSize = m_source.GetSize() - startPos;
+  size_t maxSizePhrase = StaticData::Instance().GetMaxPhraseLength();
+  maxSize = std::min(maxSize, maxSizePhrase);
 
-      TranslationOptionList::const_iterator iterTransOpt;
-      for(iterTransOpt = transOptList.begin() ; iterTransOpt != transOptList.end() ; ++iterTransOpt) {
-        TranslationOption &transOpt = **iterTransOpt;
-        transOpt.Evaluate(m_source);
-      }
+  for (size_t endPos = startPos ; endPos < startPos + maxSize ; ++endPos) {
+    TranslationOptionList &transOptList = GetTranslationOptionList(startPos, endPos);
+
+    TranslationOptionList::const_iterator iterTransOpt;
+    for(iterTransOpt = transOptList.begin() ; iterTransOpt != transOptList.end() ; ++iterTransOpt) {
+      TranslationOption &transOpt = **iterTransOpt;
+      transOpt.Evaluate(m_source);
     }
   }
 }
@@ -97,6 +97,21 @@ protected:
   virtual void ProcessUnknownWord(size_t sourcePos)=0;
 
   void EvaluateWithSource();
+  //! EvaluateWithSource() for the spans starting at startPos
+  void EvaluateWithSourceForStartPos(size_t startPos);
+
+  //! create the options of one decoding graph for the spans starting at startPos
+  void CreateTranslationOptionsForStartPos(const DecodeGraph &decodeGraph
+      , size_t graphInd
+      , size_t startPos);
+
+  /** whether CreateTranslationOptionsForRange() may run for several spans
+   * at once (-transopt-threads). It must then only read shared state and
+   * only add options to its own span.
+   */
+  virtual bool CanCreateSpansInParallel() const {
+    return false;
+  }
 
   void CacheLexReordering();
 
@@ -149,6 +149,11 @@ void TranslationOptionCollectionConfusionNet::CreateTranslationOptions()
   TranslationOptionCollection::CreateTranslationOptions();
 }
 
+bool TranslationOptionCollectionConfusionNet::CanCreateSpansInParallel() const
+{
+  return !StaticData::Instance().GetUseLegacyPT();
+}
+
 
 /** create translation options that exactly cover a specific input span.
  * Called by CreateTranslationOptions() and ProcessUnknownWord()
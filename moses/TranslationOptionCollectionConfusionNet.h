@@ -34,6 +34,9 @@ protected:
       , bool adhereTableLimit
       , size_t graphInd);
 
+  //! the legacy path queries the phrase tables span by span
+  bool CanCreateSpansInParallel() const;
+
 public:
   TranslationOptionCollectionConfusionNet(const ConfusionNet &source, size_t maxNoTransOptPerCoverage, float translationOptionThreshold);
 
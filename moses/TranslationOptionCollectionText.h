@@ -45,6 +45,11 @@ protected:
 
   InputPath &GetInputPath(size_t startPos, size_t endPos);
 
+  //! the phrase tables are queried up front, spans only read their input paths
+  bool CanCreateSpansInParallel() const {
+    return true;
+  }
+
 public:
   void ProcessUnknownWord(size_t sourcePos);
 
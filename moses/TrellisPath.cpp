@@ -31,7 +31,7 @@ namespace Moses
 TrellisPath::TrellisPath(const Hypothesis *hypo)
   :	m_prevEdgeChanged(NOT_FOUND)
 {
-  m_scoreBreakdown					= hypo->GetScoreBreakdown();
+  hypo->AddScoreBreakdown(m_scoreBreakdown);
   m_totalScore = hypo->GetTotalScore();
 
   // enumerate path using prevHypo
@@ -44,7 +44,7 @@ TrellisPath::TrellisPath(const Hypothesis *hypo)
 void TrellisPath::InitScore()
 {
   m_totalScore		= m_path[0]->GetWinningHypo()->GetTotalScore();
-  m_scoreBreakdown= m_path[0]->GetWinningHypo()->GetScoreBreakdown();
+  m_scoreBreakdown.ZeroAll();
 
   //calc score
   size_t sizePath = m_path.size();
@@ -53,9 +53,9 @@ void TrellisPath::InitScore()
     const Hypothesis *winningHypo = hypo->GetWinningHypo();
     if (hypo != winningHypo) {
       m_totalScore = m_totalScore - winningHypo->GetTotalScore() + hypo->GetTotalScore();
-      m_scoreBreakdown.MinusEquals(winningHypo->GetScoreBreakdown());
-      m_scoreBreakdown.PlusEquals(hypo->GetScoreBreakdown());
     }
+    // the edges of the path add up to its scores
+    m_scoreBreakdown.PlusEquals(hypo->GetCurrScoreBreakdown());
   }
 
 
@@ -26,23 +26,27 @@ namespace Moses
 
 TO_STRING_BODY(WordsBitmap);
 
+const size_t WordsBitmap::BlockBits;
+const size_t WordsBitmap::InlineBlocks;
+const size_t WordsBitmap::InlineWords;
+
 int WordsBitmap::GetFutureCosts(int lastPos) const
 {
   int sum=0;
-  bool aim1=0,ai=0,aip1=m_bitmap[0];
+  bool aim1=0,ai=0,aip1=(m_size > 0 && GetValue(0));
 
   for(size_t i=0; i<m_size; ++i) {
     aim1 = ai;
     ai   = aip1;
-    aip1 = (i+1==m_size || m_bitmap[i+1]);
+    aip1 = (i+1==m_size || GetValue(i+1));
 
 #ifndef NDEBUG
     if( i>0 ) {
-      assert( aim1==(i==0||m_bitmap[i-1]==1));
+      assert( aim1==(i==0||GetValue(i-1)));
     }
 
     if( i+1<m_size ) {
-      assert( aip1==m_bitmap[i+1]);
+      assert( aip1==GetValue(i+1));
     }
 #endif
     if((i==0||aim1)&&ai==0) {
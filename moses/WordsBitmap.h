@@ -22,86 +22,154 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_WordsBitmap_h
 #define moses_WordsBitmap_h
 
+#include <algorithm>
 #include <limits>
 #include <vector>
 #include <iostream>
 #include <cstring>
 #include <cmath>
 #include <cstdlib>
+#include <boost/cstdint.hpp>
 #include "TypeDef.h"
 #include "WordsRange.h"
+#include "util/murmur_hash.hh"
 
 namespace Moses
 {
 typedef unsigned long WordsBitmapID;
 
-/** vector of boolean used to represent whether a word has been translated or not
+/** vector of boolean used to represent whether a word has been translated or not.
+ * Packed 64 words to a block; sentences of up to InlineWords words need no
+ * allocation. Bits past the sentence end are always 0.
 */
 class WordsBitmap
 {
   friend std::ostream& operator<<(std::ostream& out, const WordsBitmap& wordsBitmap);
+public:
+  typedef boost::uint64_t Block;
+  static const size_t BlockBits = 64;
+  static const size_t InlineBlocks = 4;
+  static const size_t InlineWords = InlineBlocks * BlockBits;
+
 protected:
   const size_t m_size; /**< number of words in sentence */
-  bool	*m_bitmap;	/**< ticks of words that have been done */
+  const size_t m_numBlocks;
+  Block	*m_bitmap;	/**< ticks of words that have been done, m_inline or a heap array */
+  Block m_inline[InlineBlocks];
 
   WordsBitmap(); // not implemented
+  WordsBitmap &operator=(const WordsBitmap&); // not implemented
+
+  static size_t NumBlocks(size_t size) {
+    return (size + BlockBits - 1) / BlockBits;
+  }
+
+  //! bits lo..hi of a block, inclusive
+  static Block BlockMask(size_t lo, size_t hi) {
+    return (~Block(0) >> (BlockBits - 1 - hi)) & (~Block(0) << lo);
+  }
+
+  //! words of the last block that are inside the sentence
+  Block LastBlockMask() const {
+    return BlockMask(0, (m_size - 1) % BlockBits);
+  }
+
+  static size_t CountBits(Block block) {
+#ifdef __GNUC__
+    return __builtin_popcountll(block);
+#else
+    size_t count = 0;
+    for (; block; block &= block - 1) ++count;
+    return count;
+#endif
+  }
+
+  //! index of the lowest set bit, block must not be 0
+  static size_t LowestBit(Block block) {
+#ifdef __GNUC__
+    return __builtin_ctzll(block);
+#else
+    size_t pos = 0;
+    for (; !(block & 1); block >>= 1) ++pos;
+    return pos;
+#endif
+  }
+
+  //! index of the highest set bit, block must not be 0
+  static size_t HighestBit(Block block) {
+#ifdef __GNUC__
+    return BlockBits - 1 - __builtin_clzll(block);
+#else
+    size_t pos = BlockBits - 1;
+    for (; !(block >> pos); --pos) {}
+    return pos;
+#endif
+  }
+
+  void Allocate() {
+    m_bitmap = (m_numBlocks <= InlineBlocks) ? m_inline : new Block[m_numBlocks];
+  }
 
   //! set all elements to false
   void Initialize() {
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      m_bitmap[pos] = false;
-    }
+    std::memset(m_bitmap, 0, m_numBlocks * sizeof(Block));
   }
 
   //sets elements by vector
-  void Initialize(std::vector<bool> vector) {
-    size_t vector_size = vector.size();
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (pos < vector_size && vector[pos] == true) m_bitmap[pos] = true;
-      else m_bitmap[pos] = false;
+  void Initialize(const std::vector<bool> &vector) {
+    Initialize();
+    size_t vector_size = std::min(vector.size(), m_size);
+    for (size_t pos = 0 ; pos < vector_size ; pos++) {
+      if (vector[pos]) SetValue(pos, true);
     }
   }
 
 
 public:
   //! create WordsBitmap of length size and initialise with vector
-  WordsBitmap(size_t size, std::vector<bool> initialize_vector)
-    :m_size	(size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * size);
+  WordsBitmap(size_t size, const std::vector<bool> &initialize_vector)
+    :m_size	(size)
+    ,m_numBlocks(NumBlocks(size)) {
+    Allocate();
     Initialize(initialize_vector);
   }
   //! create WordsBitmap of length size and initialise
   WordsBitmap(size_t size)
-    :m_size	(size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * size);
+    :m_size	(size)
+    ,m_numBlocks(NumBlocks(size)) {
+    Allocate();
     Initialize();
   }
   //! deep copy
   WordsBitmap(const WordsBitmap &copy)
-    :m_size	(copy.m_size) {
-    m_bitmap = (bool*) malloc(sizeof(bool) * m_size);
-    for (size_t pos = 0 ; pos < copy.m_size ; pos++) {
-      m_bitmap[pos] = copy.GetValue(pos);
-    }
+    :m_size	(copy.m_size)
+    ,m_numBlocks(copy.m_numBlocks) {
+    Allocate();
+    std::memcpy(m_bitmap, copy.m_bitmap, m_numBlocks * sizeof(Block));
   }
   ~WordsBitmap() {
-    free(m_bitmap);
+    if (m_bitmap != m_inline) {
+      delete [] m_bitmap;
+    }
   }
   //! count of words translated
   size_t GetNumWordsCovered() const {
     size_t count = 0;
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (m_bitmap[pos])
-        count++;
+    for (size_t i = 0 ; i < m_numBlocks ; i++) {
+      count += CountBits(m_bitmap[i]);
     }
     return count;
   }
 
   //! position of 1st word not yet translated, or NOT_FOUND if everything already translated
   size_t GetFirstGapPos() const {
-    for (size_t pos = 0 ; pos < m_size ; pos++) {
-      if (!m_bitmap[pos]) {
-        return pos;
+    for (size_t i = 0 ; i < m_numBlocks ; i++) {
+      Block gaps = ~m_bitmap[i];
+      if (i + 1 == m_numBlocks) {
+        gaps &= LastBlockMask();
+      }
+      if (gaps) {
+        return i * BlockBits + LowestBit(gaps);
       }
     }
     // no starting pos
@@ -111,9 +179,13 @@ public:
 
   //! position of last word not yet translated, or NOT_FOUND if everything already translated
   size_t GetLastGapPos() const {
-    for (int pos = (int) m_size - 1 ; pos >= 0 ; pos--) {
-      if (!m_bitmap[pos]) {
-        return pos;
+    for (size_t i = m_numBlocks ; i-- > 0 ; ) {
+      Block gaps = ~m_bitmap[i];
+      if (i + 1 == m_numBlocks) {
+        gaps &= LastBlockMask();
+      }
+      if (gaps) {
+        return i * BlockBits + HighestBit(gaps);
       }
     }
     // no starting pos
@@ -123,9 +195,9 @@ public:
 
   //! position of last translated word
   size_t GetLastPos() const {
-    for (int pos = (int) m_size - 1 ; pos >= 0 ; pos--) {
-      if (m_bitmap[pos]) {
-        return pos;
+    for (size_t i = m_numBlocks ; i-- > 0 ; ) {
+      if (m_bitmap[i]) {
+        return i * BlockBits + HighestBit(m_bitmap[i]);
       }
     }
     // no starting pos
@@ -136,26 +208,42 @@ public:
 
   //! whether a word has been translated at a particular position
   bool GetValue(size_t pos) const {
-    return m_bitmap[pos];
+    return (m_bitmap[pos / BlockBits] >> (pos % BlockBits)) & 1;
   }
   //! set value at a particular position
   void SetValue( size_t pos, bool value ) {
-    m_bitmap[pos] = value;
+    const Block bit = Block(1) << (pos % BlockBits);
+    if (value) {
+      m_bitmap[pos / BlockBits] |= bit;
+    } else {
+      m_bitmap[pos / BlockBits] &= ~bit;
+    }
   }
   //! set value between 2 positions, inclusive
   void SetValue( size_t startPos, size_t endPos, bool value ) {
-    for(size_t pos = startPos ; pos <= endPos ; pos++) {
-      m_bitmap[pos] = value;
+    const size_t first = startPos / BlockBits, last = endPos / BlockBits;
+    for (size_t i = first ; i <= last ; i++) {
+      const Block mask = BlockMask(i == first ? startPos % BlockBits : 0
+                                   , i == last ? endPos % BlockBits : BlockBits - 1);
+      if (value) {
+        m_bitmap[i] |= mask;
+      } else {
+        m_bitmap[i] &= ~mask;
+      }
     }
   }
   //! whether every word has been translated
   bool IsComplete() const {
-    return GetSize() == GetNumWordsCovered();
+    return GetFirstGapPos() == NOT_FOUND;
   }
   //! whether the wordrange overlaps with any translated word in this bitmap
   bool Overlap(const WordsRange &compare) const {
-    for (size_t pos = compare.GetStartPos() ; pos <= compare.GetEndPos() ; pos++) {
-      if (m_bitmap[pos])
+    const size_t startPos = compare.GetStartPos(), endPos = compare.GetEndPos();
+    const size_t first = startPos / BlockBits, last = endPos / BlockBits;
+    for (size_t i = first ; i <= last ; i++) {
+      const Block mask = BlockMask(i == first ? startPos % BlockBits : 0
+                                   , i == last ? endPos % BlockBits : BlockBits - 1);
+      if (m_bitmap[i] & mask)
         return true;
     }
     return false;
@@ -177,27 +265,49 @@ public:
     if (thisSize != compareSize) {
       return (thisSize < compareSize) ? -1 : 1;
     }
-    return std::memcmp(m_bitmap, compare.m_bitmap, thisSize * sizeof(bool));
+    // same order as comparing one bool per word: the first differing word decides
+    for (size_t i = 0 ; i < m_numBlocks ; i++) {
+      const Block diff = m_bitmap[i] ^ compare.m_bitmap[i];
+      if (diff) {
+        return (m_bitmap[i] & diff & (~diff + 1)) ? 1 : -1;
+      }
+    }
+    return 0;
   }
 
   bool operator< (const WordsBitmap &compare) const {
     return Compare(compare) < 0;
   }
 
+  //! hash consistent with Compare()
+  size_t hash() const {
+    return util::MurmurHashNative(m_bitmap, m_numBlocks * sizeof(Block), m_size);
+  }
+
+  //! first position of the gap that ends just before l
   inline size_t GetEdgeToTheLeftOf(size_t l) const {
     if (l == 0) return l;
-    while (l && !m_bitmap[l-1]) {
-      --l;
+    // translated words before l
+    size_t i = (l - 1) / BlockBits;
+    Block covered = m_bitmap[i] & BlockMask(0, (l - 1) % BlockBits);
+    while (!covered) {
+      if (i == 0) return 0;
+      covered = m_bitmap[--i];
     }
-    return l;
+    return i * BlockBits + HighestBit(covered) + 1;
   }
 
+  //! last position of the gap that starts just after r
   inline size_t GetEdgeToTheRightOf(size_t r) const {
-    if (r+1 == m_size) return r;
-    while (r+1 < m_size && !m_bitmap[r+1]) {
-      ++r;
+    if (r+1 >= m_size) return r;
+    // translated words after r
+    size_t i = (r + 1) / BlockBits;
+    Block covered = m_bitmap[i] & (~Block(0) << ((r + 1) % BlockBits));
+    while (!covered) {
+      if (++i == m_numBlocks) return m_size - 1;
+      covered = m_bitmap[i];
     }
-    return r;
+    return i * BlockBits + LowestBit(covered) - 1;
   }
 
 
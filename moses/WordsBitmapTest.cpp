@@ -0,0 +1,140 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "WordsBitmap.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+size_t FirstGap(const vector<bool> &ref)
+{
+  for (size_t pos = 0; pos < ref.size(); ++pos) {
+    if (!ref[pos]) return pos;
+  }
+  return NOT_FOUND;
+}
+
+size_t LastGap(const vector<bool> &ref)
+{
+  for (size_t pos = ref.size(); pos-- > 0; ) {
+    if (!ref[pos]) return pos;
+  }
+  return NOT_FOUND;
+}
+
+size_t LastPos(const vector<bool> &ref)
+{
+  for (size_t pos = ref.size(); pos-- > 0; ) {
+    if (ref[pos]) return pos;
+  }
+  return NOT_FOUND;
+}
+
+//! checks every query of bitmap against the same coverage held as one bool per word
+void CheckAgainst(const WordsBitmap &bitmap, const vector<bool> &ref)
+{
+  size_t covered = 0;
+  for (size_t pos = 0; pos < ref.size(); ++pos) {
+    BOOST_CHECK_EQUAL(bitmap.GetValue(pos), ref[pos]);
+    covered += ref[pos];
+  }
+  BOOST_CHECK_EQUAL(bitmap.GetNumWordsCovered(), covered);
+  BOOST_CHECK_EQUAL(bitmap.IsComplete(), covered == ref.size());
+  BOOST_CHECK_EQUAL(bitmap.GetFirstGapPos(), FirstGap(ref));
+  BOOST_CHECK_EQUAL(bitmap.GetLastGapPos(), LastGap(ref));
+  BOOST_CHECK_EQUAL(bitmap.GetLastPos(), LastPos(ref));
+
+  for (size_t pos = 0; pos < ref.size(); ++pos) {
+    size_t left = pos;
+    while (left && !ref[left - 1]) --left;
+    BOOST_CHECK_EQUAL(bitmap.GetEdgeToTheLeftOf(pos), left);
+    size_t right = pos;
+    while (right + 1 < ref.size() && !ref[right + 1]) ++right;
+    BOOST_CHECK_EQUAL(bitmap.GetEdgeToTheRightOf(pos), right);
+  }
+
+  for (size_t start = 0; start < ref.size(); start += 7) {
+    for (size_t end = start; end < ref.size(); end += 13) {
+      bool overlap = false;
+      for (size_t pos = start; pos <= end; ++pos) overlap |= ref[pos];
+      BOOST_CHECK_EQUAL(bitmap.Overlap(WordsRange(start, end)), overlap);
+    }
+  }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(words_bitmap)
+
+BOOST_AUTO_TEST_CASE(queries_match_unpacked_coverage)
+{
+  srand(1234);
+  const size_t sizes[] = {1, 5, 63, 64, 65, 200, WordsBitmap::InlineWords, WordsBitmap::InlineWords + 1, 700};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+    const size_t size = sizes[s];
+    WordsBitmap bitmap(size);
+    vector<bool> ref(size, false);
+    CheckAgainst(bitmap, ref);
+
+    for (size_t round = 0; round < 20; ++round) {
+      size_t start = rand() % size;
+      size_t end = start + rand() % (size - start);
+      bool value = rand() % 4 != 0;
+      bitmap.SetValue(start, end, value);
+      for (size_t pos = start; pos <= end; ++pos) ref[pos] = value;
+    }
+    CheckAgainst(bitmap, ref);
+
+    WordsBitmap copy(bitmap);
+    CheckAgainst(copy, ref);
+    BOOST_CHECK_EQUAL(copy.Compare(bitmap), 0);
+    BOOST_CHECK_EQUAL(copy.hash(), bitmap.hash());
+
+    bitmap.SetValue(0, size - 1, true);
+    ref.assign(size, true);
+    CheckAgainst(bitmap, ref);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(compare_orders_by_first_differing_word)
+{
+  vector<bool> init(300, false);
+  init[70] = true;
+  WordsBitmap a(300, init);
+  init[70] = false;
+  init[299] = true;
+  WordsBitmap b(300, init);
+  // a covers the earlier word
+  BOOST_CHECK_EQUAL(a.Compare(b), 1);
+  BOOST_CHECK_EQUAL(b.Compare(a), -1);
+  BOOST_CHECK(b < a);
+
+  WordsBitmap shorter(10);
+  BOOST_CHECK_EQUAL(shorter.Compare(a), -1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
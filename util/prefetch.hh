@@ -0,0 +1,20 @@
+#ifndef UTIL_PREFETCH__
+#define UTIL_PREFETCH__
+
+/* Software prefetch.  Hashed lookups in large models are dominated by cache
+ * misses; issuing the loads for a batch of queries before resolving any of
+ * them lets the misses overlap.
+ */
+
+namespace util {
+
+// Hint that address will be read soon.  No-op on compilers without a builtin.
+inline void PrefetchRead(const void *address) {
+#if defined(__GNUC__)
+  __builtin_prefetch(address, 0, 3);
+#endif
+}
+
+} // namespace util
+
+#endif // UTIL_PREFETCH__